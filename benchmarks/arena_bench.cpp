@@ -0,0 +1,120 @@
+#include "memory/expr_arena.h"
+#include "helpers/expr_helper.h"
+#include "bench_util.h"
+
+using namespace Expression;
+
+// Build and tear down a ~100k-node tree: one heap allocation per node vs. the bump-pointer arena.
+constexpr int kDepth = 16;  // 2^17 - 1 nodes
+
+// Balanced tree of + and * over x, y and constants, allocated through make(...).
+template<typename Make>
+static Node* buildTree(Make& make, int depth, int index) {
+    if (depth == 0) {
+        switch (index % 3) {
+        case 0: return make.template node<VariableNode>("x", std::size_t(0));
+        case 1: return make.template node<VariableNode>("y", std::size_t(1));
+        default: return make.template node<NumberNode>(0.5 + index % 7);
+        }
+    }
+    Node* left = buildTree(make, depth - 1, 2 * index);
+    Node* right = buildTree(make, depth - 1, 2 * index + 1);
+    if (depth % 2 == 0) {
+        return make.template node<AdditionNode>(left, right);
+    }
+    return make.template node<MultiplicationNode>(left, right);
+}
+
+// The previous ExprArena: new per node, delete per node.
+struct HeapMaker {
+    std::vector<Node*> nodes;
+    // Optionally interleave unrelated allocations between nodes, as in a long-running process.
+    bool interleaveNoise = false;
+    std::vector<std::unique_ptr<std::string>> noise;
+
+    template<typename T, typename... Args>
+    T* node(Args&&... args) {
+        T* n = new T(std::forward<Args>(args)...);
+        nodes.push_back(n);
+        if (interleaveNoise) {
+            noise.emplace_back(new std::string(40, 'n'));
+        }
+        return n;
+    }
+    ~HeapMaker() {
+        for (Node* n : nodes) {
+            delete n;
+        }
+    }
+};
+
+struct ArenaMaker {
+    ExprArena& arena;
+    template<typename T, typename... Args>
+    T* node(Args&&... args) {
+        return arena.make<T>(std::forward<Args>(args)...);
+    }
+};
+
+int main() {
+    Trace::setLevel(TraceLevel::Off);
+    const int rounds = 20;
+    const double slots[] = {1.25, 0.75};
+
+    double heapSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            HeapMaker maker;
+            Bench::doNotOptimize(buildTree(maker, kDepth, 0)->evaluate(slots));
+        }
+    });
+
+    double arenaSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            ExprArena arena;
+            ArenaMaker maker{arena};
+            Bench::doNotOptimize(buildTree(maker, kDepth, 0)->evaluate(slots));
+        }
+    });
+
+    ExprArena reused;
+    double resetSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            reused.reset();
+            ArenaMaker maker{reused};
+            Bench::doNotOptimize(buildTree(maker, kDepth, 0)->evaluate(slots));
+        }
+    });
+
+    std::printf("Build + evaluate + tear down a %d-node tree (%d rounds)\n", (1 << (kDepth + 1)) - 1, rounds);
+    Bench::report("new/delete per node", heapSeconds, rounds);
+    Bench::report("ExprArena, fresh per round", arenaSeconds, rounds);
+    Bench::report("ExprArena::reset per round", resetSeconds, rounds);
+
+    // Evaluation only: arena nodes are neighbours in memory, heap nodes are interleaved with noise.
+    HeapMaker heapMaker;
+    heapMaker.interleaveNoise = true;
+    Node* heapTree = buildTree(heapMaker, kDepth, 0);
+    ArenaMaker arenaMaker{reused};
+    reused.reset();
+    Node* arenaTree = buildTree(arenaMaker, kDepth, 0);
+
+    const int evaluations = 50;
+    double heapEval = Bench::timeSeconds([&] {
+        for (int i = 0; i < evaluations; ++i) {
+            Bench::doNotOptimize(heapTree->evaluate(slots));
+        }
+    });
+    double arenaEval = Bench::timeSeconds([&] {
+        for (int i = 0; i < evaluations; ++i) {
+            Bench::doNotOptimize(arenaTree->evaluate(slots));
+        }
+    });
+    std::printf("Evaluate the same tree (%d evaluations)\n", evaluations);
+    Bench::report("heap-allocated tree", heapEval, evaluations);
+    Bench::report("arena-allocated tree", arenaEval, evaluations);
+
+    std::printf("Arena statistics: %zu nodes, %zu bytes used, %zu bytes reserved in %zu chunks of %zu\n",
+                reused.getAllocationCount(), reused.getBytesUsed(), reused.getBytesReserved(),
+                reused.getChunkCount(), reused.getChunkSize());
+    return 0;
+}
@@ -0,0 +1,29 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <chrono>
+#include <cstdio>
+
+namespace Bench {
+
+// Run fn once and return the elapsed wall time in seconds.
+template<typename Fn>
+double timeSeconds(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+// Keep a value alive so the optimizer cannot drop the computation producing it.
+inline void doNotOptimize(double value) {
+    asm volatile("" : : "g"(value) : "memory");
+}
+
+inline void report(const char* label, double seconds, std::size_t iterations) {
+    std::printf("  %-32s %10.3f ms  %10.1f ns/iter\n", label, seconds * 1e3, seconds * 1e9 / iterations);
+}
+
+} // namespace Bench
+
+#endif
@@ -0,0 +1,205 @@
+#include "memory/expr_arena.h"
+#include "parser/parser.h"
+#include "compiler/jit_expr.h"
+#include "autodiff/gradient_tape.h"
+#include "bench_util.h"
+
+#include "rule_book_formulas.h"  // Generated from formulas/rule_book.expr by expr_codegen
+
+#include <random>
+
+using namespace Expression;
+
+// Formulas compiled ahead of time (rule_book_formulas, built by expr_add_formula_library)
+// against the tree walk and the JIT, per call. Each formula is also checked on inputs
+// chosen to hit its error paths: the generated code must return bit-identical values and
+// throw the same messages as Node::evaluate. The generated gradient is compared with
+// GradientTape and checked against the simplified symbolic partials it was emitted from.
+
+static double clampSum(const double* args) {
+    double sum = args[0] + args[1] + args[2];
+    if (sum < -50) {
+        throw std::runtime_error("clamp3: sum below -50");
+    }
+    return std::min(std::max(sum, -1.0), 1.0);
+}
+
+// Slope of clampSum with respect to any argument: 1 inside the clamp, 0 outside.
+static double clampSlope(const double* args) {
+    double sum = args[0] + args[1] + args[2];
+    if (sum < -50) {
+        throw std::runtime_error("clamp3: sum below -50");
+    }
+    return sum > -1 && sum < 1 ? 1.0 : 0.0;
+}
+
+double rule_book::clamp3(const double* args) {
+    return clampSum(args);
+}
+
+double rule_book::clamp3_d0(const double* args) {
+    return clampSlope(args);
+}
+
+double rule_book::clamp3_d2(const double* args) {
+    return clampSlope(args);
+}
+
+struct Formula {
+    const char* name;
+    std::vector<std::string> parameters;
+    const char* text;  // As in rule_book.expr
+    double (*generated)(const double*);
+    bool derivative;   // d/dx of the text
+};
+
+struct Outcome {
+    double value;
+    std::string error;
+};
+
+template <typename Fn>
+static Outcome run(Fn&& fn) {
+    try {
+        return {fn(), ""};
+    } catch (const std::exception& ex) {
+        return {0, ex.what()};
+    }
+}
+
+int main() {
+    Trace::setLevel(TraceLevel::Off);
+    ExprArena arena;
+    FunctionRegistry functions;
+    functions.add(
+        "clamp3", 3, [](const std::vector<double>& args) { return clampSum(args.data()); },
+        [](const std::vector<double>& args, std::size_t) { return clampSlope(args.data()); });
+    Parser parser(arena, &functions);
+
+    std::vector<Formula> formulas = {
+        {"example", {"x", "y"}, "(sin(x) + y) * log(2, x) / ln(y)", rule_book::example, false},
+        {"rational", {"x", "y"}, "(x*y + 3*x - y/2 + 1) / (x*x + y*y + 0.25) - (x - y) * (x + 2*y)",
+         rule_book::rational, false},
+        {"folded", {"x"}, "x * (2^10 - ln(8) / ln(2)) + sin(0.5) * cos(0.5) / x", rule_book::folded, false},
+        {"mixed", {"x", "y"}, "x^(y - 1) * clamp3(x, y, x*y) + ln(x*x + y) + log(y, 2 + x*x)", rule_book::mixed,
+         false},
+        {"example_dx", {"x", "y"}, "(sin(x) + y) * log(2, x) / ln(y)", rule_book::example_dx, true},
+        {"mixed_dx", {"x", "y"}, "x^(y - 1) * clamp3(x, y, x*y) + ln(x*x + y) + log(y, 2 + x*x)",
+         rule_book::mixed_dx, true},
+    };
+
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> wide(-4.0, 4.0);
+    const double special[] = {0.0, 1.0, -1.0, 2.0, 0.5};
+    const std::size_t iterations = 500000;
+    std::printf("%zu calls per formula, ns/call\n", iterations);
+    std::printf("  %-12s %10s %10s %10s %10s %12s\n", "formula", "tree", "jit", "generated", "speedup", "mismatches");
+    for (const Formula& formula : formulas) {
+        Node* tree = parser.parse(formula.text);
+        if (formula.derivative) {
+            tree = tree->derivative("x", arena)->simplify(arena);
+        }
+        JitExpr jit(tree);
+        std::vector<std::size_t> slotOf;
+        for (const std::string& parameter : formula.parameters) {
+            slotOf.push_back(arena.getSymbols().lookup(parameter));
+        }
+        std::vector<double> slots(arena.getSymbols().size()), vars(formula.parameters.size());
+        auto fill = [&](std::size_t i) {
+            for (std::size_t p = 0; p < vars.size(); ++p) {
+                vars[p] = slots[slotOf[p]] = 1.5 + 0.25 * p + 1e-6 * static_cast<double>(i);
+            }
+        };
+
+        double treeSeconds = Bench::timeSeconds([&] {
+            for (std::size_t i = 0; i < iterations; ++i) {
+                fill(i);
+                Bench::doNotOptimize(tree->evaluate(slots.data()));
+            }
+        });
+        double jitSeconds = Bench::timeSeconds([&] {
+            for (std::size_t i = 0; i < iterations; ++i) {
+                fill(i);
+                Bench::doNotOptimize(jit.evaluate(slots.data()));
+            }
+        });
+        double generatedSeconds = Bench::timeSeconds([&] {
+            for (std::size_t i = 0; i < iterations; ++i) {
+                fill(i);
+                Bench::doNotOptimize(formula.generated(vars.data()));
+            }
+        });
+
+        std::size_t mismatches = 0;
+        const std::size_t checks = 20000;
+        for (std::size_t i = 0; i < checks; ++i) {
+            for (std::size_t p = 0; p < vars.size(); ++p) {
+                vars[p] = slots[slotOf[p]] = rng() % 4 == 0 ? special[rng() % 5] : wide(rng);
+            }
+            Outcome expected = run([&] { return tree->evaluate(slots.data()); });
+            Outcome actual = run([&] { return formula.generated(vars.data()); });
+            if (expected.error != actual.error || std::memcmp(&expected.value, &actual.value, sizeof(double)) != 0) {
+                if (++mismatches <= 3) {
+                    std::printf("  mismatch: tree %.17g \"%s\", generated %.17g \"%s\"\n", expected.value,
+                                expected.error.c_str(), actual.value, actual.error.c_str());
+                }
+            }
+        }
+        double n = static_cast<double>(iterations);
+        std::printf("  %-12s %10.1f %10.1f %10.1f %9.1fx %7zu/%zu\n", formula.name, treeSeconds * 1e9 / n,
+                    jitSeconds * 1e9 / n, generatedSeconds * 1e9 / n, treeSeconds / generatedSeconds, mismatches,
+                    checks);
+    }
+
+    // Gradient of the potential: generated code vs. reverse mode on the tape.
+    const std::string potentialText =
+        "sin(x*y) + cos(y*z) + (x - z)^2 / (1 + y^2) + ln(1 + x^2 + z^2) * sin(x*y)";
+    Node* potential = parser.parse(potentialText);
+    const std::vector<std::string> xyz = {"x", "y", "z"};
+    std::vector<Node*> partials;
+    for (const std::string& variable : xyz) {
+        partials.push_back(potential->derivative(variable, arena)->simplify(arena));
+    }
+    GradientTape tape(potential);
+    std::vector<double> slots(arena.getSymbols().size()), tapeGradient(tape.getSlotCount());
+    double vars[3], generated[3];
+    auto fill = [&](std::size_t i) {
+        for (std::size_t p = 0; p < 3; ++p) {
+            vars[p] = slots[arena.getSymbols().lookup(xyz[p])] = 0.3 + 0.2 * p + 1e-6 * static_cast<double>(i);
+        }
+    };
+    double tapeSeconds = Bench::timeSeconds([&] {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            fill(i);
+            Bench::doNotOptimize(tape.evaluateGradient(slots.data(), tapeGradient.data()));
+        }
+    });
+    double generatedSeconds = Bench::timeSeconds([&] {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            fill(i);
+            rule_book::potential_grad(vars, generated);
+            Bench::doNotOptimize(generated[0] + generated[1] + generated[2]);
+        }
+    });
+    std::size_t symbolicMismatches = 0;
+    double maxTapeDiff = 0;
+    for (std::size_t i = 0; i < 20000; ++i) {
+        for (std::size_t p = 0; p < 3; ++p) {
+            vars[p] = slots[arena.getSymbols().lookup(xyz[p])] = wide(rng);
+        }
+        rule_book::potential_grad(vars, generated);
+        tape.evaluateGradient(slots.data(), tapeGradient.data());
+        for (std::size_t p = 0; p < 3; ++p) {
+            double symbolic = partials[p]->evaluate(slots.data());
+            symbolicMismatches += std::memcmp(&symbolic, &generated[p], sizeof(double)) != 0;
+            double tapeValue = tapeGradient[arena.getSymbols().lookup(xyz[p])];
+            maxTapeDiff = std::max(maxTapeDiff, std::fabs(tapeValue - generated[p]) / std::max(1.0, std::fabs(tapeValue)));
+        }
+    }
+    std::printf("Gradient of the potential (x, y, z):\n");
+    Bench::report("GradientTape::evaluateGradient", tapeSeconds, iterations);
+    Bench::report("generated potential_grad", generatedSeconds, iterations);
+    std::printf("  speedup %.1fx; %zu/60000 partials differ from the symbolic trees, max relative diff to tape %.3g\n",
+                tapeSeconds / generatedSeconds, symbolicMismatches, maxTapeDiff);
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "memory/expr_arena.h"
+#include "helpers/expr_helper.h"
+#include "compiler/compiled_expr.h"
+#include "bench_util.h"
+
+#include <cstring>
+
+using namespace Expression;
+
+// Tree walk vs. flat bytecode on the evaluation example from main.cpp and on a wider polynomial.
+static Node* buildExample(ExprHelper& e) {
+    // (sin(x) + y) * log_2(x) / ln(y)
+    return e.div(
+        e.mul(
+            e.add(e.sin(e.var("x")), e.var("y")),
+            e.log(e.num(2), e.var("x"))
+        ),
+        e.ln(e.var("y"))
+    );
+}
+
+static Node* buildPolynomial(ExprHelper& e, int terms) {
+    // sum_k c_k * x^k * cos(y)
+    Node* sum = e.num(0);
+    for (int k = 1; k <= terms; ++k) {
+        sum = e.add(sum, e.mul(e.mul(e.num(0.5 * k), e.exp(e.var("x"), e.num(k))), e.cos(e.var("y"))));
+    }
+    return sum;
+}
+
+static Node* buildWideSum(ExprHelper& e, int variables) {
+    // sum_k v_k * v_{k+1}: string hashing dominates the Env path
+    Node* sum = e.num(0);
+    for (int k = 0; k < variables; ++k) {
+        sum = e.add(sum, e.mul(e.var("v" + std::to_string(k)), e.var("v" + std::to_string((k + 1) % variables))));
+    }
+    return sum;
+}
+
+static void fillEnv(Env& env, const SymbolTable& symbols, double offset) {
+    for (std::size_t slot = 0; slot < symbols.size(); ++slot) {
+        env[symbols.nameOf(slot)] = 1.5 + slot + offset;
+    }
+}
+
+static void runComparison(const char* name, Node* expr, const SymbolTable& symbols, std::size_t iterations) {
+    CompiledExpr compiled(expr);
+    std::printf("%s: %zu instructions, max stack %zu\n", name, compiled.getCode().size(), compiled.getMaxStackDepth());
+
+    Env env;
+    std::size_t mismatches = 0;
+    double treeSeconds = Bench::timeSeconds([&] {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            fillEnv(env, symbols, 1e-6 * i);
+            Bench::doNotOptimize(expr->evaluate(env));
+            if (i % 256 == 0) {
+                Trace::clear();
+            }
+        }
+    });
+    Trace::clear();
+
+    double compiledSeconds = Bench::timeSeconds([&] {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            fillEnv(env, symbols, 1e-6 * i);
+            Bench::doNotOptimize(compiled.evaluate(env));
+        }
+    });
+
+    // Slots are bound once up front; only the values change per iteration.
+    std::vector<double> slots(symbols.size());
+    double slotSeconds = Bench::timeSeconds([&] {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            for (std::size_t slot = 0; slot < slots.size(); ++slot) {
+                slots[slot] = 1.5 + slot + 1e-6 * i;
+            }
+            Bench::doNotOptimize(compiled.evaluate(slots.data()));
+        }
+    });
+
+    for (std::size_t i = 0; i < 1000; ++i) {
+        fillEnv(env, symbols, 1e-3 * i);
+        std::vector<double> bound = symbols.bind(env);
+        double treeValue = expr->evaluate(env);
+        double values[] = {expr->evaluate(bound.data()), compiled.evaluate(env), compiled.evaluate(bound.data())};
+        for (double value : values) {
+            if (std::memcmp(&treeValue, &value, sizeof(double)) != 0) {
+                ++mismatches;
+            }
+        }
+    }
+    Trace::clear();
+
+    Bench::report("Node::evaluate(Env)", treeSeconds, iterations);
+    Bench::report("CompiledExpr::evaluate(Env)", compiledSeconds, iterations);
+    Bench::report("CompiledExpr::evaluate(slots)", slotSeconds, iterations);
+    std::printf("  speedup %.1fx (Env), %.1fx (slots), bit mismatches %zu/3000\n\n",
+                treeSeconds / compiledSeconds, treeSeconds / slotSeconds, mismatches);
+}
+
+int main() {
+    ExprArena arena;
+    ExprHelper e(arena);
+
+    runComparison("Evaluation example", buildExample(e), arena.getSymbols(), 50000);
+    runComparison("Polynomial (16 terms)", buildPolynomial(e, 16), arena.getSymbols(), 2000);
+
+    ExprArena wideArena;
+    ExprHelper wide(wideArena);
+    runComparison("Wide sum (64 variables)", buildWideSum(wide, 64), wideArena.getSymbols(), 2000);
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include "memory/expr_arena.h"
+#include "helpers/expr_helper.h"
+#include "compiler/compiled_expr.h"
+#include "compiler/cse_pass.h"
+#include "bench_util.h"
+
+#include <cstring>
+
+using namespace Expression;
+
+// Common subexpression elimination on the derivative example from main.cpp, d^n/dx^n (x^2 * sin(x)).
+static void runOrder(ExprArena& arena, Node* expr, int order, std::size_t iterations) {
+    CsePass cse(expr);
+    CompiledExpr plain(expr, CompileOptions{false});
+    CompiledExpr shared(expr, CompileOptions{true});
+
+    std::vector<double> slots = arena.getSymbols().bind({{"x", 0.0}});
+    std::size_t mismatches = 0;
+    auto timeIt = [&](auto&& evaluate) {
+        return Bench::timeSeconds([&] {
+            for (std::size_t i = 0; i < iterations; ++i) {
+                slots[0] = 0.5 + 1e-6 * i;
+                Bench::doNotOptimize(evaluate());
+            }
+        });
+    };
+    double treeSeconds = timeIt([&] { return expr->evaluate(slots.data()); });
+    double plainSeconds = timeIt([&] { return plain.evaluate(slots.data()); });
+    double sharedSeconds = timeIt([&] { return shared.evaluate(slots.data()); });
+
+    for (int i = 0; i < 100; ++i) {
+        slots[0] = 0.1 + 0.05 * i;
+        double expected = expr->evaluate(slots.data());
+        double actual = shared.evaluate(slots.data());
+        mismatches += std::memcmp(&expected, &actual, sizeof(double)) != 0;
+    }
+
+    std::printf("Order %d: %llu tree nodes, %zu unique, %llu eliminated, %zu temps, %zu vs %zu instructions\n",
+                order, static_cast<unsigned long long>(cse.getTreeNodeCount()), cse.getUniqueCount(),
+                static_cast<unsigned long long>(shared.getEliminatedNodeCount()), shared.getTempCount(),
+                shared.getCode().size(), plain.getCode().size());
+    Bench::report("Node::evaluate", treeSeconds, iterations);
+    Bench::report("CompiledExpr without CSE", plainSeconds, iterations);
+    Bench::report("CompiledExpr with CSE", sharedSeconds, iterations);
+    if (shared.getEliminatedNodeCount() == 0) {
+        // Both programs are the same code: any difference in time is noise.
+        std::printf("  CSE did not apply, bit mismatches %zu/100\n\n", mismatches);
+    } else {
+        std::printf("  time saved by CSE %.1f%% (%.1fx), bit mismatches %zu/100\n\n",
+                    100.0 * (plainSeconds - sharedSeconds) / plainSeconds, plainSeconds / sharedSeconds, mismatches);
+    }
+}
+
+int main() {
+    Trace::setLevel(TraceLevel::Off);
+    ExprArena arena;
+    ExprHelper e(arena);
+
+    Node* expr = e.mul(e.exp(e.var("x"), e.num(2)), e.sin(e.var("x")));
+    for (int order = 1; order <= 5; ++order) {
+        expr = expr->derivative("x", arena);
+        runOrder(arena, expr, order, order <= 3 ? 100000 : 10000);
+    }
+
+    // The simplified first derivative printed by main.cpp.
+    Node* simplified = e.mul(e.exp(e.var("x"), e.num(2)), e.sin(e.var("x")))->derivative("x", arena)->simplify(arena);
+    runOrder(arena, simplified, 1, 100000);
+    return 0;
+}
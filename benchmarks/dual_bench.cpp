@@ -0,0 +1,115 @@
+#include "memory/expr_arena.h"
+#include "helpers/expr_helper.h"
+#include "autodiff/dual_evaluator.h"
+#include "autodiff/gradient_tape.h"
+#include "bench_util.h"
+
+using namespace Expression;
+
+// Forward-mode duals: one directional derivative against derivative() + evaluate(), and
+// all 100 partials with 1 vs kDualLaneCount tangent lanes per sweep, checked against
+// GradientTape. The objective includes a user function with a derivative callback.
+
+static std::string param(int i) {
+    return "p" + std::to_string(i);
+}
+
+static Node* buildObjective(ExprHelper& e, int params, bool withFunction) {
+    auto hypot = [](const std::vector<double>& args) { return std::hypot(args[0], args[1]); };
+    auto hypotPartial = [](const std::vector<double>& args, std::size_t index) {
+        return args[index] / std::hypot(args[0], args[1]);
+    };
+    Node* sum = e.num(0);
+    for (int i = 0; i + 1 < params; ++i) {
+        Node* p = e.var(param(i));
+        Node* q = e.var(param(i + 1));
+        Node* term = e.add(e.sin(e.mul(p, q)), e.div(e.ln(e.add(e.num(1), e.exp(p, e.num(2)))), e.add(e.num(2), q)));
+        term = e.add(term, e.exp(e.add(e.num(1.5), e.mul(p, p)), e.mul(e.num(0.5), q)));
+        term = e.add(term, e.log(e.add(e.num(2), e.mul(q, q)), e.add(e.num(3), p)));
+        if (withFunction) {
+            term = e.add(term, e.func("hypot", 2, {p, q}, hypot, hypotPartial));
+        }
+        sum = e.add(sum, term);
+    }
+    return sum;
+}
+
+int main() {
+    Trace::setLevel(TraceLevel::Off);
+    const int params = 100;
+
+    ExprArena arena;
+    ExprHelper e(arena);
+    Node* plain = buildObjective(e, params, false);
+    Node* withFunction = buildObjective(e, params, true);
+
+    std::vector<double> slots(arena.getSymbols().size());
+    for (int i = 0; i < params; ++i) {
+        slots[arena.getSymbols().lookup(param(i))] = 0.3 + 0.01 * i;
+    }
+    Env env;
+    for (int i = 0; i < params; ++i) {
+        env[param(i)] = slots[arena.getSymbols().lookup(param(i))];
+    }
+
+    // One partial derivative: symbolic tree + evaluate vs a single dual sweep.
+    const int target = 37;
+    const int rounds = 50;
+    ExprArena scratch;
+    double symbolic = 0;
+    double symbolicSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            scratch.reset();
+            symbolic = plain->derivative(param(target), scratch)->evaluate(env);
+        }
+    });
+    DualEvaluator dual(plain);
+    std::vector<double> direction(dual.getSlotCount(), 0.0);
+    direction[arena.getSymbols().lookup(param(target))] = 1.0;
+    Dual result{};
+    double dualSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            result = dual.evaluateDual(slots.data(), direction.data());
+        }
+    });
+    std::printf("d/d%s of a %d-parameter objective\n", param(target).c_str(), params);
+    Bench::report("derivative() + evaluate()", symbolicSeconds, rounds);
+    Bench::report("evaluateDual", dualSeconds, rounds);
+    std::printf("  symbolic %.15g, dual %.15g, speedup %.0fx\n", symbolic, result.tangent,
+                symbolicSeconds / dualSeconds);
+
+    // Every partial of the objective with the user function, 1 lane vs kDualLaneCount lanes.
+    DualEvaluator functionDual(withFunction);
+    GradientTape tape(withFunction);
+    const std::size_t slotCount = functionDual.getSlotCount();
+    std::vector<double> reference(slotCount), lanePartials(slotCount), singlePartials(slotCount);
+    tape.evaluateGradient(slots.data(), reference.data());
+
+    double laneSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            functionDual.evaluatePartials(slots.data(), lanePartials.data());
+        }
+    });
+    std::vector<double> seed(slotCount, 0.0);
+    double singleSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            for (std::size_t s = 0; s < slotCount; ++s) {
+                seed[s] = 1.0;
+                singlePartials[s] = functionDual.evaluateDual(slots.data(), seed.data()).tangent;
+                seed[s] = 0.0;
+            }
+        }
+    });
+    double maxError = 0;
+    for (std::size_t s = 0; s < slotCount; ++s) {
+        double scale = std::max(1.0, std::fabs(reference[s]));
+        maxError = std::max(maxError, std::fabs(lanePartials[s] - reference[s]) / scale);
+        maxError = std::max(maxError, std::fabs(singlePartials[s] - reference[s]) / scale);
+    }
+    std::printf("All %zu partials (objective with a hypot callback)\n", slotCount);
+    Bench::report("1 lane per sweep", singleSeconds, rounds);
+    Bench::report("16 lanes per sweep", laneSeconds, rounds);
+    std::printf("  lane speedup %.1fx, max relative error vs GradientTape %.3g\n",
+                singleSeconds / laneSeconds, maxError);
+    return 0;
+}
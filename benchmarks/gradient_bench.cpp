@@ -0,0 +1,105 @@
+#include "memory/expr_arena.h"
+#include "helpers/expr_helper.h"
+#include "autodiff/gradient_tape.h"
+#include "bench_util.h"
+
+using namespace Expression;
+
+// Full gradient over 200 parameters: symbolic derivative() + evaluate per variable,
+// against one forward and one backward sweep of a GradientTape.
+
+static std::string param(int i) {
+    return "p" + std::to_string(i);
+}
+
+// Chained terms so every parameter interacts with its neighbour, with every operator
+// the tape handles, including a power with a variable exponent and a variable log base.
+static Node* buildObjective(ExprHelper& e, int params) {
+    Node* sum = e.num(0);
+    for (int i = 0; i + 1 < params; ++i) {
+        Node* p = e.var(param(i));
+        Node* q = e.var(param(i + 1));
+        Node* term = e.add(e.sin(e.mul(p, q)), e.mul(e.ln(e.add(e.num(1), e.exp(p, e.num(2)))), e.cos(p)));
+        term = e.add(term, e.div(p, e.add(e.num(2), e.exp(q, e.num(2)))));
+        if (i % 10 == 0) {
+            term = e.add(term, e.exp(e.add(e.num(1.5), e.exp(p, e.num(2))), e.mul(e.num(0.5), q)));
+            term = e.sub(term, e.log(e.add(e.num(2), e.exp(q, e.num(2))), e.add(e.num(3), p)));
+        }
+        sum = e.add(sum, term);
+    }
+    return sum;
+}
+
+int main() {
+    Trace::setLevel(TraceLevel::Off);
+    const int params = 200;
+
+    ExprArena arena;
+    ExprHelper e(arena);
+    Node* objective = buildObjective(e, params);
+
+    Env env;
+    for (int i = 0; i < params; ++i) {
+        env[param(i)] = 0.3 + 0.01 * i;
+    }
+
+    // Symbolic: one derivative tree per parameter, each evaluated once.
+    ExprArena symbolicArena;
+    std::vector<double> symbolic(params);
+    double symbolicSeconds = Bench::timeSeconds([&] {
+        symbolicArena.reset();
+        for (int i = 0; i < params; ++i) {
+            symbolic[i] = objective->derivative(param(i), symbolicArena)->evaluate(env);
+        }
+    });
+    std::printf("Symbolic derivative() + evaluate for %d parameters\n", params);
+    Bench::report("total", symbolicSeconds, 1);
+    std::printf("  %zu derivative nodes built\n", symbolicArena.getAllocationCount());
+
+    // Reverse mode: one tape, one forward and one backward sweep.
+    Env gradient;
+    GradientTape* tape = nullptr;
+    double buildSeconds = Bench::timeSeconds([&] { tape = new GradientTape(objective); });
+    double value = 0;
+    double tapeSeconds = Bench::timeSeconds([&] { value = tape->evaluateGradient(env, gradient); });
+    std::printf("GradientTape (%zu entries)\n", tape->getTapeLength());
+    Bench::report("build", buildSeconds, 1);
+    Bench::report("value + gradient", tapeSeconds, 1);
+
+    double maxError = 0;
+    for (int i = 0; i < params; ++i) {
+        double error = std::fabs(gradient[param(i)] - symbolic[i]) / std::max(1.0, std::fabs(symbolic[i]));
+        maxError = std::max(maxError, error);
+    }
+    std::printf("  value %.12g (evaluate: %.12g)\n", value, objective->evaluate(env));
+    std::printf("  max relative gradient error vs symbolic: %.3g\n", maxError);
+    std::printf("  speedup over symbolic: %.0fx (%.0fx including tape construction)\n",
+                symbolicSeconds / tapeSeconds, symbolicSeconds / (tapeSeconds + buildSeconds));
+
+    // Steady state: repeated gradients at changing points against plain compiled evaluation.
+    const int rounds = 2000;
+    std::vector<double> slots(tape->getSlotCount());
+    std::vector<double> partials(tape->getSlotCount());
+    arena.getSymbols().bind(env, slots.data());
+    CompiledExpr compiled(objective);
+    double sink = 0;
+    double evalSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            slots[0] = 0.3 + 1e-6 * r;
+            sink += compiled.evaluate(slots.data());
+        }
+    });
+    double gradSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            slots[0] = 0.3 + 1e-6 * r;
+            sink += tape->evaluateGradient(slots.data(), partials.data());
+        }
+    });
+    Bench::doNotOptimize(sink);
+    std::printf("Repeated calls\n");
+    Bench::report("CompiledExpr::evaluate", evalSeconds, rounds);
+    Bench::report("GradientTape::evaluateGradient", gradSeconds, rounds);
+    std::printf("  gradient cost: %.1fx one evaluation\n", gradSeconds / evalSeconds);
+    delete tape;
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include "memory/expr_arena.h"
+#include "helpers/expr_helper.h"
+#include "bench_util.h"
+
+using namespace Expression;
+
+// Repeated differentiation with and without hash-consing: unique nodes vs. expanded tree size.
+
+// Size of the tree a DAG expands to; memoized so shared nodes are counted without re-walking them.
+static double expandedSize(const Node* node, std::unordered_map<const Node*, double>& memo) {
+    auto it = memo.find(node);
+    if (it != memo.end()) {
+        return it->second;
+    }
+    double size = 1;
+    if (auto binary = dynamic_cast<const BinaryOpNode*>(node)) {
+        size += expandedSize(binary->getLeft(), memo) + expandedSize(binary->getRight(), memo);
+    } else if (auto unary = dynamic_cast<const UnaryOpNode*>(node)) {
+        size += expandedSize(unary->getOperand(), memo);
+    }
+    memo[node] = size;
+    return size;
+}
+
+static void runSeries(bool hashConsing, int maxOrder) {
+    ExprArena arena;
+    arena.setHashConsing(hashConsing);
+    ExprHelper e(arena);
+
+    // f(x) = x^3 * sin(x) / (1 + x)
+    Node* expr = e.div(e.mul(e.exp(e.var("x"), e.num(3)), e.sin(e.var("x"))), e.add(e.num(1), e.var("x")));
+
+    std::printf("Hash-consing %s\n", hashConsing ? "on" : "off");
+    std::printf("  %5s %14s %14s %12s %10s\n", "order", "arena nodes", "tree size", "bytes used", "ms");
+    for (int order = 1; order <= maxOrder; ++order) {
+        double seconds = Bench::timeSeconds([&] {
+            expr = expr->derivative("x", arena);
+        });
+        std::unordered_map<const Node*, double> memo;
+        std::printf("  %5d %14zu %14.0f %12zu %10.2f\n", order, arena.getAllocationCount(),
+                    expandedSize(expr, memo), arena.getBytesUsed(), seconds * 1e3);
+    }
+    std::vector<double> slots = arena.getSymbols().bind({{"x", 0.7}});
+    std::printf("  f^(%d)(0.7) = %.12g\n\n", maxOrder, expr->evaluate(slots.data()));
+}
+
+int main() {
+    Trace::setLevel(TraceLevel::Off);
+    runSeries(true, 7);
+    runSeries(false, 7);
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "memory/expr_arena.h"
+#include "parser/parser.h"
+#include "analysis/interval_evaluator.h"
+#include "bench_util.h"
+
+#include <random>
+
+using namespace Expression;
+
+// Interval evaluation soundness and subdivision queries. Every formula is evaluated on
+// random boxes (some straddling zero, poles and domain edges) and sampled at random
+// points and corners: each value evaluate() returns must lie in the enclosure, and a
+// point that throws or gives NaN must have been announced by mayFail. Then "can f exceed
+// T on the box?" is answered by subdivision and by dense sampling, on either side of the
+// true maximum, and range() is compared with the sampled extremes.
+
+static const char* kFormulas[] = {
+    "x * y - x / (y - 1)",
+    "(x + 1) / (x * x - y)",
+    "sin(3 * x) * cos(y) + x ^ 2",
+    "sin(x * y) + cos(x - y * y)",
+    "ln(x * y + 1) + log(2, y)",
+    "log(x, y * y)",
+    "x ^ y + y ^ 3",
+    "(x - y) ^ (-1) + x ^ 0.5",
+    "(x == y) + (x * 0 == 0)",
+    "ln(sin(x) + 1.5) / (cos(y) + 1)",
+};
+
+int main() {
+    Trace::setLevel(TraceLevel::Off);
+    ExprArena arena;
+    Parser parser(arena);
+    std::mt19937_64 rng(24);
+    std::uniform_real_distribution<double> centre(-6, 6);
+    std::uniform_real_distribution<double> unit(0, 1);
+
+    std::printf("Soundness: 2000 boxes per formula, 64 random points and the corners each\n");
+    std::printf("  %-34s %10s %10s %12s\n", "formula", "outside", "unflagged", "mayFail");
+    std::size_t totalViolations = 0;
+    for (const char* text : kFormulas) {
+        Node* root = parser.parse(text);
+        CompiledExpr program(root);
+        IntervalEvaluator intervals(program);
+        std::vector<Interval> box(program.getSlotCount());
+        std::vector<double> slots(program.getSlotCount());
+        std::size_t outside = 0, unflagged = 0, flagged = 0;
+        for (int trial = 0; trial < 2000; ++trial) {
+            for (const CompiledVariable& variable : program.getVariables()) {
+                double width = std::pow(10.0, -4 + 5 * unit(rng));
+                double lo = trial % 5 == 0 ? std::round(centre(rng)) : centre(rng);  // Integer edges hit poles
+                box[variable.slot] = {lo, lo + width};
+            }
+            IntervalResult result = intervals.evaluate(box.data());
+            flagged += result.mayFail;
+            for (int sample = 0; sample < 64 + 4; ++sample) {
+                std::size_t k = 0;
+                for (const CompiledVariable& variable : program.getVariables()) {
+                    const Interval& range = box[variable.slot];
+                    slots[variable.slot] = sample < 64 ? range.lo + unit(rng) * range.width()
+                                                       : ((sample - 64) >> k & 1) ? range.hi : range.lo;
+                    ++k;
+                }
+                double value;
+                try {
+                    value = program.evaluate(slots.data());
+                } catch (const std::exception&) {
+                    unflagged += !result.mayFail;
+                    continue;
+                }
+                if (std::isnan(value)) {
+                    unflagged += !result.mayFail;
+                } else if (!result.range.contains(value)) {
+                    ++outside;
+                }
+            }
+        }
+        totalViolations += outside + unflagged;
+        std::printf("  %-34s %10zu %10zu %11.1f%%\n", text, outside, unflagged, 100.0 * flagged / 2000);
+    }
+    std::printf("  %zu violations\n", totalViolations);
+
+    // Bound queries on f over [-4, 4] x [-3, 3].
+    Node* root = parser.parse("sin(3 * x) * cos(2 * y) + 0.1 * x ^ 2 - ln(1 + y ^ 2) + x * y / 10");
+    CompiledExpr program(root);
+    IntervalEvaluator intervals(program);
+    std::vector<Interval> box(program.getSlotCount());
+    std::vector<double> slots(program.getSlotCount());
+    const std::uint32_t xSlot = program.getVariables()[0].slot;
+    const std::uint32_t ySlot = program.getVariables()[1].slot;
+    box[xSlot] = {-4, 4};
+    box[ySlot] = {-3, 3};
+
+    RangeResult range;
+    double rangeSeconds = Bench::timeSeconds([&] { range = intervals.range(box.data(), 1e-4); });
+    const std::size_t grid = 2000;
+    double sampledMax = -1e300, sampledMin = 1e300;
+    auto sampleGrid = [&](double threshold) {
+        for (std::size_t i = 0; i <= grid; ++i) {
+            for (std::size_t j = 0; j <= grid; ++j) {
+                slots[xSlot] = -4 + 8.0 * static_cast<double>(i) / grid;
+                slots[ySlot] = -3 + 6.0 * static_cast<double>(j) / grid;
+                double value = program.evaluate(slots.data());
+                sampledMax = std::max(sampledMax, value);
+                sampledMin = std::min(sampledMin, value);
+                if (value > threshold) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+    std::printf("\n%s on [-4, 4] x [-3, 3]\n", root->toString().c_str());
+    std::printf("  range(): enclosure [%.12f, %.12f], attained [%.12f, %.12f], %zu boxes, %.3f ms\n",
+                range.enclosure.lo, range.enclosure.hi, range.attained.lo, range.attained.hi, range.boxesEvaluated,
+                rangeSeconds * 1e3);
+
+    const double thresholds[] = {range.enclosure.hi, range.attained.hi - 1e-3, 3.0};
+    for (double threshold : thresholds) {
+        BoundResult bound;
+        double boundSeconds = Bench::timeSeconds([&] { bound = intervals.exceeds(box.data(), threshold); });
+        bool sampled = false;
+        double sampleSeconds = Bench::timeSeconds([&] { sampled = sampleGrid(threshold); });
+        const char* answer = bound.answer == BoundAnswer::Never     ? "never (proven)"
+                             : bound.answer == BoundAnswer::Exceeds ? "exceeds"
+                                                                    : "unknown";
+        std::printf("  f > %.9f?  subdivision: %-15s %6zu boxes %9.3f ms | %zux%zu grid: %-3s %9.3f ms\n", threshold,
+                    answer, bound.boxesEvaluated, boundSeconds * 1e3, grid + 1, grid + 1, sampled ? "yes" : "no",
+                    sampleSeconds * 1e3);
+        if (bound.answer == BoundAnswer::Exceeds) {
+            std::printf("    witness (%.6f, %.6f) = %.9f\n", bound.witness[xSlot], bound.witness[ySlot], bound.witnessValue);
+        }
+    }
+    std::printf("  grid extremes [%.12f, %.12f] %s the enclosure\n", sampledMin, sampledMax,
+                range.enclosure.contains(sampledMin) && range.enclosure.contains(sampledMax) ? "inside" : "OUTSIDE");
+    return 0;
+}
@@ -0,0 +1,252 @@
+#include "memory/expr_arena.h"
+#include "helpers/expr_helper.h"
+#include "autodiff/jacobian_engine.h"
+#include "autodiff/gradient_tape.h"
+#include "bench_util.h"
+
+#include <cstring>
+#include <random>
+
+using namespace Expression;
+
+// Jacobian of a sparse system of 200 expressions in 50 variables. Each row reads four
+// variables, and every row shares subterms with its neighbours (the same sin(x_i * x_j)
+// and 1 + x_i ^ 2 appear in several rows). Compares the JacobianEngine against one
+// derivative()->simplify() tree per entry, evaluated as trees and as CompiledExprs, and
+// against one GradientTape per row. Values must match the per-entry trees bit for bit,
+// also for rows calling a user function, whose partials come from its derivative callback.
+
+static const int kRows = 200;
+static const int kColumns = 50;
+
+static std::string variable(int i) {
+    return "x" + std::to_string(i % kColumns);
+}
+
+static Node* buildRow(ExprHelper& e, int row) {
+    Node* a = e.var(variable(row));
+    Node* b = e.var(variable(row + 1));
+    Node* c = e.var(variable(row + 7));
+    Node* d = e.var(variable(row + 13));
+    Node* shared = e.sin(e.mul(a, b));
+    Node* bump = e.add(e.num(1), e.exp(b, e.num(2)));
+    Node* term = e.add(e.mul(shared, e.cos(c)), e.div(a, bump));
+    term = e.add(term, e.mul(e.ln(e.add(e.num(1), e.exp(c, e.num(2)))), d));
+    if (row % 4 == 0) {
+        term = e.sub(term, e.exp(bump, e.mul(e.num(0.5), d)));
+    }
+    if (row % 5 == 0) {
+        term = e.add(term, e.log(e.add(e.num(2), e.exp(a, e.num(2))), e.add(e.num(3), d)));
+    }
+    return term;
+}
+
+int main() {
+    Trace::setLevel(TraceLevel::Off);
+    ExprArena arena;
+    ExprHelper e(arena);
+    std::vector<Node*> rows;
+    std::vector<std::string> columns;
+    for (int row = 0; row < kRows; ++row) {
+        rows.push_back(buildRow(e, row));
+    }
+    std::vector<std::size_t> columnSlots;
+    for (int column = 0; column < kColumns; ++column) {
+        columns.push_back(variable(column));
+        columnSlots.push_back(arena.getSymbols().lookup(columns.back()));
+    }
+
+    // Construction: every (row, column) pair through derivative() + simplify(), against
+    // the engine, which skips the columns a row does not read.
+    std::vector<Node*> entries(kRows * kColumns);
+    double naiveBuildSeconds = Bench::timeSeconds([&] {
+        for (int row = 0; row < kRows; ++row) {
+            for (int column = 0; column < kColumns; ++column) {
+                entries[row * kColumns + column] = rows[row]->derivative(columns[column], arena)->simplify(arena);
+            }
+        }
+    });
+    JacobianEngine* engine = nullptr;
+    double engineBuildSeconds = Bench::timeSeconds([&] {
+        engine = new JacobianEngine(rows, columns, arena, JacobianOptions{true});
+    });
+    std::size_t separateLength = 0;
+    std::vector<CompiledExpr> compiled;
+    std::vector<std::size_t> nonZero;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        if (!engine->isStructurallyZero(i / kColumns, i % kColumns)) {
+            compiled.emplace_back(entries[i]);
+            nonZero.push_back(i);
+            separateLength += compiled.back().getCode().size();
+        }
+    }
+    std::printf("%d x %d Jacobian: %zu structural non-zeros (%.1f%%), %zu Hessian entries with j <= k\n", kRows,
+                kColumns, engine->getNonZeroCount(), 100.0 * engine->getNonZeroCount() / (kRows * kColumns),
+                engine->getHessianNonZeroCount());
+    std::printf("  shared program: %zu entries for values + Jacobian (%zu separate instructions), %zu with Hessians\n",
+                engine->getJacobianProgramLength(), separateLength, engine->getProgramLength());
+    std::printf("Construction\n");
+    Bench::report("derivative + simplify, all pairs", naiveBuildSeconds, 1);
+    Bench::report("JacobianEngine with Hessians", engineBuildSeconds, 1);
+
+    // Exactness: the engine against the per-entry trees, over random points.
+    std::mt19937_64 rng(25);
+    std::uniform_real_distribution<double> coordinate(0.2, 1.8);
+    std::vector<double> slots(engine->getSlotCount());
+    std::vector<double> values(kRows);
+    std::vector<double> jacobian(kRows * kColumns);
+    std::vector<double> hessians(kRows * kColumns * kColumns);
+    auto randomPoint = [&] {
+        for (int column = 0; column < kColumns; ++column) {
+            slots[columnSlots[column]] = coordinate(rng);
+        }
+    };
+    std::size_t mismatches = 0, rowMismatches = 0;
+    for (int point = 0; point < 1000; ++point) {
+        randomPoint();
+        engine->evaluate(slots.data(), values.data(), jacobian.data());
+        for (int row = 0; row < kRows; ++row) {
+            double expected = rows[row]->evaluate(slots.data());
+            rowMismatches += std::memcmp(&expected, &values[row], sizeof(double)) != 0;
+        }
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            double expected = entries[i]->evaluate(slots.data());
+            mismatches += std::memcmp(&expected, &jacobian[i], sizeof(double)) != 0;
+        }
+    }
+    std::printf("Exactness over 1000 points: %zu value and %zu Jacobian mismatches (bitwise)\n", rowMismatches,
+                mismatches);
+
+    std::vector<Node*> seconds(kRows * kColumns * kColumns, nullptr);
+    for (std::size_t i : nonZero) {
+        std::size_t row = i / kColumns;
+        for (int k = 0; k < kColumns; ++k) {
+            if (!engine->isStructurallyZero(row, k)) {
+                seconds[i * kColumns + k] = entries[i]->derivative(columns[k], arena)->simplify(arena);
+            }
+        }
+    }
+    std::size_t hessianMismatches = 0;
+    for (int point = 0; point < 100; ++point) {
+        randomPoint();
+        engine->evaluateHessians(slots.data(), hessians.data());
+        for (std::size_t i = 0; i < hessians.size(); ++i) {
+            std::size_t j = i / kColumns % kColumns, k = i % kColumns;
+            Node* second = j <= k ? seconds[i] : seconds[i - k - j * kColumns + k * kColumns + j];
+            double expected = second ? second->evaluate(slots.data()) : 0.0;
+            hessianMismatches += std::memcmp(&expected, &hessians[i], sizeof(double)) != 0;
+        }
+    }
+    std::printf("  %zu Hessian mismatches over 100 points (bitwise, against d/dx_k(d/dx_j) with j <= k)\n", hessianMismatches);
+
+    // Per point: the full Jacobian, every way.
+    const int rounds = 200;
+    double sink = 0;
+    double treeSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            slots[0] = 0.5 + 1e-6 * r;
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                jacobian[i] = entries[i]->evaluate(slots.data());
+            }
+            sink += jacobian[r % jacobian.size()];
+        }
+    });
+    double compiledSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            slots[0] = 0.5 + 1e-6 * r;
+            std::fill(jacobian.begin(), jacobian.end(), 0.0);
+            for (std::size_t i = 0; i < compiled.size(); ++i) {
+                jacobian[nonZero[i]] = compiled[i].evaluate(slots.data());
+            }
+            sink += jacobian[r % jacobian.size()];
+        }
+    });
+    std::vector<GradientTape> tapes(rows.begin(), rows.end());
+    std::vector<double> gradient(engine->getSlotCount());
+    double tapeSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            slots[0] = 0.5 + 1e-6 * r;
+            for (int row = 0; row < kRows; ++row) {
+                values[row] = tapes[row].evaluateGradient(slots.data(), gradient.data());
+                for (int column = 0; column < kColumns; ++column) {
+                    jacobian[row * kColumns + column] = gradient[columnSlots[column]];
+                }
+            }
+            sink += jacobian[r % jacobian.size()];
+        }
+    });
+    double engineSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            slots[0] = 0.5 + 1e-6 * r;
+            engine->evaluate(slots.data(), values.data(), jacobian.data());
+            sink += jacobian[r % jacobian.size()];
+        }
+    });
+    double hessianSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            slots[0] = 0.5 + 1e-6 * r;
+            engine->evaluateHessians(slots.data(), hessians.data());
+            sink += hessians[r % hessians.size()];
+        }
+    });
+    Bench::doNotOptimize(sink);
+    std::printf("Full Jacobian per point (%d points)\n", rounds);
+    Bench::report("Node::evaluate per entry", treeSeconds, rounds);
+    Bench::report("CompiledExpr per non-zero entry", compiledSeconds, rounds);
+    Bench::report("GradientTape per row (+ values)", tapeSeconds, rounds);
+    Bench::report("JacobianEngine::evaluate (+ values)", engineSeconds, rounds);
+    Bench::report("JacobianEngine::evaluateHessians", hessianSeconds, rounds);
+    std::printf("  speedup: %.1fx over trees, %.1fx over CompiledExpr, %.1fx over GradientTape\n",
+                treeSeconds / engineSeconds, compiledSeconds / engineSeconds, tapeSeconds / engineSeconds);
+    delete engine;
+
+    // Rows calling softplus(u, v) = ln(1 + e^(u * v)), which throws for u * v > 30.
+    auto softplus = [](const std::vector<double>& args) {
+        if (args[0] * args[1] > 30) {
+            throw std::runtime_error("softplus: argument too large");
+        }
+        return std::log1p(std::exp(args[0] * args[1]));
+    };
+    auto softplusPartial = [](const std::vector<double>& args, std::size_t index) {
+        double sigmoid = 1 / (1 + std::exp(-args[0] * args[1]));
+        return sigmoid * args[1 - index];
+    };
+    std::vector<Node*> callRows;
+    for (int row = 0; row < kRows; ++row) {
+        Node* call = e.func("softplus", 2, {e.var(variable(row)), e.mul(e.num(2), e.var(variable(row + 3)))}, softplus,
+                            softplusPartial);
+        callRows.push_back(e.add(rows[row], e.mul(call, e.var(variable(row + 5)))));
+    }
+    JacobianEngine callEngine(callRows, columns, arena);
+    std::vector<Node*> callEntries(kRows * kColumns);
+    for (std::size_t i = 0; i < callEntries.size(); ++i) {
+        callEntries[i] = callRows[i / kColumns]->derivative(columns[i % kColumns], arena)->simplify(arena);
+    }
+    std::size_t callMismatches = 0, errorMismatches = 0, failing = 0;
+    std::uniform_real_distribution<double> large(0.2, 4.5);  // Some points make softplus throw
+    for (int point = 0; point < 1000; ++point) {
+        for (int column = 0; column < kColumns; ++column) {
+            slots[columnSlots[column]] = point % 2 ? large(rng) : coordinate(rng);
+        }
+        std::string engineError, treeError;
+        try {
+            callEngine.evaluate(slots.data(), nullptr, jacobian.data());
+        } catch (const std::exception& ex) {
+            engineError = ex.what();
+        }
+        for (std::size_t i = 0; i < callEntries.size() && treeError.empty(); ++i) {
+            try {
+                double expected = callEntries[i]->evaluate(slots.data());
+                callMismatches += engineError.empty() && std::memcmp(&expected, &jacobian[i], sizeof(double)) != 0;
+            } catch (const std::exception& ex) {
+                treeError = ex.what();
+            }
+        }
+        errorMismatches += engineError != treeError;
+        failing += !engineError.empty();
+    }
+    std::printf("Rows calling softplus: %zu non-zeros; over 1000 points (%zu throwing), %zu Jacobian and %zu error"
+                " mismatches\n",
+                callEngine.getNonZeroCount(), failing, callMismatches, errorMismatches);
+    return 0;
+}
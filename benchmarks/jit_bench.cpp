@@ -0,0 +1,165 @@
+#include "memory/expr_arena.h"
+#include "helpers/expr_helper.h"
+#include "compiler/jit_expr.h"
+#include "bench_util.h"
+
+#include <random>
+
+using namespace Expression;
+
+// Tree walk vs. bytecode interpreter vs. JIT-compiled native code, per call through slots.
+// Every expression is also run on inputs chosen to hit its error paths; the JIT must return
+// bit-identical values and throw the same messages as Node::evaluate.
+
+static Node* buildExample(ExprHelper& e) {
+    // (sin(x) + y) * log_2(x) / ln(y)
+    return e.div(e.mul(e.add(e.sin(e.var("x")), e.var("y")), e.log(e.num(2), e.var("x"))), e.ln(e.var("y")));
+}
+
+static Node* buildPolynomial(ExprHelper& e, int terms) {
+    // sum_k c_k * x^k * cos(y)
+    Node* sum = e.num(0);
+    for (int k = 1; k <= terms; ++k) {
+        sum = e.add(sum, e.mul(e.mul(e.num(0.5 * k), e.exp(e.var("x"), e.num(k))), e.cos(e.var("y"))));
+    }
+    return sum;
+}
+
+static Node* buildRational(ExprHelper& e) {
+    // Pure arithmetic: (x*y + 3x - y/2 + 1) / (x*x + y*y + 0.25) - (x - y) * (x + 2y)
+    Node* x = e.var("x");
+    Node* y = e.var("y");
+    Node* numerator = e.add(e.sub(e.add(e.mul(x, y), e.mul(e.num(3), x)), e.div(y, e.num(2))), e.num(1));
+    Node* denominator = e.add(e.add(e.mul(x, x), e.mul(y, y)), e.num(0.25));
+    return e.sub(e.div(numerator, denominator), e.mul(e.sub(x, y), e.add(x, e.mul(e.num(2), y))));
+}
+
+static Node* buildDeep(ExprHelper& e, int levels) {
+    // x + y * (x - y / (x + y * (...))): a stack deeper than the 14 register entries, divisions to check
+    Node* node = e.var("x");
+    for (int i = 0; i < levels; ++i) {
+        Node* x = e.add(e.var("x"), e.num(i));
+        switch (i % 3) {
+        case 0: node = e.add(x, e.mul(e.var("y"), node)); break;
+        case 1: node = e.sub(x, e.div(e.var("y"), node)); break;
+        default: node = e.mul(x, e.add(e.var("y"), node)); break;
+        }
+    }
+    return node;
+}
+
+static Node* buildMixed(ExprHelper& e) {
+    // Every operation: pow, ln, log, equality and a three-argument callback that rejects negative sums.
+    Node* x = e.var("x");
+    Node* y = e.var("y");
+    Node* clamp = e.func("clamp3", 3, {x, y, e.mul(x, y)}, [](const std::vector<double>& args) {
+        double sum = args[0] + args[1] + args[2];
+        if (sum < -50) {
+            throw std::runtime_error("clamp3: sum below -50");
+        }
+        return std::min(std::max(sum, -1.0), 1.0);
+    });
+    Node* power = e.exp(x, e.sub(y, e.num(1)));
+    Node* logs = e.add(e.ln(e.add(e.mul(x, x), y)), e.log(y, e.add(e.num(2), e.mul(x, x))));
+    Node* equal = e.eq(e.sin(x), e.cos(e.sub(e.num(1.5707963267948966), x)));
+    return e.add(e.add(e.mul(power, clamp), logs), e.mul(equal, e.div(e.num(1), e.sub(x, y))));
+}
+
+struct Outcome {
+    double value;
+    std::string error;
+};
+
+template <typename Fn>
+static Outcome run(Fn&& fn) {
+    try {
+        return {fn(), ""};
+    } catch (const std::exception& ex) {
+        return {0, ex.what()};
+    }
+}
+
+static void runComparison(const char* name, Node* expr, const SymbolTable& symbols, std::size_t iterations) {
+    CompiledExpr compiled(expr);
+    JitExpr jit(expr);
+    JitExpr::Function native = jit.getFunction();
+    std::printf("%s: %zu instructions, max stack %zu, %zu bytes of native code\n", name, compiled.getCode().size(),
+                compiled.getMaxStackDepth(), jit.getCodeSize());
+
+    std::vector<double> slots(symbols.size());
+    auto fill = [&](std::size_t i) {
+        for (std::size_t slot = 0; slot < slots.size(); ++slot) {
+            slots[slot] = 1.5 + 0.25 * slot + 1e-6 * static_cast<double>(i);
+        }
+    };
+    double treeSeconds = Bench::timeSeconds([&] {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            fill(i);
+            Bench::doNotOptimize(expr->evaluate(slots.data()));
+        }
+    });
+    double compiledSeconds = Bench::timeSeconds([&] {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            fill(i);
+            Bench::doNotOptimize(compiled.evaluate(slots.data()));
+        }
+    });
+    double jitSeconds = Bench::timeSeconds([&] {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            fill(i);
+            Bench::doNotOptimize(jit.evaluate(slots.data()));
+        }
+    });
+    double nativeSeconds = 0;
+    if (native) {
+        nativeSeconds = Bench::timeSeconds([&] {
+            for (std::size_t i = 0; i < iterations; ++i) {
+                fill(i);
+                Bench::doNotOptimize(native(slots.data()));
+            }
+        });
+    }
+
+    // Random inputs, many of them on the error boundaries (0, 1, negative).
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> wide(-4.0, 4.0);
+    const double special[] = {0.0, 1.0, -1.0, 2.0, -0.0, 0.5};
+    std::size_t mismatches = 0, errors = 0;
+    const std::size_t checks = 20000;
+    for (std::size_t i = 0; i < checks; ++i) {
+        for (double& slot : slots) {
+            slot = rng() % 4 == 0 ? special[rng() % 6] : wide(rng);
+        }
+        Outcome tree = run([&] { return expr->evaluate(slots.data()); });
+        Outcome viaJit = run([&] { return jit.evaluate(slots.data()); });
+        errors += !tree.error.empty();
+        if (tree.error != viaJit.error || std::memcmp(&tree.value, &viaJit.value, sizeof(double)) != 0) {
+            if (++mismatches <= 3) {
+                std::printf("  mismatch: tree %.17g \"%s\", jit %.17g \"%s\"\n", tree.value, tree.error.c_str(),
+                            viaJit.value, viaJit.error.c_str());
+            }
+        }
+    }
+
+    Bench::report("Node::evaluate(slots)", treeSeconds, iterations);
+    Bench::report("CompiledExpr::evaluate(slots)", compiledSeconds, iterations);
+    Bench::report("JitExpr::evaluate(slots)", jitSeconds, iterations);
+    if (native) {
+        Bench::report("JitExpr::Function", nativeSeconds, iterations);
+    }
+    std::printf("  speedup over tree %.1fx, over bytecode %.1fx; %zu/%zu mismatches (%zu inputs raising errors)\n\n",
+                treeSeconds / jitSeconds, compiledSeconds / jitSeconds, mismatches, checks, errors);
+}
+
+int main() {
+    Trace::setLevel(TraceLevel::Off);
+    std::printf("JIT %s\n\n", JitExpr::isSupported() ? "supported" : "not supported: interpreter fallback");
+    ExprArena arena;
+    ExprHelper e(arena);
+    runComparison("Evaluation example", buildExample(e), arena.getSymbols(), 1000000);
+    runComparison("Rational (arithmetic only)", buildRational(e), arena.getSymbols(), 1000000);
+    runComparison("Polynomial (16 terms)", buildPolynomial(e, 16), arena.getSymbols(), 200000);
+    runComparison("Deep (60 levels)", buildDeep(e, 60), arena.getSymbols(), 200000);
+    runComparison("Mixed operations and a callback", buildMixed(e), arena.getSymbols(), 200000);
+    return 0;
+}
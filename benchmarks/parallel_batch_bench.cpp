@@ -0,0 +1,106 @@
+#include "memory/expr_arena.h"
+#include "helpers/expr_helper.h"
+#include "parallel/thread_pool.h"
+#include "bench_util.h"
+
+using namespace Expression;
+
+// Strong scaling of evaluateBatch over a ThreadPool: one expression over 4M rows with
+// 1, 2, 4, ... threads up to the machine's hardware concurrency (or argv[1], to check
+// oversubscribed runs on a small machine). Outputs must be bit-identical to the serial
+// evaluateBatch for every thread count, and when two chunks fail the lower one must be
+// the error reported whatever the scheduling.
+
+int main(int argc, char** argv) {
+    Trace::setLevel(TraceLevel::Off);
+    const std::size_t rows = 4000000;
+
+    ExprArena arena;
+    ExprHelper e(arena);
+    Node* x = e.var("x");
+    Node* y = e.var("y");
+    Node* expr = e.add(e.mul(e.sin(e.mul(x, y)), e.exp(e.add(e.num(1), e.mul(x, x)), e.num(0.5))),
+                       e.div(e.ln(e.add(e.num(2), e.cos(y))), e.add(e.num(1.5), e.mul(y, y))));
+    expr = e.add(expr, e.log(e.num(3), e.add(e.num(1), e.mul(x, x))));
+
+    std::vector<double> xs(rows), ys(rows);
+    for (std::size_t i = 0; i < rows; ++i) {
+        xs[i] = 0.001 * static_cast<double>(i % 5000) - 2.5;
+        ys[i] = 0.002 * static_cast<double>(i % 3001) + 0.1;
+    }
+    BatchInput input(rows);
+    input.bind(arena.getSymbols().lookup("x"), xs.data());
+    input.bind(arena.getSymbols().lookup("y"), ys.data());
+
+    std::vector<double> serial(rows);
+    BatchScratch scratch;
+    evaluateBatch(expr, input, serial.data(), scratch);  // Warm up
+    const int rounds = 3;
+    double serialSeconds = 1e30;
+    for (int r = 0; r < rounds; ++r) {
+        serialSeconds = std::min(serialSeconds, Bench::timeSeconds([&] {
+            evaluateBatch(expr, input, serial.data(), scratch);
+        }));
+    }
+
+    const std::size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t maxThreads = argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : hardware;
+    std::vector<std::size_t> threadCounts;
+    for (std::size_t threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    std::printf("%zu rows, %zu hardware threads, chunks of %zu rows\n", rows, hardware, kParallelChunkRows);
+    Bench::report("serial evaluateBatch", serialSeconds, rows);
+    std::printf("  %8s %12s %10s %10s %10s %10s\n", "threads", "ms", "speedup", "efficiency", "steals", "identical");
+    std::vector<double> parallel(rows);
+    for (std::size_t threads : threadCounts) {
+        ThreadPool pool(threads);
+        evaluateBatch(expr, input, parallel.data(), pool);  // Warm up threads and scratch
+        std::uint64_t stealsBefore = pool.getStealCount();
+        double best = 1e30;
+        for (int r = 0; r < rounds; ++r) {
+            std::fill(parallel.begin(), parallel.end(), 0.0);
+            best = std::min(best, Bench::timeSeconds([&] { evaluateBatch(expr, input, parallel.data(), pool); }));
+        }
+        bool identical = std::memcmp(parallel.data(), serial.data(), rows * sizeof(double)) == 0;
+        double speedup = serialSeconds / best;
+        std::printf("  %8zu %12.3f %10.2f %9.0f%% %10llu %10s\n", threads, best * 1e3, speedup,
+                    100.0 * speedup / static_cast<double>(threads),
+                    static_cast<unsigned long long>((pool.getStealCount() - stealsBefore) / rounds),
+                    identical ? "yes" : "NO");
+    }
+
+    // A callback failing at two rows far apart: the lower row must be reported every time.
+    std::vector<double> rowIndex(rows);
+    for (std::size_t i = 0; i < rows; ++i) {
+        rowIndex[i] = static_cast<double>(i);
+    }
+    BatchInput failing(rows);
+    failing.bind(arena.getSymbols().lookup("x"), rowIndex.data());
+    const std::size_t badRows[] = {rows - 10, rows / 3};
+    Node* check = e.func("check", 1, {x}, [&](const std::vector<double>& args) {
+        std::size_t row = static_cast<std::size_t>(args[0]);
+        if (row == badRows[0] || row == badRows[1]) {
+            throw std::runtime_error("check failed at row " + std::to_string(row));
+        }
+        return args[0];
+    });
+    std::string expected = "check failed at row " + std::to_string(badRows[1]);
+    int mismatches = 0;
+    for (std::size_t threads : threadCounts) {
+        ThreadPool pool(threads);
+        for (int r = 0; r < 5; ++r) {
+            try {
+                evaluateBatch(check, failing, parallel.data(), pool);
+                ++mismatches;
+            } catch (const std::runtime_error& error) {
+                mismatches += expected != error.what();
+            }
+        }
+    }
+    std::printf("Failing rows %zu and %zu: expected \"%s\", %d mismatching reports across thread counts\n",
+                badRows[0], badRows[1], expected.c_str(), mismatches);
+    return 0;
+}
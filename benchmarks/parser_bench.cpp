@@ -0,0 +1,171 @@
+#include "memory/expr_arena.h"
+#include "parser/parser.h"
+#include "bench_util.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace Expression;
+
+// Parser throughput in MB/s over generated formulas, heap allocations per token,
+// a print/parse round trip, and the positions reported for malformed input.
+
+static std::atomic<std::size_t> allocationCount{0};
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+// Small deterministic generator so every run parses the same text.
+struct Lcg {
+    std::uint64_t state = 0x2545F4914F6CDD1DULL;
+    std::uint32_t next(std::uint32_t bound) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<std::uint32_t>(state >> 33) % bound;
+    }
+};
+
+static void emit(std::string& out, Lcg& rng, int depth, std::size_t& tokens) {
+    static const char* variables[] = {"x", "y", "z", "rate", "t0", "alpha"};
+    static const char* numbers[] = {"2", "0.5", "3.25", "1e-3", "42", "7.5e2"};
+    if (depth == 0 || rng.next(6) == 0) {
+        out += rng.next(2) ? variables[rng.next(6)] : numbers[rng.next(6)];
+        tokens += 1;
+        return;
+    }
+    switch (rng.next(9)) {
+    case 0: case 1: case 2: case 3: {
+        static const char* ops[] = {" + ", " - ", " * ", " / "};
+        out += '(';
+        emit(out, rng, depth - 1, tokens);
+        out += ops[rng.next(4)];
+        emit(out, rng, depth - 1, tokens);
+        out += ')';
+        tokens += 3;
+        break;
+    }
+    case 4:
+        emit(out, rng, depth - 1, tokens);
+        out += "^2";
+        tokens += 2;
+        break;
+    case 5:
+        out += rng.next(2) ? "sin(" : "cos(";
+        emit(out, rng, depth - 1, tokens);
+        out += ')';
+        tokens += 3;
+        break;
+    case 6:
+        out += "ln(1 + ";
+        emit(out, rng, depth - 1, tokens);
+        out += "^2)";
+        tokens += 7;
+        break;
+    case 7:
+        out += "log(2, 3 + ";
+        emit(out, rng, depth - 1, tokens);
+        out += "^2)";
+        tokens += 9;
+        break;
+    default:
+        out += "hypot(";
+        emit(out, rng, depth - 1, tokens);
+        out += ", -";
+        emit(out, rng, depth - 1, tokens);
+        out += ')';
+        tokens += 5;
+        break;
+    }
+}
+
+int main() {
+    Trace::setLevel(TraceLevel::Off);
+    FunctionRegistry functions;
+    functions.add("hypot", 2, [](const std::vector<double>& a) { return std::hypot(a[0], a[1]); });
+
+    Lcg rng;
+    std::vector<std::string> formulas;
+    std::size_t bytes = 0;
+    std::size_t tokens = 0;
+    for (int i = 0; i < 20000; ++i) {
+        std::string text;
+        emit(text, rng, 6, tokens);
+        bytes += text.size();
+        formulas.push_back(std::move(text));
+    }
+    std::printf("%zu formulas, %.2f MB, %zu tokens\n", formulas.size(), bytes / 1e6, tokens);
+
+    ExprArena arena;
+    Parser parser(arena, &functions);
+    for (const std::string& text : formulas) {  // Warm up: chunks, symbols, hash buckets
+        arena.reset();
+        parser.parse(text);
+    }
+
+    const int rounds = 5;
+    std::size_t nodes = 0;
+    std::size_t allocationsBefore = allocationCount.load();
+    double seconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            for (const std::string& text : formulas) {
+                arena.reset();
+                parser.parse(text);
+                nodes += arena.getAllocationCount();
+            }
+        }
+    });
+    std::size_t allocations = allocationCount.load() - allocationsBefore;
+    std::printf("Parsing (arena reset per formula)\n");
+    Bench::report("per formula", seconds, rounds * formulas.size());
+    std::printf("  throughput %.1f MB/s, %.1f M tokens/s\n", rounds * bytes / 1e6 / seconds,
+                rounds * tokens / 1e6 / seconds);
+    std::printf("  %.3f heap allocations per token (%zu nodes built)\n",
+                static_cast<double>(allocations) / (rounds * tokens), nodes);
+
+    // Round trip: printing a parsed tree and parsing it again gives the same tree and value.
+    Env env{{"x", 0.7}, {"y", 1.3}, {"z", -0.4}, {"rate", 0.05}, {"t0", 2.0}, {"alpha", 0.9}};
+    std::size_t textMismatches = 0;
+    std::size_t valueMismatches = 0;
+    for (const std::string& text : formulas) {
+        arena.reset();
+        Node* parsed = parser.parse(text);
+        std::string printed = parsed->toString();
+        Node* reparsed = parser.parse(printed);
+        textMismatches += reparsed->toString() != printed;
+        try {
+            double a = parsed->evaluate(env);
+            double b = reparsed->evaluate(env);
+            valueMismatches += !(a == b || (std::isnan(a) && std::isnan(b)) ||
+                                 std::fabs(a - b) <= 1e-4 * std::max(1.0, std::fabs(a)));
+        } catch (const std::runtime_error&) {
+            // Domain errors are expected for some generated formulas.
+        }
+    }
+    std::printf("Round trip: %zu text mismatches, %zu value mismatches (toString prints 6 digits)\n",
+                textMismatches, valueMismatches);
+
+    const char* malformed[] = {"x + * y", "sin(x", "log(2)", "foo(x)", "3 = x", "(x + 1) y", "x # 2", ""};
+    std::printf("Errors\n");
+    for (const char* text : malformed) {
+        try {
+            parser.parse(text);
+            std::printf("  %-12s parsed?!\n", text);
+        } catch (const ParseError& error) {
+            std::printf("  %-12s %s\n", text, error.what());
+        }
+    }
+    return 0;
+}
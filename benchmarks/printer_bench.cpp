@@ -0,0 +1,152 @@
+#include "memory/expr_arena.h"
+#include "helpers/expr_helper.h"
+#include "parser/parser.h"
+#include "printer/expr_printer.h"
+#include "bench_util.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace Expression;
+
+// ExprPrinter against the previous recursive toString (string concatenation per node and
+// an ostringstream per number), in time and heap allocations, plus a minimal-parentheses
+// round trip through the parser.
+
+static std::atomic<std::size_t> allocationCount{0};
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+// The per-node toString implementations this replaces.
+static std::string legacyToString(const Node* node) {
+    switch (node->getKind()) {
+    case NodeKind::Number: {
+        std::ostringstream oss;
+        oss << static_cast<const NumberNode*>(node)->getValue();
+        return oss.str();
+    }
+    case NodeKind::Variable:
+        return static_cast<const VariableNode*>(node)->getName();
+    case NodeKind::Sin:
+        return "sin(" + legacyToString(static_cast<const UnaryOpNode*>(node)->getOperand()) + ")";
+    case NodeKind::Cos:
+        return "cos(" + legacyToString(static_cast<const UnaryOpNode*>(node)->getOperand()) + ")";
+    case NodeKind::Ln:
+        return "ln(" + legacyToString(static_cast<const UnaryOpNode*>(node)->getOperand()) + ")";
+    default: {
+        auto binary = static_cast<const BinaryOpNode*>(node);
+        const char* op = node->is<AdditionNode>() ? " + " : node->is<SubtractionNode>() ? " - "
+                       : node->is<MultiplicationNode>() ? " * " : node->is<DivisionNode>() ? " / " : " ^ ";
+        return "(" + legacyToString(binary->getLeft()) + op + legacyToString(binary->getRight()) + ")";
+    }
+    }
+}
+
+// Left-leaning chain (deep) and balanced tree (wide), with plenty of numbers.
+static Node* buildChain(ExprHelper& e, int length) {
+    Node* node = e.var("x");
+    for (int i = 0; i < length; ++i) {
+        switch (i % 4) {
+        case 0: node = e.add(node, e.num(0.25 * i)); break;
+        case 1: node = e.mul(node, e.var("y")); break;
+        case 2: node = e.sub(node, e.num(1.0 / (i + 3))); break;
+        default: node = e.sin(node); break;
+        }
+    }
+    return node;
+}
+
+static Node* buildBalanced(ExprHelper& e, int depth, int index) {
+    if (depth == 0) {
+        return index % 2 ? e.var("x") : e.num(index * 0.125);
+    }
+    Node* left = buildBalanced(e, depth - 1, 2 * index);
+    Node* right = buildBalanced(e, depth - 1, 2 * index + 1);
+    switch (depth % 3) {
+    case 0: return e.add(left, right);
+    case 1: return e.mul(left, right);
+    default: return e.exp(left, right);
+    }
+}
+
+static void compare(const char* label, const Node* expr, int rounds) {
+    std::size_t length = expr->toString().size();
+    std::printf("%s (%zu characters)\n", label, length);
+
+    std::size_t sink = 0;
+    std::size_t before = allocationCount.load();
+    double legacySeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            sink += legacyToString(expr).size();
+        }
+    });
+    std::size_t legacyAllocations = allocationCount.load() - before;
+
+    ExprPrinter printer;
+    printer.print(expr);  // Grow the buffer once
+    before = allocationCount.load();
+    double printerSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            sink += printer.print(expr).size();
+        }
+    });
+    std::size_t printerAllocations = allocationCount.load() - before;
+    Bench::doNotOptimize(static_cast<double>(sink));
+
+    Bench::report("recursive concatenation", legacySeconds, rounds);
+    Bench::report("ExprPrinter::print", printerSeconds, rounds);
+    std::printf("  speedup %.1fx, allocations per print %.0f -> %.0f, identical: %s\n",
+                legacySeconds / printerSeconds, static_cast<double>(legacyAllocations) / rounds,
+                static_cast<double>(printerAllocations) / rounds,
+                legacyToString(expr) == printer.print(expr) ? "yes" : "NO");
+}
+
+int main() {
+    Trace::setLevel(TraceLevel::Off);
+    ExprArena arena;
+    arena.setHashConsing(false);
+    ExprHelper e(arena);
+
+    compare("Chain of 2000 operations", buildChain(e, 2000), 50);
+    compare("Balanced tree of depth 14", buildBalanced(e, 14, 0), 20);
+
+    // Minimal parentheses: shorter text that parses back to the same tree.
+    Parser parser(arena);
+    const char* samples[] = {"x - (y - z)", "(x - y) - z", "2 ^ 3 ^ x", "(2 ^ 3) ^ x", "(-2) ^ x",
+                             "-x ^ 2", "x * (y + 1) / (z * 2)", "sin(x + y) == cos(x) * 2"};
+    ExprPrinter minimal(PrintOptions{true, 6});
+    std::printf("Minimal parentheses\n");
+    for (const char* text : samples) {
+        Node* parsed = parser.parse(text);
+        std::string printed(minimal.print(parsed));
+        bool roundTrips = parser.parse(printed)->toString() == parsed->toString();
+        std::printf("  %-26s -> %-26s full: %-32s round trip: %s\n", text, printed.c_str(),
+                    parsed->toString().c_str(), roundTrips ? "yes" : "NO");
+    }
+
+    std::size_t roundTripFailures = 0;
+    Node* chain = buildChain(e, 2000);
+    Node* balanced = buildBalanced(e, 12, 0);
+    for (Node* expr : {chain, balanced}) {
+        std::string text(minimal.print(expr));
+        roundTripFailures += parser.parse(text)->toString() != expr->toString();
+        std::printf("  %zu characters minimal vs %zu full\n", text.size(), expr->toString().size());
+    }
+    std::printf("  large-tree round trip failures: %zu\n", roundTripFailures);
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include "memory/expr_arena.h"
+#include "helpers/expr_helper.h"
+#include "rewrite/rewriter.h"
+#include "bench_util.h"
+
+using namespace Expression;
+
+// Fixpoint rewriting with kind-indexed rules and a normal-form cache, against Node::simplify.
+// "rules tried" counts every rule examined at a node; a flat registry scan examines all of
+// them, as a single simplify() that tests each identity in turn would.
+
+// Sum over i of x*i + y*(i % 3): like terms that simplify() cannot collect.
+static Node* buildPolynomial(ExprHelper& e, int terms) {
+    Node* sum = e.mul(e.var("x"), e.num(1));
+    for (int i = 2; i <= terms; ++i) {
+        sum = e.add(sum, e.mul(e.var("x"), e.num(i)));
+        sum = e.add(sum, e.mul(e.var("y"), e.num(i % 3)));
+    }
+    return sum;
+}
+
+// Balanced tree of foldable constants and identities, with repeated subtrees.
+static Node* buildTree(ExprHelper& e, int depth, int index) {
+    if (depth == 0) {
+        switch (index % 4) {
+        case 0: return e.var("x");
+        case 1: return e.num(0);
+        case 2: return e.var("y");
+        default: return e.num(1 + index % 5);
+        }
+    }
+    Node* left = buildTree(e, depth - 1, 2 * index);
+    Node* right = buildTree(e, depth - 1, 2 * index + 1);
+    switch ((depth + index) % 5) {
+    case 0: return e.add(left, right);
+    case 1: return e.mul(left, e.mul(right, e.num(2)));
+    case 2: return e.sub(left, right);
+    case 3: return e.exp(left, e.num(1));
+    default: return e.add(e.mul(left, e.num(2)), e.mul(left, e.num(3)));
+    }
+}
+
+static std::size_t treeSize(const Node* node) {
+    if (auto binary = dynamic_cast<const BinaryOpNode*>(node)) {
+        return 1 + treeSize(binary->getLeft()) + treeSize(binary->getRight());
+    }
+    if (auto unary = dynamic_cast<const UnaryOpNode*>(node)) {
+        return 1 + treeSize(unary->getOperand());
+    }
+    return 1;
+}
+
+static void runCase(const char* label, const Node* expr, const RuleRegistry& rules) {
+    const int rounds = 20;
+    std::printf("%s: %zu tree nodes\n", label, treeSize(expr));
+    std::printf("  %-28s %10s %12s %12s %10s %10s\n", "", "ms/pass", "visited", "rules tried", "per node", "result");
+
+    ExprArena scratch;
+    Node* simplified = nullptr;
+    double seconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            scratch.reset();
+            simplified = expr->simplify(scratch);
+        }
+    });
+    std::printf("  %-28s %10.3f %12s %12s %10s %10zu\n", "Node::simplify", seconds * 1e3 / rounds,
+                "-", "-", "-", treeSize(simplified));
+    std::string simplifiedText = simplified->toString();
+
+    struct Config {
+        const char* name;
+        RewriteOptions options;
+    };
+    Config configs[3] = {{"rewrite, indexed + cache", {}}, {"rewrite, flat scan + cache", {}},
+                         {"rewrite, indexed, no cache", {}}};
+    configs[1].options.indexByKind = false;
+    configs[2].options.cacheNormalForms = false;
+
+    for (const Config& config : configs) {
+        RewriteStats stats;
+        Node* result = nullptr;
+        seconds = Bench::timeSeconds([&] {
+            for (int r = 0; r < rounds; ++r) {
+                scratch.reset();
+                Rewriter rewriter(rules, scratch, config.options);
+                result = rewriter.rewrite(expr);
+                stats = rewriter.getStats();
+            }
+        });
+        std::printf("  %-28s %10.3f %12llu %12llu %10.2f %10zu\n", config.name, seconds * 1e3 / rounds,
+                    static_cast<unsigned long long>(stats.nodesVisited),
+                    static_cast<unsigned long long>(stats.rulesTried),
+                    static_cast<double>(stats.rulesTried) / stats.nodesVisited, treeSize(result));
+    }
+    std::printf("  simplify: %.80s\n", simplifiedText.c_str());
+    scratch.reset();
+    Rewriter rewriter(rules, scratch);
+    std::printf("  rewrite:  %.80s\n\n", rewriter.rewrite(expr)->toString().c_str());
+}
+
+int main() {
+    Trace::setLevel(TraceLevel::Off);
+    RuleRegistry rules = makeStandardRules();
+    std::printf("%zu rules registered\n\n", rules.size());
+
+    ExprArena source;
+    source.setHashConsing(false);  // Real trees, not shared DAGs
+    ExprHelper e(source);
+
+    runCase("x*2 + x*3", e.add(e.mul(e.var("x"), e.num(2)), e.mul(e.var("x"), e.num(3))), rules);
+    runCase("polynomial, 200 terms", buildPolynomial(e, 200), rules);
+    runCase("balanced tree, depth 10", buildTree(e, 10, 0), rules);
+    return 0;
+}
@@ -0,0 +1,226 @@
+#include "memory/expr_arena.h"
+#include "parser/parser.h"
+#include "serialize/expr_writer.h"
+#include "serialize/expr_library.h"
+#include "bench_util.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sys/resource.h>
+
+using namespace Expression;
+
+// Cold start of a 20000-formula library: parsing the text of every formula into nodes vs
+// mapping one ExprWriter file and evaluating each formula straight from its records,
+// with heap allocations and minor page faults for both. Also checks that evaluation and
+// load() agree with the parsed trees, and that a truncated file is rejected.
+
+static std::atomic<std::size_t> allocationCount{0};
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+static long minorFaults() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+
+// Small deterministic generator so every run builds the same library.
+struct Lcg {
+    std::uint64_t state = 0x9E3779B97F4A7C15ULL;
+    std::uint32_t next(std::uint32_t bound) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<std::uint32_t>(state >> 33) % bound;
+    }
+};
+
+static void emit(std::string& out, Lcg& rng, int depth) {
+    static const char* variables[] = {"x", "y", "z", "rate", "t0", "alpha"};
+    static const char* numbers[] = {"2", "0.5", "3.25", "1e-3", "42", "7.5e2"};
+    if (depth == 0 || rng.next(6) == 0) {
+        out += rng.next(2) ? variables[rng.next(6)] : numbers[rng.next(6)];
+        return;
+    }
+    switch (rng.next(8)) {
+    case 0: case 1: case 2: case 3: {
+        static const char* ops[] = {" + ", " - ", " * ", " / "};
+        out += '(';
+        emit(out, rng, depth - 1);
+        out += ops[rng.next(4)];
+        emit(out, rng, depth - 1);
+        out += ')';
+        break;
+    }
+    case 4:
+        out += rng.next(2) ? "sin(" : "cos(";
+        emit(out, rng, depth - 1);
+        out += ')';
+        break;
+    case 5:
+        out += "ln(1 + ";
+        emit(out, rng, depth - 1);
+        out += "^2)";
+        break;
+    case 6:
+        out += "log(2, 3 + ";
+        emit(out, rng, depth - 1);
+        out += "^2)";
+        break;
+    default:
+        out += "hypot(";
+        emit(out, rng, depth - 1);
+        out += ", ";
+        emit(out, rng, depth - 1);
+        out += ')';
+        break;
+    }
+}
+
+// Evaluate, folding domain errors into the message so both paths can be compared.
+template<typename Fn>
+static std::string outcome(Fn&& fn) {
+    try {
+        double value = fn();
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%a", value);
+        return buffer;
+    } catch (const std::runtime_error& error) {
+        return error.what();
+    }
+}
+
+int main() {
+    Trace::setLevel(TraceLevel::Off);
+    FunctionRegistry functions;
+    functions.add("hypot", 2, [](const std::vector<double>& a) { return std::hypot(a[0], a[1]); });
+    const Env env{{"x", 0.7}, {"y", 1.3}, {"z", -0.4}, {"rate", 0.05}, {"t0", 2.0}, {"alpha", 0.9}};
+
+    Lcg rng;
+    std::vector<std::string> texts;
+    std::size_t textBytes = 0;
+    for (int i = 0; i < 20000; ++i) {
+        std::string text;
+        emit(text, rng, 6);
+        textBytes += text.size();
+        texts.push_back(std::move(text));
+    }
+
+    const std::string path = "serialize_bench.exprlib";
+    {
+        ExprArena arena;
+        Parser parser(arena, &functions);
+        ExprWriter writer;
+        for (std::size_t i = 0; i < texts.size(); ++i) {
+            writer.add(parser.parse(texts[i]), "f" + std::to_string(i));
+        }
+        writer.writeFile(path);
+    }
+    std::ifstream sizeProbe(path, std::ios::binary | std::ios::ate);
+    const double fileBytes = static_cast<double>(sizeProbe.tellg());
+    std::printf("%zu formulas: %.2f MB of text, %.2f MB library file\n", texts.size(), textBytes / 1e6,
+                fileBytes / 1e6);
+
+    // Cold start from text: parse every formula into one arena, then evaluate it once.
+    std::vector<double> parsedValues(texts.size());
+    std::size_t allocationsBefore = allocationCount.load();
+    long faultsBefore = minorFaults();
+    double parseSeconds = Bench::timeSeconds([&] {
+        ExprArena arena;
+        Parser parser(arena, &functions);
+        std::vector<double> slots;
+        for (std::size_t i = 0; i < texts.size(); ++i) {
+            Node* root = parser.parse(texts[i]);
+            slots.resize(arena.getSymbols().size());
+            arena.getSymbols().bind(env, slots.data());
+            try {
+                parsedValues[i] = root->evaluate(slots.data());
+            } catch (const std::runtime_error&) {
+                parsedValues[i] = 0;
+            }
+        }
+    });
+    std::size_t parseAllocations = allocationCount.load() - allocationsBefore;
+    long parseFaults = minorFaults() - faultsBefore;
+
+    // Cold start from the mapped library: open, then evaluate each formula in place.
+    std::vector<double> mappedValues(texts.size());
+    allocationsBefore = allocationCount.load();
+    faultsBefore = minorFaults();
+    double mappedSeconds = Bench::timeSeconds([&] {
+        ExprLibrary library = ExprLibrary::open(path, &functions);
+        double slots[16] = {};
+        for (std::size_t s = 0; s < library.getSymbolCount(); ++s) {
+            auto it = env.find(std::string(library.getSymbol(s)));
+            slots[s] = it != env.end() ? it->second : 0.0;
+        }
+        for (std::size_t i = 0; i < library.getFormulaCount(); ++i) {
+            try {
+                mappedValues[i] = library.evaluate(i, slots);
+            } catch (const std::runtime_error&) {
+                mappedValues[i] = 0;
+            }
+        }
+    });
+    std::size_t mappedAllocations = allocationCount.load() - allocationsBefore;
+    long mappedFaults = minorFaults() - faultsBefore;
+
+    const double count = static_cast<double>(texts.size());
+    std::printf("Cold start: load and evaluate every formula once\n");
+    Bench::report("parse text + evaluate", parseSeconds, texts.size());
+    std::printf("    %8.2f heap allocations, %6.3f minor page faults per formula\n", parseAllocations / count,
+                parseFaults / count);
+    Bench::report("mmap library + evaluate", mappedSeconds, texts.size());
+    std::printf("    %8.2f heap allocations, %6.3f minor page faults per formula\n", mappedAllocations / count,
+                mappedFaults / count);
+    std::printf("  speedup %.1fx\n", parseSeconds / mappedSeconds);
+
+    // Agreement: identical values and error messages, and load() rebuilds the same text.
+    ExprLibrary library = ExprLibrary::open(path, &functions);
+    ExprArena arena;
+    Parser parser(arena, &functions);
+    std::size_t valueMismatches = 0;
+    std::size_t textMismatches = 0;
+    std::size_t errors = 0;
+    for (std::size_t i = 0; i < texts.size(); ++i) {
+        arena.reset();
+        Node* parsed = parser.parse(texts[i]);
+        std::string expected = outcome([&] { return parsed->evaluate(env); });
+        std::string actual = outcome([&] { return library.evaluate(i, env); });
+        valueMismatches += expected != actual;
+        errors += expected.find(' ') != std::string::npos;
+        textMismatches += library.load(i, arena)->toString() != parsed->toString();
+        textMismatches += library.getName(i) != "f" + std::to_string(i);
+    }
+    std::printf("Agreement with parsed trees: %zu value/error mismatches (%zu formulas raise errors), "
+                "%zu text mismatches\n", valueMismatches, errors, textMismatches);
+
+    // A truncated copy must be rejected rather than read past its end.
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::vector<double> aligned(bytes.size() / sizeof(double) + 1);
+    std::memcpy(aligned.data(), bytes.data(), bytes.size());
+    try {
+        ExprLibrary truncated(aligned.data(), bytes.size() / 2, &functions);
+        std::printf("Truncated file accepted?!\n");
+    } catch (const std::runtime_error& error) {
+        std::printf("Truncated file: %s\n", error.what());
+    }
+    std::remove(path.c_str());
+    return 0;
+}
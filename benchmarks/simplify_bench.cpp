@@ -0,0 +1,146 @@
+#include "memory/expr_arena.h"
+#include "helpers/expr_helper.h"
+#include "bench_util.h"
+
+using namespace Expression;
+
+// simplify() over a tree full of foldable constants and identities, matching operands
+// through the NodeKind tag (Node::as) and, as before the tag existed, through dynamic_cast.
+
+static Node* buildTree(ExprHelper& e, int depth, int index) {
+    if (depth == 0) {
+        switch (index % 4) {
+        case 0: return e.var("x");
+        case 1: return e.num(0);
+        case 2: return e.var("y");
+        default: return e.num(1 + index % 5);
+        }
+    }
+    Node* left = buildTree(e, depth - 1, 2 * index);
+    Node* right = buildTree(e, depth - 1, 2 * index + 1);
+    switch ((depth + index) % 5) {
+    case 0: return e.add(left, right);
+    case 1: return e.mul(left, right);
+    case 2: return e.sub(left, right);
+    case 3: return e.add(left, e.exp(right, e.num(1)));
+    default: return e.div(e.add(left, right), e.num(1 + index % 3));
+    }
+}
+
+// simplify() for the operators of buildTree, with every operand test a dynamic_cast.
+static Node* simplifyWithCasts(const Node* node, ExprHelper& e) {
+    auto number = [](const Node* n) { return dynamic_cast<const NumberNode*>(n); };
+    auto binary = dynamic_cast<const BinaryOpNode*>(node);
+    if (!binary) {
+        if (auto value = number(node)) {
+            return e.num(value->getValue());
+        }
+        return e.var(dynamic_cast<const VariableNode*>(node)->getName());
+    }
+    Node* left = simplifyWithCasts(binary->getLeft(), e);
+    Node* right = simplifyWithCasts(binary->getRight(), e);
+    const NumberNode* l = number(left);
+    const NumberNode* r = number(right);
+    if (dynamic_cast<const AdditionNode*>(node)) {
+        if (l && r) return e.num(l->getValue() + r->getValue());
+        if (r && r->getValue() == 0) return left;
+        if (l && l->getValue() == 0) return right;
+        return e.add(left, right);
+    }
+    if (dynamic_cast<const MultiplicationNode*>(node)) {
+        if (l && r) return e.num(l->getValue() * r->getValue());
+        if (r && r->getValue() == 1) return left;
+        if (r && r->getValue() == 0) return e.num(0);
+        if (l && l->getValue() == 1) return right;
+        if (l && l->getValue() == 0) return e.num(0);
+        return e.mul(left, right);
+    }
+    if (dynamic_cast<const SubtractionNode*>(node)) {
+        if (l && r) return e.num(l->getValue() - r->getValue());
+        if (r && r->getValue() == 0) return left;
+        if (structurallyEqual(left, right)) return e.num(0);
+        return e.sub(left, right);
+    }
+    if (dynamic_cast<const DivisionNode*>(node)) {
+        if (l && r) return e.num(l->getValue() / r->getValue());  // No zero divisors in buildTree
+        if (r && r->getValue() == 1) return left;
+        if (l && l->getValue() == 0) return e.num(0);
+        return e.div(left, right);
+    }
+    if (r && r->getValue() == 0) return e.num(1);  // ExponentiationNode
+    if (r && r->getValue() == 1) return left;
+    if (l && (l->getValue() == 0 || l->getValue() == 1)) return e.num(l->getValue());
+    return e.exp(left, right);
+}
+
+static void collect(Node* node, std::vector<Node*>& nodes) {
+    nodes.push_back(node);
+    if (auto binary = dynamic_cast<BinaryOpNode*>(node)) {
+        collect(binary->getLeft(), nodes);
+        collect(binary->getRight(), nodes);
+    }
+}
+
+// The test simplify() performs on every operand: "is this a NumberNode?".
+static void compareMatching(const std::vector<Node*>& nodes) {
+    const int rounds = 50;
+    std::size_t hits = 0;
+    double castSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            for (Node* node : nodes) {
+                hits += dynamic_cast<NumberNode*>(node) != nullptr;
+            }
+        }
+    });
+    Bench::doNotOptimize(hits);
+    double kindSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            for (Node* node : nodes) {
+                hits += node->as<NumberNode>() != nullptr;
+            }
+        }
+    });
+    Bench::doNotOptimize(hits);
+    std::printf("NumberNode match over %zu nodes\n", nodes.size());
+    Bench::report("dynamic_cast", castSeconds, rounds);
+    Bench::report("as<NumberNode>", kindSeconds, rounds);
+}
+
+int main() {
+    Trace::setLevel(TraceLevel::Off);
+
+    ExprArena source;
+    source.setHashConsing(false);  // A real tree, not a shared DAG
+    ExprHelper e(source);
+    Node* expr = buildTree(e, 16, 0);
+    std::vector<Node*> nodes;
+    collect(expr, nodes);
+    std::printf("simplify() on a %zu-node tree\n", nodes.size());
+
+    const int rounds = 20;
+    ExprArena scratch;
+    Node* simplified = nullptr;
+    double kindSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            scratch.reset();
+            simplified = expr->simplify(scratch);
+        }
+    });
+    std::size_t resultNodes = scratch.getAllocationCount();
+    Node* casted = nullptr;
+    ExprArena castScratch;
+    double castSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            castScratch.reset();
+            ExprHelper c(castScratch);
+            casted = simplifyWithCasts(expr, c);
+        }
+    });
+    Bench::report("simplify (dynamic_cast matching)", castSeconds, rounds);
+    Bench::report("simplify (NodeKind matching)", kindSeconds, rounds);
+    std::printf("  %zu nodes in the simplified result arena, results %s\n", resultNodes,
+                structurallyEqual(simplified, casted) ? "identical" : "DIFFER");
+
+    compareMatching(nodes);
+    return 0;
+}
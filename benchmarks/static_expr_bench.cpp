@@ -0,0 +1,159 @@
+#include "templates/static_expr.h"
+#include "compiler/jit_expr.h"
+#include "autodiff/gradient_tape.h"
+#include "bench_util.h"
+
+#include <random>
+
+using namespace Expression;
+using namespace Expression::Static;
+
+// Expression templates against a hand-written function, the tree walk and the JIT on
+// the same potential, and its compile-time gradient against GradientTape. The template
+// version should cost what the hand-written code costs. toNode() must give a tree that
+// prints, evaluates and fails like the template, and the compile-time partials must agree
+// with the runtime derivative() of that tree.
+
+constexpr Var<0> x;
+constexpr Var<1> y;
+constexpr Var<2> z;
+
+// Compile-time checks: constexpr evaluation and folded derivative types.
+constexpr double kPoint[] = {2, 5, 0};
+static_assert((x * Int<3>{} + y / Int<2>{}).evaluate(kPoint) == 8.5, "constexpr evaluation");
+static_assert(std::is_same<DerivativeOf<decltype(x * y), 0>, Var<1>>::value, "d(x*y)/dx folds to y");
+static_assert(std::is_same<DerivativeOf<decltype(x * y + z), 2>, Int<1>>::value, "d(x*y+z)/dz folds to 1");
+static_assert(std::is_same<DerivativeOf<decltype(sin(y)), 0>, Int<0>>::value, "d(sin y)/dx folds to 0");
+static_assert(derivative<0>(x * Const{2.5} + sin(y)).evaluate(kPoint) == 2.5, "d(2.5x + sin y)/dx");
+
+// sin(x*y) + cos(y*z) + (x - z)^2 / (1 + y^2) + ln(1 + x^2 + z^2) * sin(x*y)
+constexpr auto potential = sin(x * y) + cos(y * z) + pow(x - z, Int<2>{}) / (Int<1>{} + pow(y, Int<2>{})) +
+                           ln(Int<1>{} + pow(x, Int<2>{}) + pow(z, Int<2>{})) * sin(x * y);
+
+static double handWritten(const double* v) {
+    double denominator = 1 + std::pow(v[1], 2);
+    if (denominator == 0) {
+        throw std::runtime_error("Division by zero");
+    }
+    double logArgument = 1 + std::pow(v[0], 2) + std::pow(v[2], 2);
+    if (logArgument <= 0) {
+        throw std::runtime_error("Math error: ln of non-positive number.");
+    }
+    return std::sin(v[0] * v[1]) + std::cos(v[1] * v[2]) + std::pow(v[0] - v[2], 2) / denominator +
+           std::log(logArgument) * std::sin(v[0] * v[1]);
+}
+
+template <typename Fn>
+static std::string errorOf(Fn&& fn) {
+    try {
+        fn();
+        return "";
+    } catch (const std::exception& ex) {
+        return ex.what();
+    }
+}
+
+int main() {
+    Trace::setLevel(TraceLevel::Off);
+    ExprArena arena;
+    for (std::size_t i = 0; i < 3; ++i) {
+        arena.getSymbols().intern(variableName(i));  // Slot i is Var<i>
+    }
+    Node* tree = toNode(potential, arena);
+    JitExpr jit(tree);
+
+    const std::size_t iterations = 1000000;
+    std::mt19937_64 rng(23);
+    std::uniform_real_distribution<double> wide(-3, 3);
+    std::vector<double> inputs(3 * 1024);
+    for (double& value : inputs) {
+        value = wide(rng);
+    }
+    auto timeCalls = [&](auto&& fn) {  // Best of five rounds
+        double best = 1e30;
+        for (int round = 0; round < 5; ++round) {
+            best = std::min(best, Bench::timeSeconds([&] {
+                double sum = 0;
+                for (std::size_t i = 0; i < iterations; ++i) {
+                    sum += fn(&inputs[3 * (i & 1023)]);
+                }
+                Bench::doNotOptimize(sum);
+            }));
+        }
+        return best;
+    };
+    double handSeconds = timeCalls([](const double* v) { return handWritten(v); });
+    double staticSeconds = timeCalls([](const double* v) { return potential.evaluate(v); });
+    double treeSeconds = timeCalls([&](const double* v) { return tree->evaluate(v); });
+    double jitSeconds = timeCalls([&](const double* v) { return jit.evaluate(v); });
+
+    std::size_t valueMismatches = 0;
+    double maxValueDiff = 0;
+    for (std::size_t i = 0; i < 1024; ++i) {
+        const double* v = &inputs[3 * i];
+        double expected = tree->evaluate(v);
+        double actual = potential.evaluate(v);
+        valueMismatches += std::memcmp(&expected, &actual, sizeof(double)) != 0;
+        maxValueDiff = std::max(maxValueDiff, std::fabs(expected - actual) / std::max(1.0, std::fabs(expected)));
+    }
+    std::printf("%s\n%zu calls, ns/call\n", toString(potential).c_str(), iterations);
+    Bench::report("hand-written C++", handSeconds, iterations);
+    Bench::report("expression template", staticSeconds, iterations);
+    Bench::report("Node::evaluate", treeSeconds, iterations);
+    Bench::report("JitExpr", jitSeconds, iterations);
+    std::printf("  template vs tree: %zu/1024 values differ in the last bits (max relative diff %.3g)\n",
+                valueMismatches, maxValueDiff);
+
+    // Compile-time gradient vs. the tape, and vs. the runtime derivative of the bridged tree.
+    constexpr auto dx = derivative<0>(potential);
+    constexpr auto dy = derivative<1>(potential);
+    constexpr auto dz = derivative<2>(potential);
+    GradientTape tape(tree);
+    std::vector<double> tapeGradient(tape.getSlotCount());
+    double tapeSeconds = timeCalls([&](const double* v) {
+        return tape.evaluateGradient(v, tapeGradient.data()) + tapeGradient[0];
+    });
+    double gradientSeconds = timeCalls([&](const double* v) {
+        return potential.evaluate(v) + dx.evaluate(v) + dy.evaluate(v) + dz.evaluate(v);
+    });
+    Node* runtimePartials[] = {tree->derivative("x0", arena), tree->derivative("x1", arena),
+                               tree->derivative("x2", arena)};
+    double maxTapeDiff = 0, maxRuntimeDiff = 0;
+    for (std::size_t i = 0; i < 1024; ++i) {
+        const double* v = &inputs[3 * i];
+        tape.evaluateGradient(v, tapeGradient.data());
+        const double partials[] = {dx.evaluate(v), dy.evaluate(v), dz.evaluate(v)};
+        for (std::size_t p = 0; p < 3; ++p) {
+            double runtime = runtimePartials[p]->evaluate(v);
+            maxTapeDiff = std::max(maxTapeDiff, std::fabs(tapeGradient[p] - partials[p]) / std::max(1.0, std::fabs(partials[p])));
+            maxRuntimeDiff = std::max(maxRuntimeDiff, std::fabs(runtime - partials[p]) / std::max(1.0, std::fabs(partials[p])));
+        }
+    }
+    std::printf("Gradient (value and three partials):\n");
+    Bench::report("GradientTape::evaluateGradient", tapeSeconds, iterations);
+    Bench::report("derivative<I> templates", gradientSeconds, iterations);
+    std::printf("  max relative diff to the tape %.3g, to Node::derivative %.3g\n", maxTapeDiff, maxRuntimeDiff);
+    std::printf("  d/dx0 = %s\n", toString(dx).c_str());
+
+    // Errors: the template and its bridged tree fail with the same messages.
+    constexpr auto quotient = (x + Const{1.5}) / (y - Int<1>{});
+    constexpr auto logs = ln(x) + log(y, z);
+    constexpr auto power = pow(x, y - Int<2>{});
+    const double failing[][3] = {{1, 1, 3}, {0, 2, 3}, {2, 1, 3}, {2, 3, -1}, {0, 1, 0}, {0, 2, 0}};
+    std::size_t errorChecks = 0, errorMismatches = 0;
+    for (const auto& v : failing) {
+        auto check = [&](const auto& expr) {
+            Node* node = toNode(expr, arena);
+            std::string expected = errorOf([&] { return node->evaluate(v); });
+            std::string actual = errorOf([&] { return expr.evaluate(v); });
+            ++errorChecks;
+            errorMismatches += expected != actual;
+        };
+        check(quotient);
+        check(logs);
+        check(power);
+    }
+    std::printf("Errors: %zu/%zu mismatching messages, e.g. \"%s\"\n", errorMismatches, errorChecks,
+                errorOf([&] { return quotient.evaluate(failing[0]); }).c_str());
+    return 0;
+}
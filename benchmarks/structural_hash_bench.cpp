@@ -0,0 +1,103 @@
+#include "memory/expr_arena.h"
+#include "helpers/expr_helper.h"
+#include "bench_util.h"
+
+using namespace Expression;
+
+// Comparing two large trees built without hash-consing: printing both with toString()
+// (what EqualityNode::simplify used to do) vs structurallyEqual, for equal trees and for
+// trees that differ in one leaf. Also counts hash collisions among all their subtrees.
+
+static Node* buildTree(ExprHelper& e, int depth, int index, int changedLeaf) {
+    if (depth == 0) {
+        if (index == changedLeaf) {
+            return e.var("w");
+        }
+        switch (index % 4) {
+        case 0: return e.var("x");
+        case 1: return e.num(0.5 * index);
+        case 2: return e.var("y");
+        default: return e.num(1 + index % 5);
+        }
+    }
+    Node* left = buildTree(e, depth - 1, 2 * index, changedLeaf);
+    Node* right = buildTree(e, depth - 1, 2 * index + 1, changedLeaf);
+    switch ((depth + index) % 6) {
+    case 0: return e.add(left, right);
+    case 1: return e.mul(left, right);
+    case 2: return e.sub(left, right);
+    case 3: return e.exp(left, e.sin(right));
+    case 4: return e.log(e.add(left, e.num(2)), right);
+    default: return e.div(left, e.cos(right));
+    }
+}
+
+static void collect(const Node* node, std::vector<const Node*>& nodes) {
+    nodes.push_back(node);
+    switch (node->getKind()) {
+    case NodeKind::Number:
+    case NodeKind::Variable:
+        return;
+    case NodeKind::Sin:
+    case NodeKind::Cos:
+    case NodeKind::Ln:
+        collect(static_cast<const UnaryOpNode*>(node)->getOperand(), nodes);
+        return;
+    default:
+        collect(static_cast<const BinaryOpNode*>(node)->getLeft(), nodes);
+        collect(static_cast<const BinaryOpNode*>(node)->getRight(), nodes);
+        return;
+    }
+}
+
+static void compare(const char* label, const Node* a, const Node* b) {
+    const int rounds = 20;
+    bool textEqual = false;
+    double textSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            textEqual = a->toString() == b->toString();
+        }
+    });
+    bool structEqual = false;
+    double structSeconds = Bench::timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            structEqual = structurallyEqual(a, b);
+        }
+    });
+    std::printf("%s (text %s, structure %s)\n", label, textEqual ? "equal" : "differs",
+                structEqual ? "equal" : "differs");
+    Bench::report("toString() == toString()", textSeconds, rounds);
+    Bench::report("structurallyEqual", structSeconds, rounds);
+    std::printf("  speedup %.0fx\n", textSeconds / structSeconds);
+}
+
+int main() {
+    Trace::setLevel(TraceLevel::Off);
+    const int depth = 14;
+
+    ExprArena arena;
+    arena.setHashConsing(false);  // Equal trees are distinct nodes, as after clone() or parsing
+    ExprHelper e(arena);
+    Node* original = buildTree(e, depth, 0, -1);
+    Node* copy = buildTree(e, depth, 0, -1);
+    Node* changed = buildTree(e, depth, 0, (1 << depth) - 3);
+
+    std::vector<const Node*> nodes;
+    collect(original, nodes);
+    std::printf("Trees of %zu nodes, built without hash-consing\n", nodes.size());
+    compare("Equal trees", original, copy);
+    compare("Trees differing in one leaf", original, changed);
+
+    // Hash quality over every subtree of all three trees: each distinct structure should
+    // have a hash of its own.
+    collect(copy, nodes);
+    collect(changed, nodes);
+    std::unordered_set<const Node*, NodeHash, NodeEqual> structures(nodes.begin(), nodes.end());
+    std::unordered_set<std::uint64_t> hashes;
+    for (const Node* node : structures) {
+        hashes.insert(node->getStructuralHash());
+    }
+    std::printf("Hash check over %zu subtrees: %zu distinct structures, %zu distinct hashes\n", nodes.size(),
+                structures.size(), hashes.size());
+    return 0;
+}
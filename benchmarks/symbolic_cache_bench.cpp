@@ -0,0 +1,94 @@
+#include "memory/expr_arena.h"
+#include "memory/symbolic_cache.h"
+#include "helpers/expr_helper.h"
+#include "bench_util.h"
+
+using namespace Expression;
+
+// Hessian by repeated symbolic differentiation: every entry is
+// f->derivative(p_i)->derivative(p_j)->simplify(), as a pipeline asking for one second
+// derivative at a time would compute it. Compared with no cache, an unbounded-enough
+// SymbolicCache and a small one that has to evict; entries are checked by value.
+
+static std::string param(int i) {
+    return "p" + std::to_string(i);
+}
+
+static Node* buildObjective(ExprHelper& e, int params) {
+    Node* sum = e.num(0);
+    for (int i = 0; i + 1 < params; ++i) {
+        Node* p = e.var(param(i));
+        Node* q = e.var(param(i + 1));
+        Node* term = e.add(e.sin(e.mul(p, q)), e.div(e.ln(e.add(e.num(1), e.exp(p, e.num(2)))), e.add(e.num(2), q)));
+        term = e.add(term, e.mul(e.cos(e.sub(p, q)), e.exp(q, e.num(3))));
+        sum = e.add(sum, term);
+    }
+    return sum;
+}
+
+struct Run {
+    double seconds;
+    std::size_t nodes;
+    std::vector<double> values;
+    SymbolicCacheStats stats;
+};
+
+static Run hessian(const Node* objective, int params, const Env& env, std::size_t capacity) {
+    ExprArena arena;
+    std::unique_ptr<SymbolicCache> cache;
+    if (capacity > 0) {
+        cache = std::make_unique<SymbolicCache>(capacity);
+        arena.setSymbolicCache(cache.get());
+    }
+    std::vector<Node*> entries;
+    Run run{};
+    run.seconds = Bench::timeSeconds([&] {
+        for (int i = 0; i < params; ++i) {
+            for (int j = 0; j < params; ++j) {
+                entries.push_back(objective->derivative(param(i), arena)->derivative(param(j), arena)->simplify(arena));
+            }
+        }
+    });
+    run.nodes = arena.getAllocationCount();
+    for (Node* entry : entries) {
+        run.values.push_back(entry->evaluate(env));
+    }
+    if (cache) {
+        run.stats = cache->getStats();
+    }
+    return run;
+}
+
+int main() {
+    Trace::setLevel(TraceLevel::Off);
+    const int params = 16;
+
+    ExprArena source;
+    ExprHelper e(source);
+    Node* objective = buildObjective(e, params);
+    Env env;
+    for (int i = 0; i < params; ++i) {
+        env[param(i)] = 0.3 + 0.05 * i;
+    }
+
+    std::printf("%dx%d Hessian, one derivative(p_i)->derivative(p_j)->simplify() per entry\n", params, params);
+    std::printf("  %-22s %10s %12s %10s %10s %10s %12s\n", "", "ms", "nodes built", "hits", "misses", "evictions",
+                "max |diff|");
+    Run plain = hessian(objective, params, env, 0);
+    const std::size_t capacities[] = {0, SymbolicCache::kDefaultCapacity, 16384};
+    const char* labels[] = {"no cache", "cache, 65536 entries", "cache, 16384 entries"};
+    for (int c = 0; c < 3; ++c) {
+        Run run = c == 0 ? plain : hessian(objective, params, env, capacities[c]);
+        double maxDiff = 0;
+        for (std::size_t k = 0; k < run.values.size(); ++k) {
+            maxDiff = std::max(maxDiff, std::fabs(run.values[k] - plain.values[k]));
+        }
+        std::printf("  %-22s %10.3f %12zu %10llu %10llu %10llu %12.3g\n", labels[c], run.seconds * 1e3, run.nodes,
+                    static_cast<unsigned long long>(run.stats.hits), static_cast<unsigned long long>(run.stats.misses),
+                    static_cast<unsigned long long>(run.stats.evictions), maxDiff);
+        if (c > 0) {
+            std::printf("  %-22s speedup %.1fx\n", "", plain.seconds / run.seconds);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "memory/expr_arena.h"
+#include "helpers/expr_helper.h"
+#include "bench_util.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace Expression;
+
+// Count heap allocations so the Off level can be shown to allocate nothing.
+static std::atomic<std::size_t> allocationCount{0};
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+// Left-leaning chain alternating + and * with a sin every few levels: depth ~= levels.
+static Node* buildDeepTree(ExprHelper& e, int levels) {
+    Node* node = e.var("x");
+    for (int i = 0; i < levels; ++i) {
+        if (i % 8 == 7) {
+            node = e.sin(node);
+        } else if (i % 2 == 0) {
+            node = e.add(node, e.num(0.25));
+        } else {
+            node = e.mul(node, e.var("y"));
+        }
+    }
+    return node;
+}
+
+static void runLevel(const char* label, TraceLevel level, Node* expr, const double* slots, std::size_t iterations) {
+    Trace::setLevel(level);
+    Trace::clear();
+    std::size_t allocationsBefore = allocationCount.load();
+    double seconds = Bench::timeSeconds([&] {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            Bench::doNotOptimize(expr->evaluate(slots));
+        }
+    });
+    std::size_t allocations = allocationCount.load() - allocationsBefore;
+    Bench::report(label, seconds, iterations);
+    std::printf("  %-32s %10zu allocations/iter over %zu iterations\n", "", allocations / iterations, iterations);
+    Trace::clear();
+}
+
+int main() {
+    for (int depth : {16, 128, 512}) {
+        ExprArena arena;
+        ExprHelper e(arena);
+        Node* expr = buildDeepTree(e, depth);
+        std::vector<double> slots = arena.getSymbols().bind({{"x", 0.5}, {"y", 0.999}});
+
+        std::size_t iterations = depth <= 16 ? 2000 : 20;
+        std::printf("Deep tree, depth %d\n", depth);
+        runLevel("TraceLevel::Full", TraceLevel::Full, expr, slots.data(), iterations);
+        runLevel("TraceLevel::Summary", TraceLevel::Summary, expr, slots.data(), iterations);
+        runLevel("TraceLevel::Off", TraceLevel::Off, expr, slots.data(), iterations * 100);  // Too fast to time otherwise
+        std::printf("\n");
+    }
+#if !EXPR_ENABLE_TRACING
+    std::printf("Tracing compiled out (EXPR_ENABLE_TRACING=0): every level behaves like Off.\n");
+#endif
+    return 0;
+}
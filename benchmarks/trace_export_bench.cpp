@@ -0,0 +1,135 @@
+#include "tracing/trace.h"
+#include "bench_util.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <new>
+#include <unistd.h>
+
+using namespace Expression;
+
+// Exporting a large trace: the nlohmann DOM that exportToJson used to build and dump,
+// against TraceWriter streaming the same document into a string, to a file descriptor and
+// as JSON Lines to an ofstream. Peak heap is measured above what the recorded trace
+// already holds. The streamed documents must match the DOM's dump(4) and dump() exactly.
+
+static std::size_t liveBytes = 0;
+static std::size_t peakBytes = 0;
+
+void* operator new(std::size_t size) {
+    auto* p = static_cast<std::size_t*>(std::malloc(size + 16));
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    *p = size;
+    liveBytes += size;
+    peakBytes = std::max(peakBytes, liveBytes);
+    return reinterpret_cast<char*>(p) + 16;
+}
+
+void operator delete(void* p) noexcept {
+    if (p) {
+        auto* header = reinterpret_cast<std::size_t*>(static_cast<char*>(p) - 16);
+        liveBytes -= *header;
+        std::free(header);
+    }
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    operator delete(p);
+}
+
+struct Measured {
+    double seconds;
+    std::size_t peak;  // Bytes above the heap in use when the export started
+};
+
+template <typename Fn>
+static Measured measure(Fn&& fn) {
+    std::size_t before = liveBytes;
+    peakBytes = liveBytes;
+    double seconds = Bench::timeSeconds(fn);
+    return {seconds, peakBytes - before};
+}
+
+static void print(const char* label, const Measured& m, std::size_t bytes) {
+    std::printf("  %-30s %10.1f ms %10.1f MB peak %10.1f MB out\n", label, m.seconds * 1e3, m.peak / 1e6, bytes / 1e6);
+}
+
+int main() {
+    const std::size_t records = 400000;
+    Trace::setLevel(TraceLevel::Full);
+    Trace::clear();
+    for (std::size_t i = 0; i < records; ++i) {
+        std::string n = std::to_string(i);
+        if (i % 2 == 0) {
+            Trace::add("Evaluating \"node\" " + n + ":\tvalue = " + std::to_string(0.5 * i));
+        } else {
+            Trace::addTransformation("simplify step " + n, "((x + 0) * (1 * y)) / " + n, "(x * y) / " + n);
+        }
+    }
+    std::string pretty = Trace::exportToJson();  // Warm the aggregator's timeline
+    pretty.clear();
+    pretty.shrink_to_fit();
+    std::printf("%zu records (half transformations)\n", records);
+
+    std::string domPretty, domCompact;
+    Measured dom = measure([&] {
+        // What exportToJson used to do.
+        nlohmann::json j;
+        j["messages"] = nlohmann::json::array();
+        j["transformationSteps"] = nlohmann::json::array();
+        std::string before, after;
+        for (std::size_t i = 0; i < records; ++i) {
+            std::string n = std::to_string(i);
+            if (i % 2 == 0) {
+                j["messages"].push_back("Evaluating \"node\" " + n + ":\tvalue = " + std::to_string(0.5 * i));
+            } else {
+                std::string description = "simplify step " + n;
+                before = "((x + 0) * (1 * y)) / " + n;
+                after = "(x * y) / " + n;
+                j["messages"].push_back("Transformation: " + description + "\n    Before: " + before +
+                                        "\n    After : " + after);
+                j["transformationSteps"].push_back({{"description", description}, {"before", before}, {"after", after}});
+            }
+        }
+        domPretty = j.dump(4);
+    });
+    print("nlohmann DOM + dump(4)", dom, domPretty.size());
+    domCompact = nlohmann::json::parse(domPretty).dump();
+
+    Measured stringExport = measure([&] { pretty = Trace::exportToJson(); });
+    print("exportToJson (string)", stringExport, pretty.size());
+
+    int fd = ::open("/dev/null", O_WRONLY);
+    Measured fdExport = measure([&] { Trace::exportTo(fd); });
+    ::close(fd);
+    print("exportTo(fd), compact JSON", fdExport, domCompact.size());
+
+    const char* path = "/tmp/trace_export_bench.jsonl";
+    Measured linesExport = measure([&] {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        TraceExportOptions options;
+        options.format = TraceFormat::JsonLines;
+        Trace::exportTo(out, options);
+    });
+    std::ifstream in(path);
+    std::size_t lines = 0, lineBytes = 0;
+    bool linesParse = true;
+    for (std::string line; std::getline(in, line); ++lines) {
+        lineBytes += line.size() + 1;
+        linesParse = linesParse && nlohmann::json::parse(line).contains("timestamp");
+    }
+    print("exportTo(ofstream), JSON Lines", linesExport, lineBytes);
+    std::remove(path);
+
+    std::ostringstream compact;
+    Trace::exportTo(compact);
+    std::printf("exportToJson == dump(4): %s, compact == dump(): %s, %zu JSON lines%s\n",
+                pretty == domPretty ? "yes" : "NO", compact.str() == domCompact ? "yes" : "NO", lines,
+                linesParse ? ", all parse" : ", PARSE FAILURES");
+    Trace::clear();
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include "memory/expr_arena.h"
+#include "helpers/expr_helper.h"
+#include "bench_util.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+using namespace Expression;
+
+// Tracing from several threads at once. Each thread records tagged messages; the time
+// is compared with the same records pushed into one mutex-protected vector, the obvious
+// thread-safe version of the old single static sink, where every record contends. The
+// merged export must hold every record exactly once with each thread's records in order.
+// Then threads run Full-level evaluations while another thread keeps draining, and a
+// TraceScope keeps one context's trace out of the global one. argv[1] sets the maximum
+// thread count.
+
+static double runThreads(std::size_t threads, const std::function<void(std::size_t)>& body) {
+    return Bench::timeSeconds([&] {
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < threads; ++t) {
+            workers.emplace_back(body, t);
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    });
+}
+
+static std::string tag(std::size_t thread, std::size_t i) {
+    return "t" + std::to_string(thread) + " " + std::to_string(i);
+}
+
+// Every "t<thread> <i>" message present once and in increasing i per thread.
+static bool checkMerged(const nlohmann::json& messages, std::size_t threads, std::size_t perThread) {
+    std::vector<std::size_t> next(threads, 0);
+    for (const auto& message : messages) {
+        std::string text = message.get<std::string>();
+        std::size_t space = text.find(' ');
+        std::size_t thread = std::stoul(text.substr(1, space - 1));
+        std::size_t i = std::stoul(text.substr(space + 1));
+        if (thread >= threads || i != next[thread]) {
+            return false;
+        }
+        ++next[thread];
+    }
+    return std::all_of(next.begin(), next.end(), [&](std::size_t n) { return n == perThread; });
+}
+
+int main(int argc, char** argv) {
+    Trace::setLevel(TraceLevel::Full);
+    const std::size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t maxThreads = argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : std::max<std::size_t>(hardware, 4);
+    std::vector<std::size_t> threadCounts;
+    for (std::size_t threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    const std::size_t perThread = 200000;
+    std::printf("%zu records per thread, %zu hardware threads\n", perThread, hardware);
+    std::printf("  %8s %14s %14s %10s %10s\n", "threads", "sinks ns/rec", "mutex ns/rec", "merged ok", "export ms");
+    for (std::size_t threads : threadCounts) {
+        std::vector<std::vector<std::string>> messages(threads);
+        for (std::size_t t = 0; t < threads; ++t) {
+            for (std::size_t i = 0; i < perThread; ++i) {
+                messages[t].push_back(tag(t, i));
+            }
+        }
+        double records = static_cast<double>(threads * perThread);
+
+        Trace::clear();
+        double sinkSeconds = runThreads(threads, [&](std::size_t t) {
+            for (const std::string& message : messages[t]) {
+                Trace::add(message);
+            }
+        });
+        std::string json;
+        double exportSeconds = Bench::timeSeconds([&] { json = Trace::exportToJson(); });
+        bool merged = checkMerged(nlohmann::json::parse(json)["messages"], threads, perThread);
+        Trace::clear();
+
+        std::mutex sharedMutex;
+        std::vector<TraceRecord> shared;
+        double mutexSeconds = runThreads(threads, [&](std::size_t t) {
+            for (const std::string& message : messages[t]) {
+                TraceRecord record;
+                record.timestamp = static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+                record.text = message;
+                std::lock_guard<std::mutex> lock(sharedMutex);
+                shared.push_back(std::move(record));
+            }
+        });
+        std::printf("  %8zu %14.1f %14.1f %10s %10.1f\n", threads, sinkSeconds * 1e9 / records,
+                    mutexSeconds * 1e9 / records, merged ? "yes" : "NO", exportSeconds * 1e3);
+    }
+
+    // Concurrent Full-level evaluation: every thread's evaluation steps must come out whole.
+    ExprArena arena;
+    ExprHelper e(arena);
+    Node* x = e.var("x");
+    Node* expr = e.add(e.mul(e.sin(x), e.num(2)), e.div(e.exp(x, e.num(2)), e.add(x, e.num(1))));
+    Trace::clear();
+    expr->evaluate(Env{{"x", 0.5}});
+    std::size_t stepsPerEvaluation = nlohmann::json::parse(Trace::exportToJson())["messages"].size();
+    Trace::clear();
+    const std::size_t evaluations = 2000;
+    std::vector<double> sums(maxThreads, 0.0);
+    std::atomic<bool> done{false};
+    std::size_t polls = 0;
+    std::thread poller([&] {
+        // Drain while the evaluating threads record, as a server exporting periodically would.
+        while (!done.load()) {
+            Trace::getTrace();
+            ++polls;
+        }
+    });
+    double evaluateSeconds = runThreads(maxThreads, [&](std::size_t t) {
+        Env env{{"x", 0.1 * static_cast<double>(t + 1)}};
+        for (std::size_t i = 0; i < evaluations; ++i) {
+            sums[t] += expr->evaluate(env);
+        }
+    });
+    done = true;
+    poller.join();
+    std::size_t recorded = nlohmann::json::parse(Trace::exportToJson())["messages"].size();
+    Trace::clear();
+    std::printf("%zu threads x %zu traced evaluations: %.3f ms, %zu of %zu steps recorded, %zu concurrent drains\n",
+                maxThreads, evaluations, evaluateSeconds * 1e3, recorded, maxThreads * evaluations * stepsPerEvaluation,
+                polls);
+
+    // A context sink: its records stay out of the global trace.
+    TraceSink context;
+    {
+        TraceScope scope(context);
+        expr->evaluate(Env{{"x", 0.5}});
+    }
+    std::size_t contextSteps = nlohmann::json::parse(context.exportToJson())["messages"].size();
+    std::size_t globalSteps = nlohmann::json::parse(Trace::exportToJson())["messages"].size();
+    std::printf("Scoped evaluation: %zu steps in the context sink, %zu in the global trace\n", contextSteps,
+                globalSteps);
+    return 0;
+}
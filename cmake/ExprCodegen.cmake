@@ -0,0 +1,25 @@
+# expr_add_formula_library(<target> <spec> [NAMESPACE <namespace>])
+#
+# Compiles the formulas in <spec> (syntax in tools/expr_codegen.cpp) ahead of time: the
+# expr_codegen tool writes <target>.h and <target>.cpp into the build tree at build time,
+# and they are compiled into the static library <target>, next to expr_static. Link the
+# target and include "<target>.h"; the functions live in <namespace> (default <target>).
+function(expr_add_formula_library TARGET SPEC)
+    cmake_parse_arguments(ARG "" "NAMESPACE" "" ${ARGN})
+    if(NOT ARG_NAMESPACE)
+        set(ARG_NAMESPACE ${TARGET})
+    endif()
+    get_filename_component(SPEC_PATH ${SPEC} ABSOLUTE)
+    set(OUTPUT_DIR ${CMAKE_CURRENT_BINARY_DIR}/${TARGET}_generated)
+    set(HEADER ${OUTPUT_DIR}/${TARGET}.h)
+    set(SOURCE ${OUTPUT_DIR}/${TARGET}.cpp)
+    add_custom_command(
+        OUTPUT ${HEADER} ${SOURCE}
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${OUTPUT_DIR}
+        COMMAND expr_codegen ${SPEC_PATH} ${HEADER} ${SOURCE} ${ARG_NAMESPACE}
+        DEPENDS ${SPEC_PATH} expr_codegen
+        COMMENT "Generating C++ for the formulas in ${SPEC}"
+        VERBATIM)
+    add_library(${TARGET} STATIC ${SOURCE} ${HEADER})
+    target_include_directories(${TARGET} PUBLIC ${OUTPUT_DIR})
+endfunction()
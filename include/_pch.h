@@ -3,9 +3,18 @@
 #include <string>
 #include <sstream>
 #include <unordered_map>
+#include <unordered_set>
+#include <map>
+#include <string_view>
+#include <charconv>
+#include <cctype>
+#include <array>
 #include <vector>
 #include <functional>
 #include <stdexcept>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
 #include <iomanip>
 #include <memory>
@@ -0,0 +1,119 @@
+#ifndef INTERVAL_EVALUATOR_H
+#define INTERVAL_EVALUATOR_H
+
+#include "compiler/compiled_expr.h"
+
+#include <limits>
+
+namespace Expression {
+
+// Closed range [lo, hi] of doubles; bounds may be infinite, and lo > hi means empty.
+struct Interval {
+    double lo;
+    double hi;
+
+    static Interval point(double value) { return {value, value}; }
+    static Interval empty();
+    static Interval entire();
+
+    bool isEmpty() const { return lo > hi; }
+    bool contains(double value) const { return lo <= value && value <= hi; }
+    double width() const { return hi - lo; }
+    double midpoint() const { return 0.5 * lo + 0.5 * hi; }  // No overflow for huge bounds
+};
+
+using IntervalEnv = std::unordered_map<std::string, Interval>;
+
+struct IntervalResult {
+    Interval range;        // Every value evaluate() returns on the box lies in here
+    bool mayFail = false;  // Some point of the box may throw or give NaN
+};
+
+struct SubdivisionOptions {
+    std::size_t maxBoxes = 100000;  // Interval evaluations before giving up
+    double minWidth = 0;            // Boxes no wider than this in every variable are not split
+};
+
+enum class BoundAnswer {
+    Never,    // Proven: f <= threshold wherever evaluate() returns a value
+    Exceeds,  // evaluate() at the witness returned a value above the threshold
+    Unknown   // Budget exhausted (or minWidth reached) before either was shown
+};
+
+struct BoundResult {
+    BoundAnswer answer = BoundAnswer::Unknown;
+    std::vector<double> witness;  // Exceeds: the point, indexed by slot
+    double witnessValue = 0;
+    std::size_t boxesEvaluated = 0;
+};
+
+struct RangeResult {
+    Interval enclosure;  // Proven bounds on every value over the box
+    Interval attained;   // Lowest and highest values found at sampled points (empty if none)
+    std::size_t boxesEvaluated = 0;
+};
+
+// Interval arithmetic over a compiled expression: given a box (one interval per variable
+// slot), one pass over the program returns a range enclosing every value
+// CompiledExpr::evaluate (and so Node::evaluate) can return at a point of the box. The
+// bounds are those of the floating-point evaluation itself: +, -, *, / are monotone under
+// round-to-nearest and need no widening, libm results (sin, cos, ln, log, pow) are widened
+// by two ulps.
+//
+// Points where evaluation throws or gives NaN (division by zero, ln and log outside their
+// domain, 0 to a non-positive power, a negative base to a fractional power) contribute no
+// value and set mayFail: dividing by an interval containing zero gives the one- or
+// two-sided infinite range of the remaining points, ln of [-1, 4] is (-inf, ln 4]. sin and
+// cos take their extrema wherever the interval crosses one. Function calls have unknown
+// range and give (-inf, inf).
+//
+// exceeds() and range() subdivide a bounded box, bisecting the widest variable, and prune
+// every box whose enclosure already settles the question, so whole regions are discarded
+// at the cost of one pass each instead of being sampled.
+class IntervalEvaluator {
+public:
+    explicit IntervalEvaluator(const CompiledExpr& program);
+    explicit IntervalEvaluator(const Node* root);
+
+    // box[slot] for every slot below getSlotCount().
+    IntervalResult evaluate(const Interval* box);
+    // Same, with missing variables set to [0, 0].
+    IntervalResult evaluate(const IntervalEnv& box);
+
+    // Whether evaluate() exceeds threshold anywhere in the (bounded) box.
+    BoundResult exceeds(const Interval* box, double threshold, const SubdivisionOptions& options = SubdivisionOptions());
+    // Bounds on the minimum and maximum over the (bounded) box, refined until the enclosure
+    // is within tolerance of sampled values on both sides or the budget runs out.
+    RangeResult range(const Interval* box, double tolerance, const SubdivisionOptions& options = SubdivisionOptions());
+
+    const CompiledExpr& getProgram() const;
+    std::size_t getSlotCount() const;
+
+private:
+    std::vector<Interval> boxFromEnv(const IntervalEnv& env) const;
+    void checkBounded(const Interval* box) const;
+    // Sample the midpoint of box; false if evaluation throws or gives NaN.
+    bool sampleMidpoint(const Interval* box, double& value);
+    // Slot of the widest variable wider than minWidth, or false if none.
+    bool splitSlot(const Interval* box, double minWidth, std::uint32_t& slot) const;
+    struct Search {
+        double bound = -std::numeric_limits<double>::infinity();     // Of sign * f over the box
+        double attained = -std::numeric_limits<double>::infinity();  // Best sample of sign * f
+        std::vector<double> witness;                                 // Where it was attained
+        std::size_t boxesEvaluated = 0;
+    };
+    // Highest value of sign * f (sign -1 for the lowest of f).
+    Search maximize(const Interval* box, double sign, double tolerance, double target, std::size_t budget,
+                    double minWidth);
+
+    CompiledExpr program;
+
+    std::vector<Interval> stack;
+    std::vector<Interval> temps;
+    std::vector<double> point;
+    bool mayFail = false;
+};
+
+} // namespace Expression
+
+#endif
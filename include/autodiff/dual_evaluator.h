@@ -0,0 +1,59 @@
+#ifndef DUAL_EVALUATOR_H
+#define DUAL_EVALUATOR_H
+
+#include "compiler/compiled_expr.h"
+
+namespace Expression {
+
+// A value together with its derivative along one direction.
+struct Dual {
+    double value;
+    double tangent;
+};
+
+// Lanes per sweep used by evaluatePartials.
+constexpr std::size_t kDualLaneCount = 16;
+
+// Forward-mode automatic differentiation over a compiled expression. Every stack entry
+// carries its value plus one tangent per lane, stored contiguously per entry, so each
+// instruction updates all lanes with one tight loop over scalars it computed once.
+// One sweep with N lanes yields N directional derivatives (N Jacobian columns).
+//
+// Conventions match GradientTape: equality has a zero derivative, a power whose base is
+// not positive contributes nothing through its exponent, and a function call needs a
+// DerivativeCallback. Values and errors match CompiledExpr::evaluate.
+class DualEvaluator {
+public:
+    explicit DualEvaluator(const CompiledExpr& program);
+    explicit DualEvaluator(const Node* root);
+
+    // Value and derivative along direction[slot].
+    Dual evaluateDual(const double* slots, const double* direction);
+    // Same, with missing variables and directions defaulting to 0.
+    Dual evaluateDual(const Env& env, const Env& direction);
+
+    // Value, and in tangents[k] the derivative along lane k, where seeds[slot * lanes + k]
+    // is lane k's direction component for that slot.
+    double evaluateLanes(const double* slots, const double* seeds, std::size_t lanes, double* tangents);
+
+    // Value, and partials[slot] for every slot below getSlotCount(), kDualLaneCount per sweep.
+    double evaluatePartials(const double* slots, double* partials);
+
+    const CompiledExpr& getProgram() const;
+    std::size_t getSlotCount() const;
+
+private:
+    CompiledExpr program;
+
+    std::vector<double> stack;          // Values
+    std::vector<double> tangentStack;   // lanes tangents per stack entry
+    std::vector<double> temps;
+    std::vector<double> tempTangents;
+    std::vector<double> args;
+    std::vector<double> partialsOfCall;
+    std::vector<double> seedBlock;
+};
+
+} // namespace Expression
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef GRADIENT_TAPE_H
+#define GRADIENT_TAPE_H
+
+#include "compiler/compiled_expr.h"
+
+namespace Expression {
+
+// Reverse-mode automatic differentiation over a compiled expression. The postorder program
+// is turned into a list of single-assignment entries (temps of the CSE pass become plain
+// references), so one forward sweep records every intermediate value and one backward
+// sweep accumulates the adjoints. The value and the partial derivative with respect to
+// every variable come out together, at a small constant multiple of one evaluation.
+//
+// Conventions: equality has a zero derivative; a power whose base is not positive
+// contributes nothing through its exponent. A function call is differentiated with its
+// DerivativeCallback; reaching a call without one throws.
+class GradientTape {
+public:
+    explicit GradientTape(const CompiledExpr& program);
+    explicit GradientTape(const Node* root);
+
+    // Value of the expression. gradient[slot] receives the partial derivative for every
+    // slot below getSlotCount(); slots the expression does not use are set to 0.
+    double evaluateGradient(const double* slots, double* gradient);
+    // Same, with gradient[name] set for every variable of the expression.
+    double evaluateGradient(const Env& env, Env& gradient);
+
+    const std::vector<CompiledVariable>& getVariables() const;
+    std::size_t getSlotCount() const;
+    // Entries recorded per sweep (instructions minus temp stores and loads).
+    std::size_t getTapeLength() const;
+
+private:
+    struct Entry {
+        OpCode op;
+        std::uint32_t operand;     // Constant, slot, error message or function index
+        std::uint32_t args[2];     // Entries holding the operands
+        std::uint32_t callArgs;    // Call: offset of its argument entries in callArgs
+    };
+
+    void build(const CompiledExpr& program);
+    void forward(const double* slots);
+    void backward(double* gradient);
+    const std::vector<double>& gatherArgs(const Entry& entry);
+
+    std::vector<Entry> entries;
+    std::vector<std::uint32_t> callArgs;
+    std::vector<double> constants;
+    std::vector<CompiledFunction> functions;
+    std::vector<std::string> errorMessages;
+    std::vector<CompiledVariable> variables;
+    std::size_t slotCount = 0;
+
+    std::vector<double> values;    // Forward values, one per entry
+    std::vector<double> adjoints;  // d(result)/d(entry)
+    std::vector<double> args;      // Argument values of the call being processed
+};
+
+} // namespace Expression
+
+#endif
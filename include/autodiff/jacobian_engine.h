@@ -0,0 +1,106 @@
+#ifndef JACOBIAN_ENGINE_H
+#define JACOBIAN_ENGINE_H
+
+#include "compiler/compiled_expr.h"
+
+namespace Expression {
+
+struct JacobianOptions {
+    // Also build the second derivatives, for evaluateHessians.
+    bool hessians = false;
+};
+
+// Jacobian, and optionally Hessians, of a system of expressions with respect to a list of
+// variables. Construction differentiates every (row, column) pair once, symbolically, and
+// lowers the values, all partials and all second partials into one straight-line program
+// over a shared DAG: a subexpression common to several entries (or to several rows) is
+// computed once per point. Evaluation is one pass over that program.
+//
+// Sparsity: a row that does not use a variable has a structurally zero column, and so
+// does an entry whose simplified derivative is the constant 0. Zero entries are never
+// differentiated again nor evaluated, only written as 0.
+//
+// Each entry gets the value derivative(variable)->simplify()->evaluate() would give, bit
+// for bit. An entry that would throw makes the evaluate call throw the same message (the
+// first failing value, then the first failing partial, in row-major order); the other
+// entries do not fail with it. The same holds for exceptions thrown by user functions.
+// Calls are differentiated through their derivative callbacks (see FunctionNode); the
+// partial calls this creates have none, so Hessians through a call are rejected.
+class JacobianEngine {
+public:
+    // Derivative nodes are built in arena, which must be the one the expressions' variables
+    // come from (their slots are read from its symbol table). They are not needed once the
+    // constructor returns.
+    JacobianEngine(const std::vector<Node*>& expressions, const std::vector<std::string>& variables, ExprArena& arena,
+                   JacobianOptions options = JacobianOptions());
+
+    std::size_t getRowCount() const;     // Expressions
+    std::size_t getColumnCount() const;  // Variables
+    // Length of the slot array the evaluate functions read.
+    std::size_t getSlotCount() const;
+
+    // values[row] (skipped if values is nullptr) and jacobian[row * columns + column] at
+    // the point slots[VariableNode::getSlot()].
+    void evaluate(const double* slots, double* values, double* jacobian);
+    // Same, with missing variables defaulting to 0.
+    void evaluate(const Env& env, double* values, double* jacobian);
+    // hessians[(row * columns + j) * columns + k] = d/dx_k (d row / dx_j), for j <= k,
+    // mirrored to (k, j). Needs JacobianOptions::hessians.
+    void evaluateHessians(const double* slots, double* hessians);
+
+    bool isStructurallyZero(std::size_t row, std::size_t column) const;
+    // Jacobian entries computed per point, and Hessian entries with j <= k.
+    std::size_t getNonZeroCount() const;
+    std::size_t getHessianNonZeroCount() const;
+    // Entries of the shared program, and how many of them evaluate() runs.
+    std::size_t getProgramLength() const;
+    std::size_t getJacobianProgramLength() const;
+
+private:
+    struct Entry {
+        OpCode op;
+        std::uint32_t operand;  // Constant, slot, error message or function index
+        std::uint32_t args[2];  // Entries holding the operands (both the same if unary);
+                                // for Call, the first index in callArgs and the count
+    };
+    struct Output {
+        std::uint32_t entry;
+        std::size_t position;  // In the dense output
+    };
+
+    std::uint32_t lower(const Node* node);
+    void sweep(const double* slots, std::size_t length);
+    void call(std::size_t index);  // Sweep step of a Call entry
+    void checkErrors(const std::vector<Output>& outputs) const;
+
+    std::size_t rowCount;
+    std::size_t columnCount;
+    std::size_t slotCount = 0;
+    bool withHessians;
+
+    std::vector<Entry> entries;
+    std::vector<double> constants;
+    std::vector<std::string> errorMessages;  // Index 0: no error
+    std::vector<FunctionNode::FunctionCallback> functions;
+    std::vector<std::uint32_t> callArgs;     // Argument entries of every call, back to back
+    std::vector<CompiledVariable> programVariables;
+    std::unordered_map<const Node*, std::uint32_t, NodeHash, NodeEqual> entryOf;  // While lowering
+    std::size_t jacobianLength = 0;
+
+    std::vector<Output> valueOutputs;
+    std::vector<Output> jacobianOutputs;
+    std::vector<Output> hessianOutputs;
+    std::vector<std::size_t> hessianMirrors;  // Position of (k, j) for each Hessian output
+    std::vector<bool> zeroPattern;            // rows x columns
+
+    std::vector<double> values;            // One per entry
+    std::vector<std::uint32_t> errors;     // First error of each entry, 0 if none
+    // What user functions threw during the last sweep; error errorMessages.size() + i is
+    // thrownMessages[i].
+    std::vector<std::string> thrownMessages;
+    std::vector<double> callValues;
+};
+
+} // namespace Expression
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef COMPILED_EXPR_H
+#define COMPILED_EXPR_H
+
+#include "expression/node.h"
+#include "expression/function_node.h"
+
+namespace Expression {
+
+// Opcodes of the flat postorder program produced by CompiledExpr.
+enum class OpCode : std::uint8_t {
+    PushConst,  // push constants[operand]
+    LoadVar,    // push slots[operand]
+    Add,
+    Sub,
+    Mul,
+    Div,        // operand indexes the error message raised on division by zero
+    Pow,
+    Sin,
+    Cos,
+    Ln,
+    Log,        // log(base, x): base is pushed first
+    Eq,
+    Call,       // operand indexes functions; pops argCount arguments
+    StoreTemp,  // copy the top of the stack into temps[operand] without popping
+    LoadTemp    // push temps[operand]
+};
+
+struct Instruction {
+    OpCode op;
+    std::uint32_t operand;
+};
+
+struct CompiledVariable {
+    std::string name;
+    std::uint32_t slot;
+};
+
+struct CompiledFunction {
+    std::string name;
+    int argCount;
+    FunctionNode::FunctionCallback callback;
+    FunctionNode::DerivativeCallback derivative;  // May be empty
+};
+
+struct CompileOptions {
+    // Compute every distinct subexpression once per evaluation and reload it from a
+    // temporary wherever it repeats (see CsePass). Results are unchanged.
+    bool eliminateCommonSubexpressions = true;
+};
+
+class CsePass;
+
+// Lowers a Node tree into a contiguous postorder instruction array plus a constant pool,
+// and evaluates it with a switch-dispatch stack machine. Results are bit-identical to
+// Node::evaluate, including the errors raised on invalid math. The compiled program does
+// not reference the source tree, so it stays valid after the arena that built it is gone.
+class CompiledExpr {
+public:
+    explicit CompiledExpr(const Node* root, CompileOptions options = CompileOptions());
+
+    // Evaluate with variables read from slots[VariableNode::getSlot()].
+    double evaluate(const double* slots) const;
+    // Evaluate against an environment; each distinct variable is looked up once per call.
+    double evaluate(const Env &env) const;
+
+    const std::vector<Instruction>& getCode() const;
+    const std::vector<double>& getConstants() const;
+    const std::vector<CompiledVariable>& getVariables() const;
+    const std::vector<CompiledFunction>& getFunctions() const;
+    // Messages raised by Div instructions, indexed by their operand.
+    const std::vector<std::string>& getErrorMessages() const;
+    std::size_t getMaxStackDepth() const;
+    // Length of the slot array evaluate(const double*) reads (highest slot used + 1).
+    std::size_t getSlotCount() const;
+    std::size_t getTempCount() const;
+    // Nodes of the expanded source tree that are reloaded from a temporary instead of recomputed.
+    std::uint64_t getEliminatedNodeCount() const;
+
+private:
+    void lower(const Node* node, const CsePass* cse);
+    void emit(OpCode op, std::uint32_t operand, int stackEffect);
+    void recordVariable(const std::string& name, std::size_t slot);
+
+    std::vector<Instruction> code;
+    std::vector<double> constants;
+    std::vector<CompiledVariable> variables;
+    std::vector<CompiledFunction> functions;
+    std::vector<std::string> errorMessages;
+
+    std::size_t stackDepth = 0;
+    std::size_t maxStackDepth = 0;
+    std::size_t slotCount = 0;
+    std::unordered_map<std::uint32_t, std::uint32_t> tempOfValue;  // Value number -> temp, while lowering
+    std::size_t tempCount = 0;
+    std::uint64_t eliminatedNodeCount = 0;
+};
+
+} // namespace Expression
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef CPP_EMITTER_H
+#define CPP_EMITTER_H
+
+#include "expression/node.h"
+
+namespace Expression {
+
+// Emits formulas as standalone C++ functions for ahead-of-time compilation (see the
+// expr_codegen tool and expr_add_formula_library in cmake/ExprCodegen.cmake). Each formula
+// becomes straight-line code over `const double* vars`, with vars[i] the i-th listed
+// variable: every distinct subexpression is computed once into a temporary, constant
+// subtrees are folded to exact literals, and invalid math throws the same
+// std::runtime_error messages as Node::evaluate. Compiled without -ffast-math, the code
+// returns values bit-identical to Node::evaluate.
+//
+// A user function f of n arguments is called as `double f(const double* args)`, declared
+// in the generated header and defined by the program linking it. Derivatives through f
+// call its partials the same way, `double f_d0(const double* args)` and so on, which
+// needs f to have a derivative callback when the formula is differentiated.
+class CppEmitter {
+public:
+    // Functions are emitted into this namespace (may be nested, e.g. "app::formulas").
+    explicit CppEmitter(std::string nameSpace);
+
+    // double name(const double* vars)
+    void addFormula(const std::string& name, const Node* root, const std::vector<std::string>& variables);
+    // double name(const double* vars): d root / d variable, simplified.
+    void addDerivative(const std::string& name, const Node* root, const std::string& variable,
+                       const std::vector<std::string>& variables, ExprArena& arena);
+    // void name(const double* vars, double* gradient): gradient[i] = d root / d variables[i],
+    // all partials sharing their common subexpressions.
+    void addGradient(const std::string& name, const Node* root, const std::vector<std::string>& variables,
+                     ExprArena& arena);
+
+    std::size_t getFormulaCount() const;
+
+    void writeHeader(std::ostream& out, const std::string& includeGuard) const;
+    // includePath is how the source includes the header, e.g. "rule_book.h".
+    void writeSource(std::ostream& out, const std::string& includePath) const;
+
+private:
+    // Emit a function with one output per root: a return value, or gradient[i].
+    void emit(const std::string& name, const std::string& comment, const std::vector<const Node*>& outputs,
+              const std::vector<std::string>& variables, bool returnsValue);
+    Node* differentiate(const Node* root, const std::string& variable, ExprArena& arena) const;
+
+    std::string nameSpace;
+    std::string declarations;
+    std::string definitions;
+    std::unordered_set<std::string> names;
+    std::map<std::string, int> userFunctions;  // Name -> argument count
+    std::size_t formulaCount = 0;
+    bool usesPower = false;  // Some formula calls pow with a literal operand
+};
+
+} // namespace Expression
+
+#endif
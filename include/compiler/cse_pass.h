@@ -0,0 +1,58 @@
+#ifndef CSE_PASS_H
+#define CSE_PASS_H
+
+#include "compiler/node_shape.h"
+
+namespace Expression {
+
+// Common subexpression elimination by value numbering. Every node of a tree (or of a
+// hash-consed DAG) gets a value number; structurally identical subexpressions share one,
+// whether or not they are the same node. Each node is visited once, so a DAG that
+// expands to millions of tree nodes is analyzed in time linear in its distinct nodes.
+class CsePass {
+public:
+    explicit CsePass(const Node* root);
+
+    // Value number of a node reachable from the root.
+    std::uint32_t valueNumber(const Node* node) const;
+    // Whether the value is used more than once and is worth keeping in a temporary.
+    bool isShared(std::uint32_t value) const;
+
+    std::size_t getUniqueCount() const;
+    // Nodes in the fully expanded tree (saturates at UINT64_MAX).
+    std::uint64_t getTreeNodeCount() const;
+
+private:
+    struct ValueKey {
+        OpCode op;
+        std::uint64_t payload;       // Constant bits or variable slot
+        std::uint32_t operands[2];
+
+        bool operator==(const ValueKey& other) const {
+            return op == other.op && payload == other.payload &&
+                   operands[0] == other.operands[0] && operands[1] == other.operands[1];
+        }
+    };
+
+    struct ValueKeyHash {
+        std::size_t operator()(const ValueKey& key) const;
+    };
+
+    struct ValueInfo {
+        std::uint32_t uses = 0;
+        bool shareable = false;  // Leaves are cheaper to reload than to cache; calls may have side effects.
+    };
+
+    std::uint32_t number(const Node* node);
+    std::uint64_t treeSize(const Node* node);
+
+    std::unordered_map<const Node*, std::uint32_t> numbers;
+    std::unordered_map<ValueKey, std::uint32_t, ValueKeyHash> keys;
+    std::vector<ValueInfo> values;
+    std::unordered_map<const Node*, std::uint64_t> treeSizes;
+    std::uint64_t treeNodeCount = 0;
+};
+
+} // namespace Expression
+
+#endif
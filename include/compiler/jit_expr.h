@@ -0,0 +1,62 @@
+#ifndef JIT_EXPR_H
+#define JIT_EXPR_H
+
+#include "compiler/compiled_expr.h"
+
+namespace Expression {
+
+// Native x86-64 code for one expression, generated from its CompiledExpr program. The
+// value stack lives in xmm registers (spilled to the frame past a depth of 14 and around
+// calls), arithmetic is inline SSE2, and sin, cos, ln, log and pow call the same libm
+// functions Node::evaluate does, so results are bit-identical to it. Code is written to
+// a private mapping that is made executable only once complete (never writable and
+// executable at the same time).
+//
+// Where no native code can be produced (another architecture, or a system refusing
+// executable mappings) the JitExpr falls back to interpreting its CompiledExpr, with the
+// same results.
+class JitExpr {
+public:
+    // Native entry point: reads variables from slots[VariableNode::getSlot()]. Invalid math
+    // (division by zero, ln of a non-positive number, ...) and a throwing function callback
+    // return a NaN; evaluate() turns it into the exception Node::evaluate would throw.
+    using Function = double (*)(const double* slots);
+
+    explicit JitExpr(const Node* root, CompileOptions options = CompileOptions());
+    ~JitExpr();
+
+    JitExpr(JitExpr&& other) noexcept;
+    JitExpr& operator=(JitExpr&& other) noexcept;
+    JitExpr(const JitExpr&) = delete;
+    JitExpr& operator=(const JitExpr&) = delete;
+
+    // Whether this build can generate native code at all.
+    static bool isSupported();
+    // Whether this expression runs as native code rather than through the interpreter.
+    bool isNative() const;
+    // The native function, or nullptr when falling back to the interpreter.
+    Function getFunction() const;
+
+    double evaluate(const double* slots) const;
+    // Evaluate against an environment; missing variables default to 0.
+    double evaluate(const Env& env) const;
+
+    const CompiledExpr& getProgram() const;
+    // Bytes of machine code and constants (0 when not native).
+    std::size_t getCodeSize() const;
+
+private:
+    void release();
+    // A NaN result may encode an error; throw it, or return the result as it is.
+    double checkResult(double result) const;
+
+    CompiledExpr program;
+    void* code = nullptr;
+    std::size_t mappedSize = 0;
+    std::size_t codeSize = 0;
+    Function function = nullptr;
+};
+
+} // namespace Expression
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef NODE_SHAPE_H
+#define NODE_SHAPE_H
+
+#include "compiler/compiled_expr.h"
+#include "expression/variable_node.h"
+
+namespace Expression {
+
+// The opcode, payload and operands of a node, as seen by the compiler passes.
+struct NodeShape {
+    OpCode op = OpCode::PushConst;
+    double value = 0;                        // PushConst
+    const VariableNode* variable = nullptr;  // LoadVar
+    const FunctionNode* function = nullptr;  // Call; the operands are its arguments
+    std::size_t arity = 0;
+    const Node* operands[2] = {nullptr, nullptr};
+
+    const Node* operand(std::size_t i) const;
+};
+
+// Describe a node; throws for node classes the compiler does not know.
+NodeShape shapeOf(const Node* node);
+
+} // namespace Expression
+
+#endif
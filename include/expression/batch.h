@@ -0,0 +1,72 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "_pch.h"
+
+namespace Expression {
+
+class Node;
+class ThreadPool;
+
+// Rows evaluated per block. Each node runs one tight loop per block, so the virtual
+// call is amortized over this many rows while a block still fits comfortably in L1.
+constexpr std::size_t kBatchBlockSize = 256;
+
+// Rows per task of a parallel evaluateBatch: enough blocks to amortize scheduling, and
+// small enough that tens of millions of rows give every thread many tasks to balance.
+constexpr std::size_t kParallelChunkRows = 64 * kBatchBlockSize;
+
+// Struct-of-arrays input: one column of row values per variable slot.
+// Slots that are never bound read as 0, like a variable missing from an Env.
+class BatchInput {
+public:
+    explicit BatchInput(std::size_t rows);
+
+    // Bind a column holding getRows() values to a variable slot.
+    void bind(std::size_t slot, const double* column);
+
+    std::size_t getRows() const;
+    const std::vector<const double*>& getColumns() const;
+
+private:
+    std::size_t rows;
+    std::vector<const double*> columns;
+};
+
+// The rows [begin, begin + count) a node evaluates in one call.
+struct BatchBlock {
+    const double* const* columns;  // Indexed by slot, then by absolute row.
+    std::size_t columnCount;
+    std::size_t begin;
+    std::size_t count;             // At most kBatchBlockSize.
+};
+
+// Stack of block-sized buffers that binary nodes borrow for their right operand.
+// Reused across blocks and calls, so batch evaluation allocates only while warming up.
+class BatchScratch {
+public:
+    double* acquire();
+    void release();
+    void reset();
+
+private:
+    std::vector<std::unique_ptr<double[]>> blocks;
+    std::size_t used = 0;
+};
+
+// Evaluate expr over every row of input and write one result per row to out.
+// Results are bit-identical to calling evaluate(slots) row by row; on invalid math
+// the same error is raised, though not necessarily for the first failing row.
+// Batch evaluation does not record trace steps.
+void evaluateBatch(Node* expr, const BatchInput& input, double* out);
+void evaluateBatch(Node* expr, const BatchInput& input, double* out, BatchScratch& scratch);
+// The same over the threads of pool: chunks of kParallelChunkRows rows are scheduled with
+// work stealing, each thread with its own BatchScratch, and every row is written to the
+// same place as in the serial call, so the output does not depend on the thread count.
+// On invalid math the error of the lowest failing chunk is raised. expr and any function
+// callbacks in it are called from several threads at once.
+void evaluateBatch(Node* expr, const BatchInput& input, double* out, ThreadPool& pool);
+
+} // namespace Expression
+
+#endif
@@ -8,8 +8,12 @@ namespace Expression {
 // Base class for binary operations (e.g., addition, multiplication).
 class BinaryOpNode : public Node {
 public:
-    BinaryOpNode(Node* left, Node* right);
+    BinaryOpNode(NodeKind kind, Node* left, Node* right);
     virtual ~BinaryOpNode();
+    using Node::evaluate;
+
+    Node* getLeft() const;
+    Node* getRight() const;
 protected:
     Node* left;
     Node* right;
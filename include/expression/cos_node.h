@@ -8,17 +8,22 @@ namespace Expression {
 // Represents sin(x).
 class CosNode : public UnaryOpNode {
 public:
+    static constexpr NodeKind staticKind = NodeKind::Cos;
+
     explicit CosNode(Node* operand);
     virtual ~CosNode();
 
-    virtual double evaluate(const Env &env) override;
-    virtual std::string toString() const override;
+    using Node::evaluate;
+    virtual double evaluate(const double* slots) override;
+    virtual void evaluateBatch(const BatchBlock& block, double* out, BatchScratch& scratch) override;
 
     // **New symbolic methods**
-    virtual Node* simplify() const override;
-    virtual Node* derivative(const std::string& variable) const override;
-    virtual Node* substitute(const std::string& variable, Node* value) const override;
-    virtual Node* clone() const override;
+    virtual Node* substitute(const std::string& variable, Node* value, ExprArena& arena) const override;
+    virtual Node* clone(ExprArena& arena) const override;
+
+protected:
+    virtual Node* simplifyImpl(ExprArena& arena) const override;
+    virtual Node* derivativeImpl(const std::string& variable, ExprArena& arena) const override;
 };
 
 } // namespace Expression
@@ -8,20 +8,28 @@ namespace Expression {
 // EqualityNode represents an equation (e.g., A == B).
 class EqualityNode : public Node {
 public:
+    static constexpr NodeKind staticKind = NodeKind::Equality;
+
     EqualityNode(Node* left, Node* right);
     virtual ~EqualityNode();
 
-    virtual double evaluate(const Env &env) override;
-    virtual std::string toString() const override;
+    using Node::evaluate;
+    virtual double evaluate(const double* slots) override;
+    virtual void evaluateBatch(const BatchBlock& block, double* out, BatchScratch& scratch) override;
 
     // **New symbolic methods**
-    virtual Node* simplify() const override;
-    virtual Node* derivative(const std::string& variable) const override;
-    virtual Node* substitute(const std::string& variable, Node* value) const override;
-    virtual Node* clone() const override;
+    virtual Node* substitute(const std::string& variable, Node* value, ExprArena& arena) const override;
+    virtual Node* clone(ExprArena& arena) const override;
     
     // **Equation Solving**
-    virtual Node* solveFor(const std::string& variable) const;
+    virtual Node* solveFor(const std::string& variable, ExprArena& arena) const;
+
+    Node* getLeft() const;
+    Node* getRight() const;
+
+protected:
+    virtual Node* simplifyImpl(ExprArena& arena) const override;
+    virtual Node* derivativeImpl(const std::string& variable, ExprArena& arena) const override;
 
 private:
     Node* left;
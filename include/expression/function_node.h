@@ -8,25 +8,56 @@ namespace Expression {
 // Function nodes now support an arbitrary number of arguments with an exact argument count.
 class FunctionNode : public Node {
 public:
+    static constexpr NodeKind staticKind = NodeKind::Function;
+    static constexpr bool ownsResources = true;
+
     using FunctionCallback = std::function<double(const std::vector<double>&)>;
+    // Partial derivative of the function with respect to argument `index` at `args`.
+    // Optional; derivative() and automatic differentiation through a call need it.
+    using DerivativeCallback = std::function<double(const std::vector<double>& args, std::size_t index)>;
+
+    // Both callbacks of a function. simplify, substitute, clone and the rewriter pass the
+    // same block on to the nodes they build, so its address identifies the function
+    // (structurallyEqual) where the name alone does not.
+    struct Callbacks {
+        FunctionCallback callback;
+        DerivativeCallback derivative;
+    };
 
-    FunctionNode(const std::string& name, int expectedArgCount, const std::vector<Node*>& arguments, FunctionCallback callback);
+    FunctionNode(const std::string& name, int expectedArgCount, const std::vector<Node*>& arguments, FunctionCallback callback,
+                 DerivativeCallback derivativeCallback = nullptr);
+    FunctionNode(const std::string& name, int expectedArgCount, const std::vector<Node*>& arguments,
+                 std::shared_ptr<const Callbacks> callbacks);
     virtual ~FunctionNode();
 
-    virtual double evaluate(const Env &env) override;
-    virtual std::string toString() const override;
+    using Node::evaluate;
+    virtual double evaluate(const double* slots) override;
+    virtual void evaluateBatch(const BatchBlock& block, double* out, BatchScratch& scratch) override;
 
     // **New symbolic methods**
-    virtual Node* simplify() const override;
-    virtual Node* derivative(const std::string& variable) const override;
-    virtual Node* substitute(const std::string& variable, Node* value) const override;
-    virtual Node* clone() const override;
+    virtual Node* substitute(const std::string& variable, Node* value, ExprArena& arena) const override;
+    virtual Node* clone(ExprArena& arena) const override;
+
+    const std::string& getName() const;
+    int getExpectedArgCount() const;
+    const std::vector<Node*>& getArguments() const;
+    const FunctionCallback& getCallback() const;
+    const DerivativeCallback& getDerivativeCallback() const;
+    const std::shared_ptr<const Callbacks>& getCallbacks() const;
+
+protected:
+    virtual Node* simplifyImpl(ExprArena& arena) const override;
+    // Chain rule over calls to <name>_d<i>, which evaluate the derivative callback and
+    // have none themselves; throws without a callback if an argument depends on variable.
+    virtual Node* derivativeImpl(const std::string& variable, ExprArena& arena) const override;
 
 private:
+    static std::uint64_t hashOf(const std::string& name, const std::vector<Node*>& arguments);
+
     std::string name;
     int expectedArgCount;
     std::vector<Node*> arguments;
-    FunctionCallback callback;
+    std::shared_ptr<const Callbacks> callbacks;
 };
 
 } // namespace Expression
@@ -3,25 +3,115 @@
 
 #include "_pch.h"
 #include "tracing/trace.h"
+#include "expression/symbol_table.h"
+#include "expression/batch.h"
 
 namespace Expression {
 
-using Env = std::unordered_map<std::string, double>;
+class ExprArena;
+
+// Concrete node class, stored in every node at construction so that pattern
+// matching in the rewrite code is an integer compare instead of an RTTI walk.
+enum class NodeKind : std::uint8_t {
+    Number,
+    Variable,
+    Addition,
+    Subtraction,
+    Multiplication,
+    Division,
+    Exponentiation,
+    Sin,
+    Cos,
+    Ln,
+    Log,
+    Equality,
+    Function
+};
+
+constexpr std::size_t kNodeKindCount = static_cast<std::size_t>(NodeKind::Function) + 1;
 
 // Abstract base class for all expression nodes.
 class Node {
 public:
+    // Whether the destructor releases memory (strings, vectors, callbacks). ExprArena only
+    // runs destructors of node types that set this; others are reclaimed with their chunk.
+    static constexpr bool ownsResources = false;
+
+    Node(NodeKind kind, std::uint64_t structuralHash);
     virtual ~Node();
-    // Evaluate the expression represented by this node.
-    virtual double evaluate(const Env &env) = 0;
-    // Return a string representation of the node.
-    virtual std::string toString() const = 0;
+
+    NodeKind getKind() const { return kind; }
+    // Hash of the node's kind, payload and children, computed bottom-up at construction.
+    // Structurally equal trees hash equally, whichever arena built them.
+    std::uint64_t getStructuralHash() const { return structuralHash; }
+
+    // Cheap kind checks: node->is<NumberNode>() and node->as<NumberNode>() (nullptr on mismatch).
+    template<typename T>
+    bool is() const { return kind == T::staticKind; }
+    template<typename T>
+    T* as() { return is<T>() ? static_cast<T*>(this) : nullptr; }
+    template<typename T>
+    const T* as() const { return is<T>() ? static_cast<const T*>(this) : nullptr; }
+
+    // Evaluate the expression against an environment. Thin adapter over
+    // evaluate(const double*): one lookup per distinct variable of this tree, missing
+    // variables reading 0. Subclasses re-export it with `using Node::evaluate;`.
+    double evaluate(const Env &env);
+    // Evaluate the expression with variables read from slots[VariableNode::getSlot()].
+    virtual double evaluate(const double* slots) = 0;
+    // Evaluate one block of rows into out[0, block.count); driven by evaluateBatch in batch.h.
+    virtual void evaluateBatch(const BatchBlock& block, double* out, BatchScratch& scratch) = 0;
+    // Fully parenthesized text of the tree, e.g. "((x ^ 2) + sin(y))"; see ExprPrinter.
+    std::string toString() const;
 
     // **NEW METHODS FOR SYMBOLIC COMPUTATION**
-    virtual Node* simplify() const = 0;  // Simplify the expression if possible.
-    virtual Node* derivative(const std::string& variable) const = 0;  // Compute derivative w.r.t a variable.
-    virtual Node* substitute(const std::string& variable, Node* value) const = 0;  // Substitute a variable with an expression.
-    virtual Node* clone() const = 0;  // Deep copy of this node.
+    // Every node these create, intermediates included, is allocated in the given arena,
+    // so a whole rewrite session is released at once when that arena is reset or destroyed.
+    // simplify and derivative consult the arena's SymbolicCache, if one is attached, before
+    // doing the work in simplifyImpl / derivativeImpl, and remember what those return.
+    Node* simplify(ExprArena& arena) const;  // Simplify the expression if possible.
+    Node* derivative(const std::string& variable, ExprArena& arena) const;  // Compute derivative w.r.t a variable.
+    virtual Node* substitute(const std::string& variable, Node* value, ExprArena& arena) const = 0;  // Substitute a variable with an expression.
+    virtual Node* clone(ExprArena& arena) const = 0;  // Deep copy of this node.
+
+protected:
+    virtual Node* simplifyImpl(ExprArena& arena) const = 0;
+    virtual Node* derivativeImpl(const std::string& variable, ExprArena& arena) const = 0;
+
+    // Building blocks for the hash each node class passes to the constructor above.
+    // Mixing is order-sensitive, so a - b and b - a hash differently.
+    static std::uint64_t hashSeed(NodeKind kind) {
+        return combineHash(0x6A09E667F3BCC909ULL, static_cast<std::uint64_t>(kind));
+    }
+    static std::uint64_t combineHash(std::uint64_t seed, std::uint64_t value) {
+        std::uint64_t x = seed ^ (value + 0x9E3779B97F4A7C15ULL + (seed << 6) + (seed >> 2));
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDULL;
+        x ^= x >> 33;
+        x *= 0xC4CEB9FE1A85EC53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+private:
+    const NodeKind kind;
+    const std::uint64_t structuralHash;
+};
+
+// Whether two trees have the same shape, operators, constants (compared bit for bit),
+// variable names and function names. Trees whose hashes differ are rejected at once, and
+// shared subtrees (the same node on both sides) are not descended into. Function nodes
+// must also share their callbacks (FunctionNode::getCallbacks): two calls to one name
+// with different callbacks are different values.
+bool structurallyEqual(const Node* a, const Node* b);
+
+// Hash and equality functors keying unordered containers by tree structure.
+struct NodeHash {
+    std::size_t operator()(const Node* node) const { return static_cast<std::size_t>(node->getStructuralHash()); }
+};
+
+struct NodeEqual {
+    bool operator()(const Node* a, const Node* b) const { return structurallyEqual(a, b); }
 };
 
 } // namespace Expression
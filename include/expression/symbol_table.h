@@ -0,0 +1,39 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include "_pch.h"
+#include <deque>
+
+namespace Expression {
+
+using Env = std::unordered_map<std::string, double>;
+
+// Binds variable names to dense slot indices. Names are resolved once, when a
+// VariableNode is built, so evaluation reads variables from a plain double array.
+class SymbolTable {
+public:
+    // Return the slot bound to name, binding the next free slot if it is new.
+    std::size_t intern(const std::string& name);
+
+    bool contains(const std::string& name) const;
+
+    // Return the slot bound to name; throws if the name was never interned.
+    std::size_t lookup(const std::string& name) const;
+
+    const std::string& nameOf(std::size_t slot) const;
+
+    // Number of slots, i.e. the length of the array evaluate(const double*) reads.
+    std::size_t size() const;
+
+    // Resolve an environment into a slot array. Missing variables default to 0.
+    std::vector<double> bind(const Env& env) const;
+    void bind(const Env& env, double* slots) const;
+
+private:
+    std::unordered_map<std::string, std::size_t> slots;
+    std::deque<std::string> names;  // Deque keeps references from nameOf stable.
+};
+
+} // namespace Expression
+
+#endif
@@ -8,8 +8,11 @@ namespace Expression {
 // Base class for unary operations (e.g., sin, cos, negation).
 class UnaryOpNode : public Node {
 public:
-    explicit UnaryOpNode(Node* operand);
+    UnaryOpNode(NodeKind kind, Node* operand);
     virtual ~UnaryOpNode();
+    using Node::evaluate;
+
+    Node* getOperand() const;
 protected:
     Node* operand;
 };
@@ -8,20 +8,30 @@ namespace Expression {
 // Variable nodes represent named values.
 class VariableNode : public Node {
 public:
-    explicit VariableNode(const std::string& name);
+    static constexpr NodeKind staticKind = NodeKind::Variable;
+    static constexpr bool ownsResources = true;
+
+    VariableNode(const std::string& name, std::size_t slot);
     virtual ~VariableNode();
 
-    virtual double evaluate(const Env &env) override;
-    virtual std::string toString() const override;
+    using Node::evaluate;
+    virtual double evaluate(const double* slots) override;
+    virtual void evaluateBatch(const BatchBlock& block, double* out, BatchScratch& scratch) override;
 
     // **New symbolic methods**
-    virtual Node* simplify() const override;
-    virtual Node* derivative(const std::string& variable) const override;
-    virtual Node* substitute(const std::string& variable, Node* value) const override;
-    virtual Node* clone() const override;
+    virtual Node* substitute(const std::string& variable, Node* value, ExprArena& arena) const override;
+    virtual Node* clone(ExprArena& arena) const override;
+
+    const std::string& getName() const;
+    std::size_t getSlot() const;
+
+protected:
+    virtual Node* simplifyImpl(ExprArena& arena) const override;
+    virtual Node* derivativeImpl(const std::string& variable, ExprArena& arena) const override;
 
 private:
     std::string name;
+    std::size_t slot;
 };
 
 } // namespace Expression
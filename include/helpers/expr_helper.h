@@ -18,35 +18,79 @@
 
 namespace Expression {
 
+// Builds nodes in an arena. With the arena's hash-consing on, every node returned is
+// interned: structurally identical subexpressions come back as the same node.
 class ExprHelper {
 private:
     ExprArena& arena;  // Reference to memory arena
 
+    template<typename T>
+    Node* binary(Node* left, Node* right) {
+        return arena.intern<T>(InternKey{internTag<T>(), {left, right}, 0}, left, right);
+    }
+
+    template<typename T>
+    Node* unary(Node* operand) {
+        return arena.intern<T>(InternKey{internTag<T>(), {operand, nullptr}, 0}, operand);
+    }
+
 public:
     explicit ExprHelper(ExprArena& a) : arena(a) {}
 
+    ExprArena& getArena() { return arena; }
+
     // Number & Variable Nodes
-    Node* num(double value) { return arena.make<NumberNode>(value); }
-    Node* var(const std::string &name) { return arena.make<VariableNode>(name); }
+    Node* num(double value) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return arena.intern<NumberNode>(InternKey{internTag<NumberNode>(), {nullptr, nullptr}, bits}, value);
+    }
+    Node* var(const std::string &name) {
+        std::size_t slot = arena.getSymbols().intern(name);
+        return arena.intern<VariableNode>(InternKey{internTag<VariableNode>(), {nullptr, nullptr}, slot}, name, slot);
+    }
 
     // Binary Operations
-    Node* add(Node* left, Node* right) { return arena.make<AdditionNode>(left, right); }
-    Node* sub(Node* left, Node* right) { return arena.make<SubtractionNode>(left, right); }
-    Node* mul(Node* left, Node* right) { return arena.make<MultiplicationNode>(left, right); }
-    Node* div(Node* left, Node* right) { return arena.make<DivisionNode>(left, right); }
-    Node* exp(Node* base, Node* exponent) { return arena.make<ExponentiationNode>(base, exponent); }
+    Node* add(Node* left, Node* right) { return binary<AdditionNode>(left, right); }
+    Node* sub(Node* left, Node* right) { return binary<SubtractionNode>(left, right); }
+    Node* mul(Node* left, Node* right) { return binary<MultiplicationNode>(left, right); }
+    Node* div(Node* left, Node* right) { return binary<DivisionNode>(left, right); }
+    Node* exp(Node* base, Node* exponent) { return binary<ExponentiationNode>(base, exponent); }
 
     // Unary Operations
-    Node* sin(Node* operand) { return arena.make<SinNode>(operand); }
-    Node* cos(Node* operand) { return arena.make<CosNode>(operand); }
-    Node* ln(Node* operand) { return arena.make<LnNode>(operand); }
-    Node* log(Node* base, Node* operand) { return arena.make<LogNode>(base, operand); }
+    Node* sin(Node* operand) { return unary<SinNode>(operand); }
+    Node* cos(Node* operand) { return unary<CosNode>(operand); }
+    Node* ln(Node* operand) { return unary<LnNode>(operand); }
+    Node* log(Node* base, Node* operand) { return binary<LogNode>(base, operand); }
+
+    // Operator node of the given kind; leaves and functions have their own builders.
+    Node* build(NodeKind kind, Node* left, Node* right = nullptr) {
+        switch (kind) {
+        case NodeKind::Addition: return add(left, right);
+        case NodeKind::Subtraction: return sub(left, right);
+        case NodeKind::Multiplication: return mul(left, right);
+        case NodeKind::Division: return div(left, right);
+        case NodeKind::Exponentiation: return exp(left, right);
+        case NodeKind::Log: return log(left, right);
+        case NodeKind::Equality: return eq(left, right);
+        case NodeKind::Sin: return sin(left);
+        case NodeKind::Cos: return cos(left);
+        case NodeKind::Ln: return ln(left);
+        default: throw std::runtime_error("ExprHelper::build expects an operator kind.");
+        }
+    }
 
     // Equality & Functions
-    Node* eq(Node* left, Node* right) { return arena.make<EqualityNode>(left, right); }
+    Node* eq(Node* left, Node* right) { return binary<EqualityNode>(left, right); }
+    // Function nodes are never shared: their callbacks cannot be compared.
+    Node* func(const std::string &name, int expectedArgCount, const std::vector<Node*>& args,
+               FunctionNode::FunctionCallback callback, FunctionNode::DerivativeCallback derivative = nullptr) {
+        return arena.make<FunctionNode>(name, expectedArgCount, args, callback, derivative);
+    }
+    // Another call to the function whose callbacks are given (FunctionNode::getCallbacks).
     Node* func(const std::string &name, int expectedArgCount, const std::vector<Node*>& args,
-               FunctionNode::FunctionCallback callback) {
-        return arena.make<FunctionNode>(name, expectedArgCount, args, callback);
+               std::shared_ptr<const FunctionNode::Callbacks> callbacks) {
+        return arena.make<FunctionNode>(name, expectedArgCount, args, std::move(callbacks));
     }
 };
 
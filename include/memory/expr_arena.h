@@ -5,31 +5,146 @@
 
 namespace Expression {
 
-class ExprArena {
-private:
-    std::vector<Node*> allocatedNodes;  // Tracks all allocated nodes
+class SymbolicCache;
+
+// Identity of a node for hash-consing: its class, its children and its payload
+// (the bits of a constant or the slot of a variable).
+struct InternKey {
+    const void* type;
+    const Node* children[2];
+    std::uint64_t payload;
+
+    bool operator==(const InternKey& other) const {
+        return type == other.type && children[0] == other.children[0] &&
+               children[1] == other.children[1] && payload == other.payload;
+    }
+};
+
+struct InternKeyHash {
+    std::size_t operator()(const InternKey& key) const {
+        std::size_t h = std::hash<const void*>()(key.type);
+        h ^= std::hash<const void*>()(key.children[0]) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        h ^= std::hash<const void*>()(key.children[1]) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        h ^= std::hash<std::uint64_t>()(key.payload) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        return h;
+    }
+};
 
+// Unique tag per node class, used as InternKey::type.
+template<typename T>
+const void* internTag() {
+    static const char tag = 0;
+    return &tag;
+}
+
+// Bump-pointer arena for expression nodes. Nodes are carved from large contiguous
+// chunks, so a tree built in one go sits densely in memory, and tearing it down
+// frees chunks rather than nodes. Only node types that declare ownsResources have
+// their destructors run; every other node is reclaimed together with its chunk.
+class ExprArena {
 public:
-    ExprArena() = default;
-    
+    static constexpr std::size_t kDefaultChunkSize = 64 * 1024;
+
+    explicit ExprArena(std::size_t chunkSize = kDefaultChunkSize);
+
     // Prevent copying (ensures unique ownership)
     ExprArena(const ExprArena&) = delete;
     ExprArena& operator=(const ExprArena&) = delete;
 
-    // Destructor: Automatically deletes all stored nodes
-    ~ExprArena() {
-        for (Node* node : allocatedNodes) {
-            delete node;
+    // Destructor: destroys resource-owning nodes, then releases every chunk
+    ~ExprArena();
+
+    // Allocate and construct a new Node inside the arena
+    template<typename T, typename... Args>
+    T* make(Args&&... args) {
+        void* memory = allocate(sizeof(T), alignof(T));
+        T* node = new (memory) T(std::forward<Args>(args)...);
+        if constexpr (T::ownsResources) {
+            finalizers.push_back({[](void* p) { static_cast<T*>(p)->~T(); }, node});
         }
+        ++allocationCount;
+        return node;
     }
 
-    // Allocate and store a new Node
+    // Return the node already built here under key, or make a new one and remember it.
+    // Children must themselves be interned for structurally equal trees to share nodes.
     template<typename T, typename... Args>
-    T* make(Args&&... args) {
-        T* node = new T(std::forward<Args>(args)...);
-        allocatedNodes.push_back(node);
+    T* intern(const InternKey& key, Args&&... args) {
+        if (!hashConsing) {
+            return make<T>(std::forward<Args>(args)...);
+        }
+        auto it = internTable.find(key);
+        if (it != internTable.end()) {
+            ++internHits;
+            return static_cast<T*>(it->second);
+        }
+        T* node = make<T>(std::forward<Args>(args)...);
+        internTable.emplace(key, node);
         return node;
     }
+
+    // **Hash-consing**
+    // On by default: ExprHelper then returns the existing node for any structure already
+    // built in this arena, so identical subexpressions form a single DAG node and two
+    // interned nodes are structurally equal exactly when their pointers are equal.
+    void setHashConsing(bool enabled);
+    bool isHashConsing() const;
+
+    // Raw aligned storage from the current chunk; opens a new chunk when it is full.
+    void* allocate(std::size_t size, std::size_t alignment);
+
+    // Destroy every node and rewind to the first chunk without freeing any chunk.
+    // The symbol table is kept, so slots bound before the reset stay valid.
+    void reset();
+
+    // **Symbolic cache**
+    // Memo consulted by Node::simplify and Node::derivative when they build into this
+    // arena; not owned, nullptr to detach. A cache serves one arena: attaching one that is
+    // attached elsewhere throws. Detaching (or attaching another) and reset() invalidate
+    // it, since the cached results live here.
+    void setSymbolicCache(SymbolicCache* cache);
+    SymbolicCache* getSymbolicCache() const;
+
+    // Symbol table binding the variables of trees built in this arena to slots
+    SymbolTable& getSymbols() { return symbols; }
+    const SymbolTable& getSymbols() const { return symbols; }
+
+    // **Statistics**
+    std::size_t getBytesUsed() const;       // Bytes handed out since the last reset, padding included
+    std::size_t getBytesReserved() const;   // Total capacity of all chunks
+    std::size_t getChunkCount() const;
+    std::size_t getChunkSize() const;
+    std::size_t getAllocationCount() const; // Nodes made since the last reset
+    std::size_t getInternHits() const;      // Node requests answered by an existing node
+
+private:
+    struct Chunk {
+        std::unique_ptr<unsigned char[]> memory;
+        std::size_t size;
+    };
+
+    struct Finalizer {
+        void (*destroy)(void*);
+        void* object;
+    };
+
+    void* allocateFromChunk(std::size_t size, std::size_t alignment);
+    void runFinalizers();
+
+    std::size_t chunkSize;
+    std::vector<Chunk> chunks;
+    std::size_t currentChunk = 0;   // Index of the chunk being carved
+    std::size_t offset = 0;         // First free byte in the current chunk
+    std::size_t bytesUsed = 0;
+    std::size_t allocationCount = 0;
+
+    bool hashConsing = true;
+    std::unordered_map<InternKey, Node*, InternKeyHash> internTable;
+    std::size_t internHits = 0;
+
+    SymbolicCache* symbolicCache = nullptr;
+    std::vector<Finalizer> finalizers;  // Resource-owning nodes, destroyed in reverse order
+    SymbolTable symbols;                // Variable slots shared by every node built here
 };
 
 }  // namespace Expression
@@ -0,0 +1,89 @@
+#ifndef SYMBOLIC_CACHE_H
+#define SYMBOLIC_CACHE_H
+
+#include "expression/node.h"
+#include <list>
+
+namespace Expression {
+
+struct SymbolicCacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+};
+
+// Bounded LRU memo of simplify() and derivative() results. Attach it to an arena with
+// ExprArena::setSymbolicCache; Node::simplify and Node::derivative building into that
+// arena then look a subtree up before recursing into it and remember what they built,
+// so a subtree that recurs (within one tree, or across calls such as the rows of a
+// Hessian) is processed once.
+//
+// Keys are structural (NodeHash / NodeEqual) plus, for derivatives, the variable. The
+// cache holds pointers to the source subtrees and to results in the arena, so it serves
+// one arena at a time: attaching it to a second arena throws, and the arena invalidates
+// it on reset() and on detach. It must be invalidated by hand if source trees from
+// another arena are destroyed while it is in use.
+class SymbolicCache {
+public:
+    static constexpr std::size_t kDefaultCapacity = 1 << 16;
+
+    explicit SymbolicCache(std::size_t capacity = kDefaultCapacity);
+    // Detaches from the arena it is attached to, if any.
+    ~SymbolicCache();
+
+    SymbolicCache(const SymbolicCache&) = delete;
+    SymbolicCache& operator=(const SymbolicCache&) = delete;
+
+    // Cached result for node, or nullptr. A hit makes the entry the most recently used.
+    Node* findSimplified(const Node* node);
+    Node* findDerivative(const Node* node, const std::string& variable);
+    // Remember a result, evicting the least recently used entry when full.
+    void storeSimplified(const Node* node, Node* result);
+    void storeDerivative(const Node* node, const std::string& variable, Node* result);
+
+    // Drop every entry; the statistics are kept.
+    void invalidate();
+
+    std::size_t size() const;
+    std::size_t getCapacity() const;
+    // The arena the cache is attached to, or nullptr.
+    ExprArena* getArena() const;
+    const SymbolicCacheStats& getStats() const;
+    void resetStats();
+
+private:
+    friend class ExprArena;  // Sets arena on attach and detach
+
+    struct Key {
+        const Node* node;
+        const std::string* variable;  // Points into the entry's own copy; nullptr for simplify
+    };
+
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const;
+    };
+
+    struct KeyEqual {
+        bool operator()(const Key& a, const Key& b) const;
+    };
+
+    struct Entry {
+        const Node* node;
+        std::string variable;
+        bool isDerivative;
+        Node* result;
+    };
+
+    Node* find(const Key& key);
+    void store(const Node* node, const std::string* variable, Node* result);
+
+    std::size_t capacity;
+    std::list<Entry> entries;  // Most recently used first
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash, KeyEqual> index;
+    SymbolicCacheStats stats;
+    ExprArena* arena = nullptr;
+};
+
+} // namespace Expression
+
+#endif
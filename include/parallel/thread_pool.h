@@ -0,0 +1,73 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "_pch.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace Expression {
+
+// Fixed set of worker threads running index-space loops with work stealing. Each loop
+// starts with the tasks split into one contiguous range per worker, so neighbouring tasks
+// stay on one thread; a worker that runs dry steals the back half of another worker's
+// remaining range. The thread calling parallelFor works as worker 0, so a pool of one
+// thread runs everything inline.
+class ThreadPool {
+public:
+    // threads == 0 uses std::thread::hardware_concurrency().
+    explicit ThreadPool(std::size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t getThreadCount() const;
+
+    // Run body(task, worker) for every task in [0, taskCount) and return once all have
+    // finished. worker is in [0, getThreadCount()) and no two bodies running at the same
+    // time share it, so it can index per-thread state. If bodies throw, tasks after the
+    // lowest-numbered failing task may be skipped and that task's exception is rethrown,
+    // so the error reported does not depend on scheduling. Calls are serialized.
+    void parallelFor(std::size_t taskCount, const std::function<void(std::size_t task, std::size_t worker)>& body);
+
+    // Ranges taken from another worker since the pool was created.
+    std::uint64_t getStealCount() const;
+
+private:
+    // Remaining tasks [begin, end) of one worker; padded so workers do not share a line.
+    struct alignas(64) WorkQueue {
+        std::mutex mutex;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+    };
+
+    void workerLoop(std::size_t worker);
+    void drain(std::size_t worker);
+    bool popOwn(std::size_t worker, std::size_t& task);
+    bool steal(std::size_t worker, std::size_t& task);
+    void runTask(std::size_t task, std::size_t worker);
+
+    std::size_t threadCount;
+    std::unique_ptr<WorkQueue[]> queues;
+    std::vector<std::thread> threads;  // Workers 1 .. threadCount - 1
+
+    std::mutex stateMutex;
+    std::condition_variable wake;       // A new loop was posted, or the pool is stopping
+    std::condition_variable finished;   // The last worker of a loop went idle
+    std::uint64_t generation = 0;
+    std::size_t busyWorkers = 0;
+    bool stopping = false;
+    const std::function<void(std::size_t, std::size_t)>* body = nullptr;
+
+    std::mutex submitMutex;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    std::atomic<std::size_t> failedTask{0};  // Lowest failing task of the current loop
+    std::atomic<std::uint64_t> steals{0};
+};
+
+} // namespace Expression
+
+#endif
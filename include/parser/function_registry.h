@@ -0,0 +1,30 @@
+#ifndef FUNCTION_REGISTRY_H
+#define FUNCTION_REGISTRY_H
+
+#include "expression/function_node.h"
+
+namespace Expression {
+
+struct FunctionDefinition {
+    int argCount;
+    std::shared_ptr<const FunctionNode::Callbacks> callbacks;  // The derivative may be empty
+};
+
+// User functions that text can call by name, e.g. "hypot(x, y)". The built-in
+// sin, cos, ln and log are handled by the parser itself and cannot be registered.
+class FunctionRegistry {
+public:
+    void add(const std::string& name, int argCount, FunctionNode::FunctionCallback callback,
+             FunctionNode::DerivativeCallback derivative = nullptr);
+
+    // The definition registered under name, or nullptr.
+    const FunctionDefinition* find(std::string_view name) const;
+    std::size_t size() const;
+
+private:
+    std::map<std::string, FunctionDefinition, std::less<>> definitions;
+};
+
+} // namespace Expression
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef PARSER_H
+#define PARSER_H
+
+#include "helpers/expr_helper.h"
+#include "parser/function_registry.h"
+
+namespace Expression {
+
+// Raised for malformed input; getPosition() is the byte offset of the offending token.
+class ParseError : public std::runtime_error {
+public:
+    ParseError(const std::string& message, std::size_t position);
+
+    std::size_t getPosition() const;
+
+private:
+    std::size_t position;
+};
+
+// Precedence-climbing parser producing trees in an ExprArena, in the syntax toString() prints:
+//
+//   expression := sum ('==' sum)*
+//   sum        := product (('+' | '-') product)*
+//   product    := unary (('*' | '/') unary)*
+//   unary      := ('-' | '+') unary | power
+//   power      := primary ('^' unary)?            right-associative: 2^3^2 = 2^(3^2)
+//   primary    := number | name | name '(' arguments ')' | '(' expression ')'
+//
+// Built-in calls are sin(x), cos(x), ln(x) and log(base, x); other calls resolve through
+// the FunctionRegistry, and any other name is a variable. Unary minus binds looser than
+// '^' (-x^2 is -(x^2)), folds into a literal (-3 is the number -3) and otherwise becomes
+// -1 * x. The text is scanned in place: the only heap allocations are the arena's own
+// (node chunks and intern entries), variable names too long for the small-string buffer,
+// and the argument list each user function call stores.
+class Parser {
+public:
+    explicit Parser(ExprArena& arena, const FunctionRegistry* functions = nullptr);
+
+    Node* parse(std::string_view text);
+
+private:
+    enum class TokenKind {
+        End,
+        Number,
+        Name,
+        Plus,
+        Minus,
+        Star,
+        Slash,
+        Caret,
+        EqualEqual,
+        LeftParen,
+        RightParen,
+        Comma
+    };
+
+    struct Token {
+        TokenKind kind;
+        std::size_t position;
+        std::string_view text;
+        double value;
+    };
+
+    void advance();
+    void expect(TokenKind kind, const char* what);
+    [[noreturn]] void fail(const std::string& message, std::size_t position) const;
+
+    Node* parseExpression(int minPrecedence);
+    Node* parseUnary();
+    Node* parsePrimary();
+    Node* parseCall(const Token& name);
+
+    ExprHelper e;
+    const FunctionRegistry* functions;
+
+    std::string_view input;
+    std::size_t cursor = 0;
+    Token current{TokenKind::End, 0, {}, 0};
+    std::vector<Node*> argumentStack;  // Arguments of the calls being parsed, innermost last
+};
+
+} // namespace Expression
+
+#endif
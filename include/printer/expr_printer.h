@@ -0,0 +1,41 @@
+#ifndef EXPR_PRINTER_H
+#define EXPR_PRINTER_H
+
+#include "expression/node.h"
+
+namespace Expression {
+
+struct PrintOptions {
+    // Drop parentheses that the precedence and associativity of the parser make redundant:
+    // "x + y * z" instead of "(x + (y * z))". Either form parses back to the same tree.
+    bool minimalParentheses = false;
+    // Significant digits of numbers (6 matches the default of std::ostream).
+    int precision = 6;
+};
+
+// Writes a whole tree into one output buffer in a single pass; numbers are formatted with
+// std::to_chars. With default options the text is exactly what Node::toString() returns.
+class ExprPrinter {
+public:
+    explicit ExprPrinter(PrintOptions options = PrintOptions());
+
+    // Print into the printer's buffer, reused across calls. The view stays valid until
+    // the next print on this printer.
+    std::string_view print(const Node* root);
+    // Append the text of root to out.
+    void append(const Node* root, std::string& out) const;
+
+    static std::string toString(const Node* root, PrintOptions options = PrintOptions());
+    static void appendNumber(double value, int precision, std::string& out);
+
+private:
+    void write(const Node* node, std::string& out) const;
+    void writeOperand(const Node* operand, int parentPrecedence, bool parenthesizeEqual, std::string& out) const;
+
+    PrintOptions options;
+    std::string buffer;
+};
+
+} // namespace Expression
+
+#endif
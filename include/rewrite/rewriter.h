@@ -0,0 +1,58 @@
+#ifndef REWRITER_H
+#define REWRITER_H
+
+#include "rewrite/rule_registry.h"
+
+namespace Expression {
+
+struct RewriteOptions {
+    // Try only the rules registered for a node's kind instead of scanning every rule.
+    bool indexByKind = true;
+    // Remember normal forms and return them without revisiting. Lookups are structural
+    // (NodeHash / NodeEqual), so repeated subtrees hit even with hash-consing off.
+    bool cacheNormalForms = true;
+    // Rule applications allowed per rewrite() before giving up on a non-terminating rule set.
+    std::uint64_t maxSteps = 10000000;
+};
+
+struct RewriteStats {
+    std::uint64_t nodesVisited = 0;   // Nodes whose rules were run
+    std::uint64_t rulesTried = 0;     // Rules examined, matching or not
+    std::uint64_t rulesApplied = 0;
+    std::uint64_t cacheHits = 0;      // Visits answered by the normal-form cache
+};
+
+// Rewrites an expression bottom-up with a RuleRegistry until no rule applies anywhere.
+// Children are normalized first; whenever a rule fires, its result is normalized again,
+// so the returned tree is a fixpoint of the rule set. Results are built in the arena.
+class Rewriter {
+public:
+    Rewriter(const RuleRegistry& rules, ExprArena& arena, RewriteOptions options = RewriteOptions());
+
+    Node* rewrite(const Node* root);
+
+    const RewriteStats& getStats() const;
+    // Forget cached normal forms; required after the target arena has been reset.
+    void clearCache();
+
+private:
+    Node* normalize(const Node* node);
+    Node* rebuild(const Node* node);
+    Node* applyFirst(Node* node);
+
+    const RuleRegistry& rules;
+    ExprHelper e;
+    RewriteOptions options;
+    RewriteStats stats;
+    std::uint64_t steps = 0;
+
+    // Nodes of the target arena, compared by structure; clearCache() must follow a reset of that arena.
+    std::unordered_set<const Node*, NodeHash, NodeEqual> normalForms;
+    // Input subtree -> its normal form, compared by structure. The keys are input nodes, so
+    // the map only lives for one rewrite() call, while the caller keeps them alive.
+    std::unordered_map<const Node*, Node*, NodeHash, NodeEqual> rewritten;
+};
+
+} // namespace Expression
+
+#endif
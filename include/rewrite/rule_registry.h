@@ -0,0 +1,42 @@
+#ifndef RULE_REGISTRY_H
+#define RULE_REGISTRY_H
+
+#include "expression/node.h"
+#include "helpers/expr_helper.h"
+
+namespace Expression {
+
+// A rewrite rule matches nodes of one kind. apply() returns the replacement built with
+// the helper, or nullptr when the rule does not match. Rules must make progress (shrink
+// the tree or move it towards a canonical order) so that rewriting terminates.
+struct RewriteRule {
+    using Apply = std::function<Node*(Node* node, ExprHelper& e)>;
+
+    std::string name;
+    NodeKind root;
+    Apply apply;
+};
+
+// Rules indexed by the kind of node they match, in registration order.
+class RuleRegistry {
+public:
+    void add(const std::string& name, NodeKind root, RewriteRule::Apply apply);
+
+    // Rules that can match a node of the given kind.
+    const std::vector<RewriteRule>& rulesFor(NodeKind kind) const;
+    // Every rule, regardless of kind.
+    const std::vector<RewriteRule>& getRules() const;
+    std::size_t size() const;
+
+private:
+    std::array<std::vector<RewriteRule>, kNodeKindCount> byKind;
+    std::vector<RewriteRule> rules;
+};
+
+// Identities of Node::simplify plus canonical ordering, constant reassociation, like-term
+// collection (x*2 + x*3 -> 5*x) and merging of powers (x * x^2 -> x^3).
+RuleRegistry makeStandardRules();
+
+} // namespace Expression
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef EXPR_FORMAT_H
+#define EXPR_FORMAT_H
+
+#include "_pch.h"
+
+namespace Expression {
+
+// On-disk layout of a formula library, shared by ExprWriter and ExprLibrary.
+//
+//   FileHeader
+//   FormulaEntry[formulaCount]     one per formula, in the order they were added
+//   NodeRecord[recordCount]        every formula's nodes in postorder, back to back
+//   double[constantCount]          constant pool, deduplicated by bit pattern
+//   StringRef[symbolCount]         variable names
+//   FunctionEntry[functionCount]   user functions, resolved by name when loading
+//   char[stringBytes]              the text every StringRef points into
+//
+// Every section starts on an 8-byte boundary, at the offset the header records, so a
+// mapped file can be read in place. Integers and doubles are stored in the writer's
+// native byte order; byteOrderMark lets a reader on another machine reject the file.
+namespace ExprFormat {
+
+constexpr char kMagic[8] = {'E', 'X', 'P', 'R', 'L', 'I', 'B', '\0'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint32_t kByteOrderMark = 0x01020304;
+
+struct StringRef {
+    std::uint32_t offset;  // Into the string section
+    std::uint32_t length;
+};
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrderMark;
+    std::uint32_t formulaCount;
+    std::uint32_t recordCount;
+    std::uint32_t constantCount;
+    std::uint32_t symbolCount;
+    std::uint32_t functionCount;
+    std::uint32_t stringBytes;
+    std::uint64_t formulasOffset;
+    std::uint64_t recordsOffset;
+    std::uint64_t constantsOffset;
+    std::uint64_t symbolsOffset;
+    std::uint64_t functionsOffset;
+    std::uint64_t stringsOffset;
+    std::uint64_t fileSize;
+};
+
+struct FormulaEntry {
+    std::uint32_t firstRecord;
+    std::uint32_t recordCount;
+    std::uint32_t maxStackDepth;  // Values live at once while evaluating the records in order
+    std::uint32_t reserved;
+    StringRef name;               // Empty for unnamed formulas
+};
+
+// One node. Children precede their parent, so the last record of a formula is its root
+// and evaluating the records in order is a stack machine run. The last child sits right
+// before its parent; earlier children are found by stepping back over subtree sizes.
+struct NodeRecord {
+    std::uint8_t kind;          // NodeKind
+    std::uint8_t reserved;
+    std::uint16_t arity;        // Number of children
+    std::uint32_t payload;      // Constant index (Number), symbol index (Variable), function index (Function)
+    std::uint32_t size;         // Records in this subtree, this one included
+    std::uint32_t firstChild;   // Distance back to the first child's record; 0 for leaves
+};
+
+struct FunctionEntry {
+    StringRef name;
+    std::uint32_t argCount;
+    std::uint32_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 96, "FileHeader layout changed");
+static_assert(sizeof(FormulaEntry) == 24, "FormulaEntry layout changed");
+static_assert(sizeof(NodeRecord) == 16, "NodeRecord layout changed");
+static_assert(sizeof(FunctionEntry) == 16, "FunctionEntry layout changed");
+
+} // namespace ExprFormat
+
+} // namespace Expression
+
+#endif
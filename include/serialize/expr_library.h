@@ -0,0 +1,85 @@
+#ifndef EXPR_LIBRARY_H
+#define EXPR_LIBRARY_H
+
+#include "expression/node.h"
+#include "memory/expr_arena.h"
+#include "parser/function_registry.h"
+#include "serialize/expr_format.h"
+
+namespace Expression {
+
+// Read-only view of a formula library written by ExprWriter. open() maps the file and
+// evaluates straight from the mapped records: nothing is copied or allocated per formula,
+// so touching a formula costs the page faults of its records and nothing else. Names come
+// back as views into the mapping.
+//
+// Evaluation runs the records as a stack machine with the same results and errors as
+// Node::evaluate. Variables are read from slots[symbol index], where symbol indices are
+// the library's own (see getSymbol); load() rebuilds a formula as nodes in an arena when
+// it is needed for symbolic work. User functions are resolved by name through the
+// FunctionRegistry given at open; calling one that is not registered throws.
+//
+// Records are bounds-checked as they are read, so a corrupt or truncated file raises
+// std::runtime_error instead of reading outside the mapping.
+class ExprLibrary {
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    // Map the file at path. The registry, if any, must outlive the library.
+    static ExprLibrary open(const std::string& path, const FunctionRegistry* functions = nullptr);
+    // Read a library already in memory. data must be 8-byte aligned and outlive the library.
+    ExprLibrary(const void* data, std::size_t size, const FunctionRegistry* functions = nullptr);
+
+    ExprLibrary(ExprLibrary&& other) noexcept;
+    ExprLibrary& operator=(ExprLibrary&& other) noexcept;
+    ExprLibrary(const ExprLibrary&) = delete;
+    ExprLibrary& operator=(const ExprLibrary&) = delete;
+    ~ExprLibrary();
+
+    std::size_t getFormulaCount() const;
+    std::string_view getName(std::size_t formula) const;
+    // Index of the first formula named name, or npos.
+    std::size_t find(std::string_view name) const;
+
+    // Length of the slot array evaluate(formula, const double*) reads.
+    std::size_t getSymbolCount() const;
+    std::string_view getSymbol(std::size_t symbol) const;
+
+    double evaluate(std::size_t formula, const double* slots) const;
+    // Missing variables default to 0, as in VariableNode::evaluate.
+    double evaluate(std::size_t formula, const Env& env) const;
+
+    // Rebuild a formula as nodes in arena; its variables are interned in the arena's symbol table.
+    Node* load(std::size_t formula, ExprArena& arena) const;
+
+private:
+    ExprLibrary() = default;
+
+    void attach(const void* data, std::size_t size, const FunctionRegistry* functions);
+    void release();
+
+    const ExprFormat::FormulaEntry& formulaAt(std::size_t formula) const;
+    std::string_view text(const ExprFormat::StringRef& ref) const;
+    const FunctionDefinition& functionAt(std::uint32_t function) const;
+    template<typename LoadVariable>
+    double run(const ExprFormat::FormulaEntry& entry, LoadVariable&& loadVariable) const;
+    Node* build(std::size_t firstRecord, std::size_t recordCount, ExprArena& arena) const;
+    [[noreturn]] void corrupt(const char* what) const;
+
+    void* mapping = nullptr;  // Owned mmap region, if open() created this library
+    std::size_t mappingSize = 0;
+
+    const char* base = nullptr;
+    const ExprFormat::FileHeader* header = nullptr;
+    const ExprFormat::FormulaEntry* formulas = nullptr;
+    const ExprFormat::NodeRecord* records = nullptr;
+    const double* constants = nullptr;
+    const ExprFormat::StringRef* symbols = nullptr;
+    const ExprFormat::FunctionEntry* functions = nullptr;
+    const char* strings = nullptr;
+    std::vector<const FunctionDefinition*> resolved;  // Per FunctionEntry; nullptr if unregistered
+};
+
+} // namespace Expression
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef EXPR_WRITER_H
+#define EXPR_WRITER_H
+
+#include "expression/node.h"
+#include "serialize/expr_format.h"
+
+namespace Expression {
+
+class FunctionNode;
+
+// Collects formulas and writes them as one library file (see expr_format.h) that
+// ExprLibrary maps and evaluates in place. Constants, variable names and functions are
+// pooled across the whole library. Shared subexpressions of a hash-consed tree are
+// written once per occurrence: a record stream is a tree, not a DAG.
+class ExprWriter {
+public:
+    // Append a formula; returns its index in the library.
+    std::size_t add(const Node* root, const std::string& name = "");
+    std::size_t getFormulaCount() const;
+
+    void write(std::ostream& out) const;
+    void writeFile(const std::string& path) const;
+
+private:
+    std::uint32_t encode(const Node* node);  // Returns the subtree's record count
+    void pushRecord(NodeKind kind, std::size_t arity, std::uint32_t payload, std::uint32_t size,
+                    std::uint32_t firstChild);
+    std::uint32_t constantIndex(double value);
+    std::uint32_t symbolIndex(const std::string& name);
+    std::uint32_t functionIndex(const FunctionNode* function);
+    ExprFormat::StringRef stringRef(const std::string& text);
+
+    std::vector<ExprFormat::FormulaEntry> formulas;
+    std::vector<ExprFormat::NodeRecord> records;
+    std::vector<double> constants;
+    std::vector<ExprFormat::StringRef> symbols;
+    std::vector<ExprFormat::FunctionEntry> functions;
+    std::string strings;
+
+    std::unordered_map<std::uint64_t, std::uint32_t> constantOfBits;
+    std::unordered_map<std::string, std::uint32_t> symbolOfName;
+    std::unordered_map<std::string, std::uint32_t> functionOfName;
+    std::unordered_map<std::string, ExprFormat::StringRef> stringOfText;
+
+    std::size_t stackDepth = 0;     // While encoding a formula
+    std::size_t maxStackDepth = 0;
+};
+
+} // namespace Expression
+
+#endif
@@ -0,0 +1,422 @@
+#ifndef STATIC_EXPR_H
+#define STATIC_EXPR_H
+
+#include "helpers/expr_helper.h"
+
+#include <type_traits>
+#include <utility>
+
+namespace Expression {
+
+// Expression templates for formulas fixed at compile time: the formula is a type, e.g.
+// Add<Mul<Var<0>, Const>, Sin<Var<1>>>, and evaluate(vars) inlines to straight-line code
+// over vars[i] with no tree walk and no virtual calls. The operators mirror AdditionNode
+// through LogNode and throw the same std::runtime_error messages as Node::evaluate; the
+// values are those of Node::evaluate, except where the compiler rewrites pow with a
+// constant exponent (x ^ 2 as x * x, exact where libm's pow may be off by an ulp).
+//
+// derivative<I>(expr) differentiates with respect to Var<I> at compile time, with the
+// rules of the Node classes, folding the zeros and ones they would produce so unused
+// terms never reach the generated code. toNode(expr, arena) builds the equivalent Node
+// tree for printing, tracing, simplification or serialization.
+//
+// Formulas are written as types or built with the operators below:
+//     using namespace Expression::Static;
+//     constexpr Var<0> x;
+//     constexpr Var<1> y;
+//     auto f = x * Const{2.5} + sin(y);      // Add<Mul<Var<0>, Const>, Sin<Var<1>>>
+//     auto dfdx = derivative<0>(f);          // Const{2.5}
+namespace Static {
+
+// **Leaves**
+// The I-th input, vars[I]. toNode names it variables[I], "x<I>" by default.
+template<std::size_t I>
+struct Var {
+    constexpr double evaluate(const double* vars) const { return vars[I]; }
+};
+
+// Constant known only as a value.
+struct Const {
+    double value = 0;
+    constexpr double evaluate(const double*) const { return value; }
+};
+
+// Integer constant carried in the type, so derivatives can fold it away.
+template<int N>
+struct Int {
+    static constexpr int value = N;
+    constexpr double evaluate(const double*) const { return N; }
+};
+
+// **Operators**
+template<typename L, typename R>
+struct Add {
+    L left;
+    R right;
+    constexpr double evaluate(const double* vars) const { return left.evaluate(vars) + right.evaluate(vars); }
+};
+
+template<typename L, typename R>
+struct Sub {
+    L left;
+    R right;
+    constexpr double evaluate(const double* vars) const { return left.evaluate(vars) - right.evaluate(vars); }
+};
+
+template<typename L, typename R>
+struct Mul {
+    L left;
+    R right;
+    constexpr double evaluate(const double* vars) const { return left.evaluate(vars) * right.evaluate(vars); }
+};
+
+template<typename L, typename R>
+struct Div;
+template<typename E>
+[[noreturn]] void throwDivisionByZero(const E& division);
+
+template<typename L, typename R>
+struct Div {
+    L left;
+    R right;
+    constexpr double evaluate(const double* vars) const {
+        double numerator = left.evaluate(vars);
+        double denominator = right.evaluate(vars);
+        if (denominator == 0) {
+            throwDivisionByZero(*this);
+        }
+        return numerator / denominator;
+    }
+};
+
+// base ^ exponent
+template<typename L, typename R>
+struct Pow {
+    L left;
+    R right;
+    double evaluate(const double* vars) const {
+        double base = left.evaluate(vars);
+        double exponent = right.evaluate(vars);
+        if (base == 0 && exponent <= 0) {
+            throw std::runtime_error("Math error: 0 raised to a non-positive exponent.");
+        }
+        return std::pow(base, exponent);
+    }
+};
+
+template<typename E>
+struct Sin {
+    E operand;
+    double evaluate(const double* vars) const { return std::sin(operand.evaluate(vars)); }
+};
+
+template<typename E>
+struct Cos {
+    E operand;
+    double evaluate(const double* vars) const { return std::cos(operand.evaluate(vars)); }
+};
+
+template<typename E>
+struct Ln {
+    E operand;
+    double evaluate(const double* vars) const {
+        double value = operand.evaluate(vars);
+        if (value <= 0) {
+            throw std::runtime_error("Math error: ln of non-positive number.");
+        }
+        return std::log(value);
+    }
+};
+
+// log base left of right
+template<typename L, typename R>
+struct Log {
+    L left;
+    R right;
+    double evaluate(const double* vars) const {
+        double base = left.evaluate(vars);
+        double value = right.evaluate(vars);
+        if (base <= 0 || base == 1 || value <= 0) {
+            throw std::runtime_error("Math error: log with invalid base or operand.");
+        }
+        return std::log(value) / std::log(base);
+    }
+};
+
+// **Traits**
+template<typename T>
+struct IsStatic : std::false_type {};
+template<std::size_t I>
+struct IsStatic<Var<I>> : std::true_type {};
+template<>
+struct IsStatic<Const> : std::true_type {};
+template<int N>
+struct IsStatic<Int<N>> : std::true_type {};
+template<typename L, typename R>
+struct IsStatic<Add<L, R>> : std::true_type {};
+template<typename L, typename R>
+struct IsStatic<Sub<L, R>> : std::true_type {};
+template<typename L, typename R>
+struct IsStatic<Mul<L, R>> : std::true_type {};
+template<typename L, typename R>
+struct IsStatic<Div<L, R>> : std::true_type {};
+template<typename L, typename R>
+struct IsStatic<Pow<L, R>> : std::true_type {};
+template<typename E>
+struct IsStatic<Sin<E>> : std::true_type {};
+template<typename E>
+struct IsStatic<Cos<E>> : std::true_type {};
+template<typename E>
+struct IsStatic<Ln<E>> : std::true_type {};
+template<typename L, typename R>
+struct IsStatic<Log<L, R>> : std::true_type {};
+
+template<typename T>
+constexpr bool isStatic = IsStatic<T>::value;
+
+template<typename T>
+struct IsInt : std::false_type {};
+template<int N>
+struct IsInt<Int<N>> : std::true_type {};
+
+template<typename T>
+constexpr bool isZero = std::is_same<T, Int<0>>::value;
+template<typename T>
+constexpr bool isOne = std::is_same<T, Int<1>>::value;
+template<typename T>
+constexpr bool isConstant = IsInt<T>::value || std::is_same<T, Const>::value;
+
+// **Builders**
+// Used by derivative(): fold the zeros and ones, and integer arithmetic, so e.g. the
+// derivative of x * y with respect to x is Var<1> rather than Add<Mul<Int<1>, Var<1>>,
+// Mul<Var<0>, Int<0>>>. Like simplify(), this drops checks a zero factor would have made
+// (0 / 0 folds to 0).
+namespace Fold {
+
+template<int A, int B>
+constexpr Int<A + B> add(Int<A>, Int<B>) { return {}; }
+template<typename L, typename R>
+constexpr auto add(L left, R right) {
+    if constexpr (isZero<L>) {
+        return right;
+    } else if constexpr (isZero<R>) {
+        return left;
+    } else {
+        return Add<L, R>{left, right};
+    }
+}
+
+template<int A, int B>
+constexpr Int<A - B> sub(Int<A>, Int<B>) { return {}; }
+template<typename L, typename R>
+constexpr auto sub(L left, R right) {
+    if constexpr (isZero<R>) {
+        return left;
+    } else {
+        return Sub<L, R>{left, right};
+    }
+}
+
+template<int A, int B>
+constexpr Int<A * B> mul(Int<A>, Int<B>) { return {}; }
+template<typename L, typename R>
+constexpr auto mul(L left, R right) {
+    if constexpr (isZero<L> || isZero<R>) {
+        return Int<0>{};
+    } else if constexpr (isOne<L>) {
+        return right;
+    } else if constexpr (isOne<R>) {
+        return left;
+    } else {
+        return Mul<L, R>{left, right};
+    }
+}
+
+template<typename L, typename R>
+constexpr auto div(L left, R right) {
+    if constexpr (isZero<L>) {
+        return Int<0>{};
+    } else if constexpr (isOne<R>) {
+        return left;
+    } else {
+        return Div<L, R>{left, right};
+    }
+}
+
+template<typename L, typename R>
+constexpr auto pow(L base, R exponent) {
+    if constexpr (isOne<R>) {
+        return base;
+    } else {
+        return Pow<L, R>{base, exponent};
+    }
+}
+
+} // namespace Fold
+
+// **Differentiation**
+// d expr / d Var<I>, following the derivativeImpl of each Node class.
+template<std::size_t I, std::size_t J>
+constexpr Int<I == J ? 1 : 0> derivative(const Var<J>&) { return {}; }
+template<std::size_t I>
+constexpr Int<0> derivative(const Const&) { return {}; }
+template<std::size_t I, int N>
+constexpr Int<0> derivative(const Int<N>&) { return {}; }
+
+template<std::size_t I, typename L, typename R>
+constexpr auto derivative(const Add<L, R>& e) {
+    return Fold::add(derivative<I>(e.left), derivative<I>(e.right));
+}
+
+template<std::size_t I, typename L, typename R>
+constexpr auto derivative(const Sub<L, R>& e) {
+    return Fold::sub(derivative<I>(e.left), derivative<I>(e.right));
+}
+
+template<std::size_t I, typename L, typename R>
+constexpr auto derivative(const Mul<L, R>& e) {
+    return Fold::add(Fold::mul(derivative<I>(e.left), e.right), Fold::mul(e.left, derivative<I>(e.right)));
+}
+
+template<std::size_t I, typename L, typename R>
+constexpr auto derivative(const Div<L, R>& e) {
+    auto numerator = Fold::sub(Fold::mul(derivative<I>(e.left), e.right), Fold::mul(e.left, derivative<I>(e.right)));
+    return Fold::div(numerator, Fold::mul(e.right, e.right));
+}
+
+// Constant exponent: n * f^(n-1) * f'. Otherwise f^g * (g' * ln(f) + g * f'/f).
+template<std::size_t I, typename L, typename R>
+constexpr auto derivative(const Pow<L, R>& e) {
+    if constexpr (IsInt<R>::value) {
+        constexpr int n = R::value;
+        return Fold::mul(Fold::mul(Int<n>{}, Fold::pow(e.left, Int<n - 1>{})), derivative<I>(e.left));
+    } else if constexpr (std::is_same<R, Const>::value) {
+        double n = e.right.value;
+        return Fold::mul(Fold::mul(Const{n}, Fold::pow(e.left, Const{n - 1})), derivative<I>(e.left));
+    } else {
+        auto term1 = Fold::mul(derivative<I>(e.right), Ln<L>{e.left});
+        auto term2 = Fold::mul(e.right, Fold::div(derivative<I>(e.left), e.left));
+        return Fold::mul(e, Fold::add(term1, term2));
+    }
+}
+
+template<std::size_t I, typename E>
+constexpr auto derivative(const Sin<E>& e) {
+    return Fold::mul(Cos<E>{e.operand}, derivative<I>(e.operand));
+}
+
+template<std::size_t I, typename E>
+constexpr auto derivative(const Cos<E>& e) {
+    return Fold::mul(Int<-1>{}, Fold::mul(Sin<E>{e.operand}, derivative<I>(e.operand)));
+}
+
+template<std::size_t I, typename E>
+constexpr auto derivative(const Ln<E>& e) {
+    return Fold::div(derivative<I>(e.operand), e.operand);
+}
+
+// Constant base: f' / (f ln(b)). Otherwise (f'/f * ln(b) - ln(f) * b'/b) / ln(b)^2.
+template<std::size_t I, typename L, typename R>
+constexpr auto derivative(const Log<L, R>& e) {
+    if constexpr (isConstant<L>) {
+        return Fold::div(derivative<I>(e.right), Fold::mul(e.right, Ln<L>{e.left}));
+    } else {
+        Ln<L> lnBase{e.left};
+        auto numerator = Fold::sub(Fold::mul(Fold::div(derivative<I>(e.right), e.right), lnBase),
+                                   Fold::mul(Ln<R>{e.right}, Fold::div(derivative<I>(e.left), e.left)));
+        return Fold::div(numerator, Fold::mul(lnBase, lnBase));
+    }
+}
+
+template<typename E, std::size_t I>
+using DerivativeOf = decltype(derivative<I>(std::declval<const E&>()));
+
+// **Operator syntax**
+template<typename L, typename R, typename = std::enable_if_t<isStatic<L> && isStatic<R>>>
+constexpr Add<L, R> operator+(L left, R right) { return {left, right}; }
+template<typename L, typename R, typename = std::enable_if_t<isStatic<L> && isStatic<R>>>
+constexpr Sub<L, R> operator-(L left, R right) { return {left, right}; }
+template<typename L, typename R, typename = std::enable_if_t<isStatic<L> && isStatic<R>>>
+constexpr Mul<L, R> operator*(L left, R right) { return {left, right}; }
+template<typename L, typename R, typename = std::enable_if_t<isStatic<L> && isStatic<R>>>
+constexpr Div<L, R> operator/(L left, R right) { return {left, right}; }
+
+template<typename L, typename R, typename = std::enable_if_t<isStatic<L> && isStatic<R>>>
+constexpr Pow<L, R> pow(L base, R exponent) { return {base, exponent}; }
+template<typename E, typename = std::enable_if_t<isStatic<E>>>
+constexpr Sin<E> sin(E operand) { return {operand}; }
+template<typename E, typename = std::enable_if_t<isStatic<E>>>
+constexpr Cos<E> cos(E operand) { return {operand}; }
+template<typename E, typename = std::enable_if_t<isStatic<E>>>
+constexpr Ln<E> ln(E operand) { return {operand}; }
+template<typename L, typename R, typename = std::enable_if_t<isStatic<L> && isStatic<R>>>
+constexpr Log<L, R> log(L base, R operand) { return {base, operand}; }
+
+// **Bridge to Node trees**
+// Default name of Var<I> when no names are given.
+inline std::string variableName(std::size_t index) {
+    return "x" + std::to_string(index);
+}
+
+// Builds the Node tree of a template expression; a class so that every overload is
+// visible from every other, whatever the order of declaration.
+class NodeBuilder {
+public:
+    NodeBuilder(ExprArena& arena, const std::vector<std::string>& variables) : e(arena), variables(variables) {}
+
+    Node* operator()(const Const& c) { return e.num(c.value); }
+    template<int N>
+    Node* operator()(const Int<N>&) { return e.num(N); }
+    template<std::size_t I>
+    Node* operator()(const Var<I>&) { return e.var(I < variables.size() ? variables[I] : variableName(I)); }
+
+    template<typename L, typename R>
+    Node* operator()(const Add<L, R>& n) { return e.add((*this)(n.left), (*this)(n.right)); }
+    template<typename L, typename R>
+    Node* operator()(const Sub<L, R>& n) { return e.sub((*this)(n.left), (*this)(n.right)); }
+    template<typename L, typename R>
+    Node* operator()(const Mul<L, R>& n) { return e.mul((*this)(n.left), (*this)(n.right)); }
+    template<typename L, typename R>
+    Node* operator()(const Div<L, R>& n) { return e.div((*this)(n.left), (*this)(n.right)); }
+    template<typename L, typename R>
+    Node* operator()(const Pow<L, R>& n) { return e.exp((*this)(n.left), (*this)(n.right)); }
+    template<typename E>
+    Node* operator()(const Sin<E>& n) { return e.sin((*this)(n.operand)); }
+    template<typename E>
+    Node* operator()(const Cos<E>& n) { return e.cos((*this)(n.operand)); }
+    template<typename E>
+    Node* operator()(const Ln<E>& n) { return e.ln((*this)(n.operand)); }
+    template<typename L, typename R>
+    Node* operator()(const Log<L, R>& n) { return e.log((*this)(n.left), (*this)(n.right)); }
+
+private:
+    ExprHelper e;
+    const std::vector<std::string>& variables;
+};
+
+// The Node tree of expr, allocated in arena. Var<I> becomes the variable variables[I]
+// (variableName(I) past the end), so with the same names the tree evaluates to the same
+// values and throws the same messages.
+template<typename E, typename = std::enable_if_t<isStatic<E>>>
+Node* toNode(const E& expr, ExprArena& arena, const std::vector<std::string>& variables = {}) {
+    return NodeBuilder(arena, variables)(expr);
+}
+
+// Same text as toNode(expr, ...)->toString().
+template<typename E, typename = std::enable_if_t<isStatic<E>>>
+std::string toString(const E& expr, const std::vector<std::string>& variables = {}) {
+    ExprArena arena;
+    return toNode(expr, arena, variables)->toString();
+}
+
+// The error path of Div::evaluate, apart so evaluate() itself stays small enough to inline.
+template<typename E>
+[[noreturn]] void throwDivisionByZero(const E& division) {
+    throw std::runtime_error("Division by zero error in " + toString(division));
+}
+
+} // namespace Static
+
+} // namespace Expression
+
+#endif
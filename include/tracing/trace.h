@@ -2,23 +2,149 @@
 #define TRACE_HPP
 
 #include "_pch.h"
+#include <atomic>
+#include <mutex>
 #include <nlohmann/json.hpp>
 
+// Compile-time switch: building with EXPR_ENABLE_TRACING=0 turns every
+// Trace::enabled() check into a constant false, so trace calls compile out.
+#ifndef EXPR_ENABLE_TRACING
+#define EXPR_ENABLE_TRACING 1
+#endif
+
 namespace Expression {
 
+class Node;
+
+// Runtime tracing level. Summary records symbolic transformations (simplify,
+// derivative, substitute, solveFor); Full also records every evaluation step.
+enum class TraceLevel {
+    Off = 0,
+    Summary = 1,
+    Full = 2
+};
+
 struct TransformationStep {
     std::string description;
     std::string before;
     std::string after;
 };
 
+enum class TraceFormat {
+    Json,       // One object: {"messages": [...], "transformationSteps": [...]}
+    JsonLines   // One object per record and line, in timeline order
+};
+
+struct TraceExportOptions {
+    TraceFormat format = TraceFormat::Json;
+    bool pretty = false;  // Indent JSON by 4 spaces, as exportToJson does; ignored for JsonLines
+};
+
+// One recorded message or transformation, stamped with steady_clock nanoseconds so
+// records from different sinks can be merged into one timeline.
+struct TraceRecord {
+    std::uint64_t timestamp = 0;
+    bool isTransformation = false;
+    std::string text;    // The message, or the transformation's description
+    std::string before;  // Transformations only
+    std::string after;
+};
+
+// Single-producer ring of trace records. One thread at a time records into a sink and
+// any thread may drain it; the record path takes no lock unless the ring is full, in
+// which case the producer hands the whole ring to the consumers and starts a new one
+// rather than dropping records.
+class TraceSink {
+public:
+    static constexpr std::size_t kDefaultCapacity = 1024;
+
+    // capacity is rounded up to a power of two.
+    explicit TraceSink(std::size_t capacity = kDefaultCapacity);
+
+    TraceSink(const TraceSink&) = delete;
+    TraceSink& operator=(const TraceSink&) = delete;
+
+    // Producer side. Records from one sink keep their order.
+    void record(TraceRecord&& record);
+
+    // Consumer side: append every pending record to out, oldest first.
+    void drainInto(std::vector<TraceRecord>& out);
+
+    // Drain this sink and format what it held, in the formats of Trace::getTrace and
+    // Trace::exportToJson. Meant for context sinks; a second call sees only newer records.
+    std::string getTrace();
+    std::string exportToJson();
+    void exportTo(std::ostream& out, const TraceExportOptions& options = TraceExportOptions());
+    void exportTo(int fd, const TraceExportOptions& options = TraceExportOptions());
+
+    // Times the ring was full and was handed over.
+    std::uint64_t getSpillCount() const;
+
+private:
+    // A ring handed over when it filled up; holds records [begin, end) by sequence.
+    struct SpilledRing {
+        std::unique_ptr<TraceRecord[]> slots;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    void spill(std::size_t head);
+
+    std::unique_ptr<TraceRecord[]> slots;
+    std::size_t mask;
+    alignas(64) std::atomic<std::size_t> head{0};  // Next slot to write; owned by the producer
+    alignas(64) std::atomic<std::size_t> tail{0};  // Next slot to read; owned by the consumer
+    std::mutex consumerMutex;                      // Serializes consumers, including a spilling producer
+    std::vector<SpilledRing> spilled;
+    std::unique_ptr<TraceRecord[]> spare;          // A drained ring kept for the next spill
+    std::atomic<std::uint64_t> spills{0};
+};
+
+// Sends the current thread's trace to a sink owned by a context (a request, a job)
+// instead of the thread's own sink, until the scope ends. Scopes nest. Records sent to
+// a scoped sink are not seen by Trace::getTrace or Trace::exportToJson; the owner reads
+// them from the sink.
+class TraceScope {
+public:
+    explicit TraceScope(TraceSink& sink);
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    TraceSink* previous;
+};
+
+// Process-wide trace front end. Each thread records into its own TraceSink, registered
+// with an aggregator the first time the thread traces; getTrace and exportToJson drain
+// every registered sink and merge the records by timestamp, so threads that evaluate or
+// simplify at the same time neither race nor contend on a shared buffer.
 class Trace {
 public:
+    // Set the runtime tracing level (Full by default).
+    static void setLevel(TraceLevel level);
+    static TraceLevel getLevel();
+
+    // Whether a step at the given level should be recorded. Callers check this before
+    // building any trace strings, so a disabled trace costs a single load and branch.
+    static bool enabled(TraceLevel level) {
+#if EXPR_ENABLE_TRACING
+        return level <= currentLevel.load(std::memory_order_relaxed);
+#else
+        (void)level;
+        return false;
+#endif
+    }
+
     // Add a plain evaluation or informational message.
     static void add(const std::string& message);
     
     // Add a transformation step with a description and before/after expressions.
     static void addTransformation(const std::string& description, const std::string& before, const std::string& after);
+    // Same, printing both trees with ExprPrinter. Nodes are immutable, so a symbolic method
+    // can pass `this` as the before state without capturing its text up front.
+    static void addTransformation(const std::string& description, const Node* before, const Node* after);
     
     // Clear all stored messages and transformation steps.
     static void clear();
@@ -29,15 +155,13 @@ public:
     // Export the complete trace (messages and transformation steps) as a JSON string.
     static std::string exportToJson();
 
+    // Stream the complete trace to out or to the file descriptor fd in chunks, without
+    // building it in memory first; meant for large traces. fd is not closed.
+    static void exportTo(std::ostream& out, const TraceExportOptions& options = TraceExportOptions());
+    static void exportTo(int fd, const TraceExportOptions& options = TraceExportOptions());
+
 private:
-    // For legacy plain text logging.
-    static std::ostringstream oss;
-    
-    // Structured storage for messages.
-    static std::vector<std::string> messages;
-    
-    // Structured storage for transformation steps.
-    static std::vector<TransformationStep> transformationSteps;
+    static inline std::atomic<TraceLevel> currentLevel{TraceLevel::Full};
 };
 
 } // namespace Expression
@@ -0,0 +1,48 @@
+#ifndef TRACE_WRITER_H
+#define TRACE_WRITER_H
+
+#include "tracing/trace.h"
+
+namespace Expression {
+
+// Streams trace records as JSON or JSON Lines through a fixed-size buffer, flushing to an
+// ostream, a file descriptor or a string whenever the buffer fills, so exporting needs
+// memory for one chunk rather than for a DOM and its dump. Pretty JSON is byte-for-byte
+// what nlohmann::json::dump(4) prints for the same trace, compact JSON what dump() prints.
+// Strings are escaped as nlohmann does; bytes outside ASCII are written through as they are.
+class TraceWriter {
+public:
+    static constexpr std::size_t kChunkSize = 64 * 1024;
+
+    explicit TraceWriter(std::ostream& out);
+    explicit TraceWriter(int fd);          // Not closed by the writer
+    explicit TraceWriter(std::string& out);
+
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    // Write one complete document for the records, then flush. Throws std::runtime_error
+    // if the destination fails.
+    void write(const std::vector<TraceRecord>& records, const TraceExportOptions& options);
+
+private:
+    void writeJson(const std::vector<TraceRecord>& records, bool pretty);
+    void writeJsonLines(const std::vector<TraceRecord>& records);
+
+    void newline(int depth);  // Pretty JSON only
+    void key(const char* name);
+    void string(std::string_view text);
+    void recordText(const TraceRecord& record);  // Quoted, in getTrace's plain-text form
+    void escaped(std::string_view text);
+    void put(std::string_view text);
+    void put(char c);
+    void flush();
+
+    std::function<void(const char*, std::size_t)> destination;
+    std::string buffer;
+    bool pretty = false;
+};
+
+} // namespace Expression
+
+#endif
@@ -3,7 +3,9 @@
 #include <vector>
 #include <stdexcept>
 #include "memory/expr_arena.h"
+#include "memory/symbolic_cache.h"
 #include "helpers/expr_helper.h"
+#include "parser/parser.h"
 
 #include "tracing/trace.h"
 
@@ -61,7 +63,7 @@ void runSimplificationExample() {
             )
         );
 
-        Node* simplified = expr->simplify();
+        Node* simplified = expr->simplify(arena);
 
         std::cout << "Original Expression: " << expr->toString() << std::endl;
         std::cout << "Simplified Expression: " << simplified->toString() << std::endl;
@@ -76,7 +78,9 @@ void runDifferentiationExample() {
     std::cout << "\n=== Differentiation Example ===\n";
 
     try {
+        SymbolicCache cache;  // Repeated subtrees are differentiated and simplified once
         ExprArena arena;
+        arena.setSymbolicCache(&cache);
         ExprHelper e(arena);
 
         // Expression: d/dx (x^2 * sin(x))
@@ -85,21 +89,47 @@ void runDifferentiationExample() {
             e.sin(e.var("x"))
         );
 
-        Node* derivative = expr->derivative("x");
+        Node* derivative = expr->derivative("x", arena);
 
         std::cout << "Original Expression: " << expr->toString() << std::endl;
-        std::cout << "Derivative: " << derivative->simplify()->toString() << std::endl;
+        std::cout << "Derivative: " << derivative->simplify(arena)->toString() << std::endl;
 
     } catch (const std::exception &e) {
         std::cerr << "Error during differentiation: " << e.what() << std::endl;
     }
 }
 
+void runParsingExample() {
+    Trace::clear();
+    std::cout << "\n=== Parsing Example ===\n";
+
+    try {
+        ExprArena arena;
+        FunctionRegistry functions;
+        functions.add("hypot", 2, [](const std::vector<double>& args) { return std::hypot(args[0], args[1]); });
+        Parser parser(arena, &functions);
+
+        Node* expr = parser.parse("-x^2 + hypot(3, y) / log(2, 8)");
+
+        Env env;
+        env["x"] = 2.0;
+        env["y"] = 4.0;
+
+        std::cout << "Parsed Expression: " << expr->toString() << std::endl;
+        std::cout << "Result: " << expr->evaluate(env) << std::endl;
+
+        parser.parse("sin(x) + * 2");
+    } catch (const std::exception &e) {
+        std::cerr << "Error during parsing: " << e.what() << std::endl;
+    }
+}
+
 int main() {
     try {
         runEvaluationExample();
         runSimplificationExample();
         runDifferentiationExample();
+        runParsingExample();
     } catch (const std::exception &e) {
         std::cerr << "Unexpected error in main: " << e.what() << std::endl;
     }
@@ -0,0 +1,427 @@
+#include "analysis/interval_evaluator.h"
+
+#include <limits>
+#include <queue>
+
+namespace Expression {
+
+namespace {
+
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+constexpr double kPi = 3.141592653589793;
+constexpr double kTwoPi = 6.283185307179586;
+// Beyond this magnitude sin and cos are given their full range: 2 pi k is no longer
+// computed accurately enough to place the extrema.
+constexpr double kPeriodicLimit = 1073741824.0;  // 2^30
+
+// **Rounding**
+// Results of libm calls are within one ulp of the exact value, so an interior point can
+// come out at most two ulps beyond the value computed at an endpoint.
+double widenDown(double x) {
+    return std::nextafter(std::nextafter(x, -kInfinity), -kInfinity);
+}
+
+double widenUp(double x) {
+    return std::nextafter(std::nextafter(x, kInfinity), kInfinity);
+}
+
+Interval widen(double lo, double hi) {
+    return {widenDown(lo), widenUp(hi)};
+}
+
+// Bounds that came out NaN (inf - inf, inf / inf) can be anything.
+Interval sanitize(Interval r, bool& mayFail) {
+    if (std::isnan(r.lo) || std::isnan(r.hi)) {
+        mayFail = true;
+        return Interval::entire();
+    }
+    return r;
+}
+
+Interval hull(Interval a, Interval b) {
+    return {std::min(a.lo, b.lo), std::max(a.hi, b.hi)};
+}
+
+// **Arithmetic**
+Interval add(Interval a, Interval b, bool& mayFail) {
+    return sanitize({a.lo + b.lo, a.hi + b.hi}, mayFail);
+}
+
+Interval sub(Interval a, Interval b, bool& mayFail) {
+    return sanitize({a.lo - b.hi, a.hi - b.lo}, mayFail);
+}
+
+// 0 * inf bounds a product of finite values, which is then near 0.
+double product(double a, double b) {
+    return a == 0 || b == 0 ? 0 : a * b;
+}
+
+Interval mul(Interval a, Interval b) {
+    double p1 = product(a.lo, b.lo);
+    double p2 = product(a.lo, b.hi);
+    double p3 = product(a.hi, b.lo);
+    double p4 = product(a.hi, b.hi);
+    return {std::min({p1, p2, p3, p4}), std::max({p1, p2, p3, p4})};
+}
+
+// Division by zero throws, so a zero in the divisor removes that point and leaves the
+// quotients of the rest: one-sided when zero is an endpoint, unbounded both ways inside.
+Interval div(Interval a, Interval b, bool& mayFail) {
+    if (b.lo > 0 || b.hi < 0) {
+        double q1 = a.lo / b.lo;
+        double q2 = a.lo / b.hi;
+        double q3 = a.hi / b.lo;
+        double q4 = a.hi / b.hi;
+        return sanitize({std::min({q1, q2, q3, q4}), std::max({q1, q2, q3, q4})}, mayFail);
+    }
+    mayFail = true;
+    if (b.lo == 0 && b.hi == 0) {
+        return Interval::empty();
+    }
+    if (a.lo == 0 && a.hi == 0) {
+        return Interval::point(0);
+    }
+    if (b.lo == 0) {  // Divisor in (0, b.hi]
+        if (a.lo >= 0) {
+            return {a.lo / b.hi, kInfinity};
+        }
+        if (a.hi <= 0) {
+            return {-kInfinity, a.hi / b.hi};
+        }
+    } else if (b.hi == 0) {  // Divisor in [b.lo, 0)
+        if (a.lo >= 0) {
+            return {-kInfinity, a.lo / b.lo};
+        }
+        if (a.hi <= 0) {
+            return {a.hi / b.lo, kInfinity};
+        }
+    }
+    return Interval::entire();
+}
+
+// pow is monotone in each argument on the non-negative bases, so its extremes lie at the
+// corners there. Negative bases give values only for integer exponents; with a single
+// integer exponent pow is monotone on them too.
+Interval pow(Interval base, Interval exponent, bool& mayFail) {
+    if (base.contains(0) && exponent.lo <= 0) {
+        mayFail = true;  // 0 to a non-positive power throws
+    }
+    Interval result = Interval::empty();
+    if (base.hi >= 0) {
+        double lo = std::max(base.lo, 0.0);
+        double c1 = std::pow(lo, exponent.lo);
+        double c2 = std::pow(lo, exponent.hi);
+        double c3 = std::pow(base.hi, exponent.lo);
+        double c4 = std::pow(base.hi, exponent.hi);
+        result = widen(std::min({c1, c2, c3, c4}), std::max({c1, c2, c3, c4}));
+    }
+    if (base.lo < 0) {
+        double n = exponent.lo;
+        if (exponent.lo == exponent.hi && std::isfinite(n) && std::nearbyint(n) == n) {
+            double c1 = std::pow(base.lo, n);
+            double c2 = std::pow(std::min(base.hi, -0.0), n);
+            result = hull(result, widen(std::min(c1, c2), std::max(c1, c2)));
+        } else {
+            mayFail = true;  // NaN at fractional exponents
+            if (std::floor(exponent.hi) >= std::ceil(exponent.lo)) {
+                result = Interval::entire();  // Some integer exponents: values of either sign
+            }
+        }
+    }
+    return sanitize(result, mayFail);
+}
+
+// **Elementary functions**
+// Range of sin (phase pi / 2) or cos (phase 0): the values at the ends, widened by
+// whichever extremum of the period lies inside.
+Interval periodic(Interval x, double (*fn)(double), double maxPhase, bool& mayFail) {
+    if (!std::isfinite(x.lo) || !std::isfinite(x.hi)) {
+        mayFail = true;  // NaN at +-inf
+        return {-1, 1};
+    }
+    if (x.hi - x.lo >= kTwoPi || std::max(std::fabs(x.lo), std::fabs(x.hi)) > kPeriodicLimit) {
+        return {-1, 1};
+    }
+    double a = fn(x.lo);
+    double b = fn(x.hi);
+    Interval result = widen(std::min(a, b), std::max(a, b));
+    // A little slack when placing the extrema: including one that lies just outside only
+    // loosens the bound.
+    double slack = 1e-9 * std::max(1.0, std::max(std::fabs(x.lo), std::fabs(x.hi)));
+    auto crosses = [&](double phase) {
+        double k = std::ceil((x.lo - slack - phase) / kTwoPi);
+        return phase + k * kTwoPi <= x.hi + slack;
+    };
+    if (crosses(maxPhase)) {
+        result.hi = 1;
+    }
+    if (crosses(maxPhase + kPi)) {
+        result.lo = -1;
+    }
+    return {std::max(result.lo, -1.0), std::min(result.hi, 1.0)};
+}
+
+// ln over the positive part of x; the rest throws.
+Interval ln(Interval x, bool& mayFail) {
+    if (x.lo <= 0) {
+        mayFail = true;
+        if (x.hi <= 0) {
+            return Interval::empty();
+        }
+        return {-kInfinity, widenUp(std::log(x.hi))};
+    }
+    return widen(std::log(x.lo), std::log(x.hi));
+}
+
+// log(base, x) = ln(x) / ln(base); a base of 1 makes the divisor contain zero, which
+// div() treats like the error evaluate() raises there.
+Interval log(Interval base, Interval x, bool& mayFail) {
+    Interval lnX = ln(x, mayFail);
+    Interval lnBase = ln(base, mayFail);
+    if (lnX.isEmpty() || lnBase.isEmpty()) {
+        return Interval::empty();
+    }
+    return div(lnX, lnBase, mayFail);
+}
+
+Interval eq(Interval a, Interval b, bool& mayFail) {
+    Interval d = sub(a, b, mayFail);
+    if (d.lo > -1e-9 && d.hi < 1e-9) {
+        return Interval::point(1);
+    }
+    if (d.lo >= 1e-9 || d.hi <= -1e-9) {
+        return Interval::point(0);
+    }
+    return {0, 1};
+}
+
+} // namespace
+
+Interval Interval::empty() {
+    return {kInfinity, -kInfinity};
+}
+
+Interval Interval::entire() {
+    return {-kInfinity, kInfinity};
+}
+
+IntervalEvaluator::IntervalEvaluator(const CompiledExpr& program)
+    : program(program), stack(program.getMaxStackDepth()), temps(program.getTempCount()),
+      point(program.getSlotCount()) {}
+
+IntervalEvaluator::IntervalEvaluator(const Node* root) : IntervalEvaluator(CompiledExpr(root)) {}
+
+// **Evaluation: the stack machine of CompiledExpr::evaluate on intervals**
+IntervalResult IntervalEvaluator::evaluate(const Interval* box) {
+    mayFail = false;
+    Interval* top = stack.data();  // One past the topmost value.
+    for (const Instruction& ins : program.getCode()) {
+        if (ins.op == OpCode::StoreTemp) {
+            temps[ins.operand] = top[-1];
+            continue;
+        }
+        if (ins.op == OpCode::LoadTemp) {
+            *top++ = temps[ins.operand];
+            continue;
+        }
+        if (ins.op == OpCode::PushConst) {
+            *top++ = Interval::point(program.getConstants()[ins.operand]);
+            continue;
+        }
+        if (ins.op == OpCode::LoadVar) {
+            *top++ = box[ins.operand];
+            continue;
+        }
+        if (ins.op == OpCode::Call) {
+            const CompiledFunction& fn = program.getFunctions()[ins.operand];
+            top -= fn.argCount;
+            bool anyEmpty = std::any_of(top, top + fn.argCount, [](const Interval& arg) { return arg.isEmpty(); });
+            mayFail = true;  // The callback may throw
+            *top++ = anyEmpty ? Interval::empty() : Interval::entire();
+            continue;
+        }
+
+        bool unary = ins.op == OpCode::Sin || ins.op == OpCode::Cos || ins.op == OpCode::Ln;
+        if (!unary) {
+            --top;
+        }
+        Interval& a = top[-1];
+        const Interval b = unary ? Interval::point(0) : top[0];
+        if (a.isEmpty() || b.isEmpty()) {
+            a = Interval::empty();  // No point gets this far without an error
+            continue;
+        }
+        switch (ins.op) {
+        case OpCode::Add: a = add(a, b, mayFail); break;
+        case OpCode::Sub: a = sub(a, b, mayFail); break;
+        case OpCode::Mul: a = sanitize(mul(a, b), mayFail); break;
+        case OpCode::Div: a = div(a, b, mayFail); break;
+        case OpCode::Pow: a = pow(a, b, mayFail); break;
+        case OpCode::Sin: a = periodic(a, std::sin, kPi / 2, mayFail); break;
+        case OpCode::Cos: a = periodic(a, std::cos, 0, mayFail); break;
+        case OpCode::Ln: a = ln(a, mayFail); break;
+        case OpCode::Log: a = log(a, b, mayFail); break;
+        case OpCode::Eq: a = eq(a, b, mayFail); break;
+        default: break;
+        }
+    }
+    return {top[-1], mayFail};
+}
+
+IntervalResult IntervalEvaluator::evaluate(const IntervalEnv& box) {
+    std::vector<Interval> slots = boxFromEnv(box);
+    return evaluate(slots.data());
+}
+
+std::vector<Interval> IntervalEvaluator::boxFromEnv(const IntervalEnv& env) const {
+    std::vector<Interval> slots(program.getSlotCount(), Interval::point(0));
+    for (const CompiledVariable& variable : program.getVariables()) {
+        auto it = env.find(variable.name);
+        if (it != env.end()) {
+            slots[variable.slot] = it->second;
+        }
+    }
+    return slots;
+}
+
+// **Subdivision**
+void IntervalEvaluator::checkBounded(const Interval* box) const {
+    for (const CompiledVariable& variable : program.getVariables()) {
+        const Interval& range = box[variable.slot];
+        if (!std::isfinite(range.lo) || !std::isfinite(range.hi) || range.isEmpty()) {
+            throw std::runtime_error("Subdivision needs a bounded, non-empty range for " + variable.name + ".");
+        }
+    }
+}
+
+bool IntervalEvaluator::sampleMidpoint(const Interval* box, double& value) {
+    for (const CompiledVariable& variable : program.getVariables()) {
+        point[variable.slot] = box[variable.slot].midpoint();
+    }
+    try {
+        value = program.evaluate(point.data());
+    } catch (const std::exception&) {
+        return false;
+    }
+    return !std::isnan(value);
+}
+
+bool IntervalEvaluator::splitSlot(const Interval* box, double minWidth, std::uint32_t& slot) const {
+    double widest = minWidth;
+    bool found = false;
+    for (const CompiledVariable& variable : program.getVariables()) {
+        double width = box[variable.slot].width();
+        if (width > widest) {
+            widest = width;
+            slot = variable.slot;
+            found = true;
+        }
+    }
+    return found;
+}
+
+BoundResult IntervalEvaluator::exceeds(const Interval* box, double threshold, const SubdivisionOptions& options) {
+    checkBounded(box);
+    Search search = maximize(box, 1, -kInfinity, threshold, options.maxBoxes, options.minWidth);
+    BoundResult result;
+    result.boxesEvaluated = search.boxesEvaluated;
+    if (search.attained > threshold) {
+        result.answer = BoundAnswer::Exceeds;
+        result.witness = std::move(search.witness);
+        result.witnessValue = search.attained;
+    } else if (search.bound <= threshold) {
+        result.answer = BoundAnswer::Never;
+    }
+    return result;
+}
+
+RangeResult IntervalEvaluator::range(const Interval* box, double tolerance, const SubdivisionOptions& options) {
+    checkBounded(box);
+    const std::size_t budget = std::max<std::size_t>(1, options.maxBoxes / 2);  // Half per extreme
+    Search highest = maximize(box, 1, tolerance, kInfinity, budget, options.minWidth);
+    Search lowest = maximize(box, -1, tolerance, kInfinity, budget, options.minWidth);
+    RangeResult result;
+    result.enclosure = {-lowest.bound, highest.bound};
+    result.attained = {-lowest.attained, highest.attained};
+    result.boxesEvaluated = highest.boxesEvaluated + lowest.boxesEvaluated;
+    return result;
+}
+
+// Best-first on sign * f: always split the box with the highest upper bound, so the
+// bound falls as fast as the enclosures allow, and sample each new box at its midpoint.
+// Stops once no box can beat the best sample by more than tolerance, once a sample
+// exceeds target, or when the budget is spent. Boxes whose bound is at most target can
+// never exceed it and are dropped.
+IntervalEvaluator::Search IntervalEvaluator::maximize(const Interval* box, double sign, double tolerance, double target,
+                                                      std::size_t budget, double minWidth) {
+    const std::size_t slotCount = program.getSlotCount();
+    std::vector<Interval> boxes;  // slotCount intervals per box
+    std::vector<std::size_t> freeBoxes;
+    using Candidate = std::pair<double, std::size_t>;  // Upper bound of sign * f, box index
+    std::priority_queue<Candidate> queue;
+    double settled = -kInfinity;  // Highest bound of the boxes too narrow to split
+    Search search;
+
+    auto consider = [&](const Interval* candidate) {
+        ++search.boxesEvaluated;
+        Interval range = evaluate(candidate).range;
+        if (range.isEmpty()) {
+            return;
+        }
+        double value;
+        if (sampleMidpoint(candidate, value) && sign * value > search.attained) {
+            search.attained = sign * value;
+            search.witness = point;
+        }
+        double upper = sign > 0 ? range.hi : -range.lo;
+        if (upper <= target && target < kInfinity) {
+            return;
+        }
+        std::size_t index;
+        if (freeBoxes.empty()) {
+            index = boxes.size() / slotCount;
+            boxes.insert(boxes.end(), candidate, candidate + slotCount);
+        } else {
+            index = freeBoxes.back();
+            freeBoxes.pop_back();
+            std::copy(candidate, candidate + slotCount, boxes.begin() + index * slotCount);
+        }
+        queue.push({upper, index});
+    };
+
+    consider(box);
+    std::vector<Interval> current(slotCount);
+    while (!queue.empty() && search.attained <= target && search.boxesEvaluated + 2 <= budget) {
+        auto [upper, index] = queue.top();
+        if (upper <= std::max(search.attained, settled) + tolerance) {
+            break;
+        }
+        queue.pop();
+        std::copy(boxes.begin() + index * slotCount, boxes.begin() + (index + 1) * slotCount, current.begin());
+        freeBoxes.push_back(index);
+        std::uint32_t slot;
+        if (!splitSlot(current.data(), minWidth, slot)) {
+            settled = std::max(settled, upper);
+            continue;
+        }
+        double middle = current[slot].midpoint();
+        Interval upperHalf{middle, current[slot].hi};
+        current[slot].hi = middle;
+        consider(current.data());
+        current[slot] = upperHalf;
+        consider(current.data());
+    }
+    // Dropped boxes are at most target, which only matters when nothing else is left.
+    search.bound = std::max({settled, search.attained, queue.empty() ? -kInfinity : queue.top().first});
+    return search;
+}
+
+const CompiledExpr& IntervalEvaluator::getProgram() const {
+    return program;
+}
+
+std::size_t IntervalEvaluator::getSlotCount() const {
+    return program.getSlotCount();
+}
+
+} // namespace Expression
@@ -0,0 +1,218 @@
+#include "autodiff/dual_evaluator.h"
+
+#include <algorithm>
+
+namespace Expression {
+
+DualEvaluator::DualEvaluator(const CompiledExpr& program) : program(program) {}
+
+DualEvaluator::DualEvaluator(const Node* root) : program(root) {}
+
+Dual DualEvaluator::evaluateDual(const double* slots, const double* direction) {
+    Dual result;
+    result.value = evaluateLanes(slots, direction, 1, &result.tangent);
+    return result;
+}
+
+Dual DualEvaluator::evaluateDual(const Env& env, const Env& direction) {
+    std::vector<double> slots(program.getSlotCount(), 0.0);
+    std::vector<double> seeds(program.getSlotCount(), 0.0);
+    for (const CompiledVariable& variable : program.getVariables()) {
+        auto value = env.find(variable.name);
+        slots[variable.slot] = value != env.end() ? value->second : 0.0;
+        auto tangent = direction.find(variable.name);
+        seeds[variable.slot] = tangent != direction.end() ? tangent->second : 0.0;
+    }
+    return evaluateDual(slots.data(), seeds.data());
+}
+
+// **Lane-parallel forward sweep (same checks and errors as CompiledExpr::evaluate)**
+double DualEvaluator::evaluateLanes(const double* slots, const double* seeds, std::size_t lanes, double* tangents) {
+    stack.resize(program.getMaxStackDepth());
+    tangentStack.resize(program.getMaxStackDepth() * lanes);
+    temps.resize(program.getTempCount());
+    tempTangents.resize(program.getTempCount() * lanes);
+
+    const std::vector<double>& constants = program.getConstants();
+    double* v = stack.data();
+    double* t = tangentStack.data();
+    std::size_t sp = 0;  // Entries on the stack
+
+    for (const Instruction& ins : program.getCode()) {
+        switch (ins.op) {
+        case OpCode::PushConst: {
+            v[sp] = constants[ins.operand];
+            std::fill(t + sp * lanes, t + (sp + 1) * lanes, 0.0);
+            ++sp;
+            break;
+        }
+        case OpCode::LoadVar: {
+            v[sp] = slots[ins.operand];
+            std::copy(seeds + ins.operand * lanes, seeds + (ins.operand + 1) * lanes, t + sp * lanes);
+            ++sp;
+            break;
+        }
+        case OpCode::StoreTemp:
+            temps[ins.operand] = v[sp - 1];
+            std::copy(t + (sp - 1) * lanes, t + sp * lanes, tempTangents.data() + ins.operand * lanes);
+            break;
+        case OpCode::LoadTemp:
+            v[sp] = temps[ins.operand];
+            std::copy(tempTangents.data() + ins.operand * lanes, tempTangents.data() + (ins.operand + 1) * lanes,
+                      t + sp * lanes);
+            ++sp;
+            break;
+        case OpCode::Sin:
+        case OpCode::Cos:
+        case OpCode::Ln: {
+            const double a = v[sp - 1];
+            double* ta = t + (sp - 1) * lanes;
+            double scale;
+            if (ins.op == OpCode::Sin) {
+                v[sp - 1] = std::sin(a);
+                scale = std::cos(a);
+            } else if (ins.op == OpCode::Cos) {
+                v[sp - 1] = std::cos(a);
+                scale = -std::sin(a);
+            } else {
+                if (a <= 0) {
+                    throw std::runtime_error("Math error: ln of non-positive number.");
+                }
+                v[sp - 1] = std::log(a);
+                scale = 1 / a;
+            }
+            for (std::size_t k = 0; k < lanes; ++k) {
+                ta[k] *= scale;
+            }
+            break;
+        }
+        case OpCode::Call: {
+            const CompiledFunction& fn = program.getFunctions()[ins.operand];
+            const std::size_t n = static_cast<std::size_t>(fn.argCount);
+            sp -= n;
+            args.assign(v + sp, v + sp + n);
+            v[sp] = fn.callback(args);
+            // Value first, as GradientTape does; partials only for arguments some lane moves.
+            double* out = t + sp * lanes;
+            partialsOfCall.resize(n);
+            for (std::size_t j = 0; j < n; ++j) {
+                const double* tj = out + j * lanes;
+                if (std::all_of(tj, tj + lanes, [](double tangent) { return tangent == 0; })) {
+                    partialsOfCall[j] = 0;
+                    continue;
+                }
+                if (!fn.derivative) {
+                    throw std::runtime_error("Cannot differentiate function " + fn.name + ": no derivative callback.");
+                }
+                partialsOfCall[j] = fn.derivative(args, j);
+            }
+            for (std::size_t k = 0; k < lanes; ++k) {
+                double sum = 0;
+                for (std::size_t j = 0; j < n; ++j) {
+                    sum += partialsOfCall[j] * out[j * lanes + k];
+                }
+                out[k] = sum;
+            }
+            ++sp;
+            break;
+        }
+        default: {
+            // Binary: result = f(a, b), tangent = da * ta + db * tb
+            --sp;
+            const double a = v[sp - 1];
+            const double b = v[sp];
+            double* ta = t + (sp - 1) * lanes;
+            const double* tb = ta + lanes;
+            double result;
+            double da = 0;
+            double db = 0;
+            switch (ins.op) {
+            case OpCode::Add:
+                result = a + b;
+                da = 1;
+                db = 1;
+                break;
+            case OpCode::Sub:
+                result = a - b;
+                da = 1;
+                db = -1;
+                break;
+            case OpCode::Mul:
+                result = a * b;
+                da = b;
+                db = a;
+                break;
+            case OpCode::Div:
+                if (b == 0) {
+                    throw std::runtime_error(program.getErrorMessages()[ins.operand]);
+                }
+                result = a / b;
+                da = 1 / b;
+                db = -result / b;
+                break;
+            case OpCode::Pow:
+                if (a == 0 && b <= 0) {
+                    throw std::runtime_error("Math error: 0 raised to a non-positive exponent.");
+                }
+                result = std::pow(a, b);
+                da = b * std::pow(a, b - 1);
+                db = a > 0 ? result * std::log(a) : 0.0;
+                break;
+            case OpCode::Log: {
+                if (a <= 0 || a == 1 || b <= 0) {
+                    throw std::runtime_error("Math error: log with invalid base or operand.");
+                }
+                const double lnBase = std::log(a);
+                result = std::log(b) / lnBase;
+                da = -result / (a * lnBase);
+                db = 1 / (b * lnBase);
+                break;
+            }
+            case OpCode::Eq:
+                result = std::fabs(a - b) < 1e-9 ? 1.0 : 0.0;
+                break;
+            default:
+                throw std::runtime_error("Unsupported instruction in dual evaluation.");
+            }
+            v[sp - 1] = result;
+            for (std::size_t k = 0; k < lanes; ++k) {
+                ta[k] = da * ta[k] + db * tb[k];
+            }
+            break;
+        }
+        }
+    }
+    std::copy(t, t + lanes, tangents);
+    return v[0];
+}
+
+// **Jacobian columns: one identity-seeded sweep per block of kDualLaneCount slots**
+double DualEvaluator::evaluatePartials(const double* slots, double* partials) {
+    const std::size_t slotCount = program.getSlotCount();
+    double value = 0;
+    if (slotCount == 0) {
+        return evaluateLanes(slots, nullptr, 0, nullptr);
+    }
+    seedBlock.resize(slotCount * kDualLaneCount);
+    double blockTangents[kDualLaneCount];
+    for (std::size_t first = 0; first < slotCount; first += kDualLaneCount) {
+        const std::size_t lanes = std::min(kDualLaneCount, slotCount - first);
+        std::fill(seedBlock.begin(), seedBlock.begin() + slotCount * lanes, 0.0);
+        for (std::size_t k = 0; k < lanes; ++k) {
+            seedBlock[(first + k) * lanes + k] = 1.0;
+        }
+        value = evaluateLanes(slots, seedBlock.data(), lanes, blockTangents);
+        std::copy(blockTangents, blockTangents + lanes, partials + first);
+    }
+    return value;
+}
+
+const CompiledExpr& DualEvaluator::getProgram() const {
+    return program;
+}
+
+std::size_t DualEvaluator::getSlotCount() const {
+    return program.getSlotCount();
+}
+
+} // namespace Expression
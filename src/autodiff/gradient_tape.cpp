@@ -0,0 +1,243 @@
+#include "autodiff/gradient_tape.h"
+
+namespace Expression {
+
+GradientTape::GradientTape(const CompiledExpr& program) {
+    build(program);
+}
+
+GradientTape::GradientTape(const Node* root) {
+    build(CompiledExpr(root));
+}
+
+// **Tape construction: replay the stack machine on entry indexes instead of values**
+void GradientTape::build(const CompiledExpr& program) {
+    constants = program.getConstants();
+    functions = program.getFunctions();
+    errorMessages = program.getErrorMessages();
+    variables = program.getVariables();
+    slotCount = program.getSlotCount();
+
+    std::vector<std::uint32_t> stack;
+    std::vector<std::uint32_t> temps(program.getTempCount());
+    for (const Instruction& ins : program.getCode()) {
+        Entry entry{ins.op, ins.operand, {0, 0}, 0};
+        switch (ins.op) {
+        case OpCode::StoreTemp:
+            temps[ins.operand] = stack.back();
+            continue;
+        case OpCode::LoadTemp:
+            stack.push_back(temps[ins.operand]);
+            continue;
+        case OpCode::PushConst:
+        case OpCode::LoadVar:
+            break;
+        case OpCode::Sin:
+        case OpCode::Cos:
+        case OpCode::Ln:
+            entry.args[0] = stack.back();
+            stack.pop_back();
+            break;
+        case OpCode::Call: {
+            std::size_t argCount = static_cast<std::size_t>(functions[ins.operand].argCount);
+            entry.callArgs = static_cast<std::uint32_t>(callArgs.size());
+            callArgs.insert(callArgs.end(), stack.end() - argCount, stack.end());
+            stack.resize(stack.size() - argCount);
+            break;
+        }
+        default:
+            entry.args[1] = stack.back();
+            stack.pop_back();
+            entry.args[0] = stack.back();
+            stack.pop_back();
+            break;
+        }
+        stack.push_back(static_cast<std::uint32_t>(entries.size()));
+        entries.push_back(entry);
+    }
+    values.resize(entries.size());
+    adjoints.resize(entries.size());
+}
+
+// **Forward sweep (same checks and errors as CompiledExpr::evaluate)**
+void GradientTape::forward(const double* slots) {
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const Entry& entry = entries[i];
+        const double a = values[entry.args[0]];
+        const double b = values[entry.args[1]];
+        switch (entry.op) {
+        case OpCode::PushConst:
+            values[i] = constants[entry.operand];
+            break;
+        case OpCode::LoadVar:
+            values[i] = slots[entry.operand];
+            break;
+        case OpCode::Add:
+            values[i] = a + b;
+            break;
+        case OpCode::Sub:
+            values[i] = a - b;
+            break;
+        case OpCode::Mul:
+            values[i] = a * b;
+            break;
+        case OpCode::Div:
+            if (b == 0) {
+                throw std::runtime_error(errorMessages[entry.operand]);
+            }
+            values[i] = a / b;
+            break;
+        case OpCode::Pow:
+            if (a == 0 && b <= 0) {
+                throw std::runtime_error("Math error: 0 raised to a non-positive exponent.");
+            }
+            values[i] = std::pow(a, b);
+            break;
+        case OpCode::Sin:
+            values[i] = std::sin(a);
+            break;
+        case OpCode::Cos:
+            values[i] = std::cos(a);
+            break;
+        case OpCode::Ln:
+            if (a <= 0) {
+                throw std::runtime_error("Math error: ln of non-positive number.");
+            }
+            values[i] = std::log(a);
+            break;
+        case OpCode::Log:
+            if (a <= 0 || a == 1 || b <= 0) {
+                throw std::runtime_error("Math error: log with invalid base or operand.");
+            }
+            values[i] = std::log(b) / std::log(a);
+            break;
+        case OpCode::Eq:
+            values[i] = std::fabs(a - b) < 1e-9 ? 1.0 : 0.0;
+            break;
+        case OpCode::Call:
+            values[i] = functions[entry.operand].callback(gatherArgs(entry));
+            break;
+        default:
+            throw std::runtime_error("Unsupported instruction on the gradient tape.");
+        }
+    }
+}
+
+// **Backward sweep: push each entry's adjoint onto its operands**
+void GradientTape::backward(double* gradient) {
+    std::fill(gradient, gradient + slotCount, 0.0);
+    std::fill(adjoints.begin(), adjoints.end(), 0.0);
+    adjoints.back() = 1.0;
+
+    for (std::size_t i = entries.size(); i-- > 0;) {
+        const Entry& entry = entries[i];
+        const double g = adjoints[i];
+        if (g == 0) {
+            continue;
+        }
+        const double a = values[entry.args[0]];
+        const double b = values[entry.args[1]];
+        double& da = adjoints[entry.args[0]];
+        double& db = adjoints[entry.args[1]];
+        switch (entry.op) {
+        case OpCode::LoadVar:
+            gradient[entry.operand] += g;
+            break;
+        case OpCode::Add:
+            da += g;
+            db += g;
+            break;
+        case OpCode::Sub:
+            da += g;
+            db -= g;
+            break;
+        case OpCode::Mul:
+            da += g * b;
+            db += g * a;
+            break;
+        case OpCode::Div:
+            da += g / b;
+            db -= g * values[i] / b;
+            break;
+        case OpCode::Pow:
+            da += g * b * std::pow(a, b - 1);
+            if (a > 0) {
+                db += g * values[i] * std::log(a);
+            }
+            break;
+        case OpCode::Sin:
+            da += g * std::cos(a);
+            break;
+        case OpCode::Cos:
+            da -= g * std::sin(a);
+            break;
+        case OpCode::Ln:
+            da += g / a;
+            break;
+        case OpCode::Log: {
+            // log_a(b) = ln(b) / ln(a)
+            const double lnBase = std::log(a);
+            db += g / (b * lnBase);
+            da -= g * values[i] / (a * lnBase);
+            break;
+        }
+        case OpCode::Call: {
+            const CompiledFunction& fn = functions[entry.operand];
+            if (!fn.derivative) {
+                throw std::runtime_error("Cannot differentiate function " + fn.name + ": no derivative callback.");
+            }
+            const std::vector<double>& argValues = gatherArgs(entry);
+            for (std::size_t k = 0; k < argValues.size(); ++k) {
+                adjoints[callArgs[entry.callArgs + k]] += g * fn.derivative(argValues, k);
+            }
+            break;
+        }
+        default:
+            break;  // Constants and equality
+        }
+    }
+}
+
+const std::vector<double>& GradientTape::gatherArgs(const Entry& entry) {
+    std::size_t argCount = static_cast<std::size_t>(functions[entry.operand].argCount);
+    args.resize(argCount);
+    for (std::size_t k = 0; k < argCount; ++k) {
+        args[k] = values[callArgs[entry.callArgs + k]];
+    }
+    return args;
+}
+
+double GradientTape::evaluateGradient(const double* slots, double* gradient) {
+    forward(slots);
+    backward(gradient);
+    return values.back();
+}
+
+double GradientTape::evaluateGradient(const Env& env, Env& gradient) {
+    // Missing variables default to 0, as in VariableNode::evaluate.
+    std::vector<double> slots(slotCount, 0.0);
+    for (const CompiledVariable& variable : variables) {
+        auto it = env.find(variable.name);
+        slots[variable.slot] = it != env.end() ? it->second : 0.0;
+    }
+    std::vector<double> partials(slotCount);
+    double value = evaluateGradient(slots.data(), partials.data());
+    for (const CompiledVariable& variable : variables) {
+        gradient[variable.name] = partials[variable.slot];
+    }
+    return value;
+}
+
+const std::vector<CompiledVariable>& GradientTape::getVariables() const {
+    return variables;
+}
+
+std::size_t GradientTape::getSlotCount() const {
+    return slotCount;
+}
+
+std::size_t GradientTape::getTapeLength() const {
+    return entries.size();
+}
+
+} // namespace Expression
@@ -0,0 +1,332 @@
+#include "autodiff/jacobian_engine.h"
+#include "compiler/node_shape.h"
+#include "expression/number_node.h"
+#include "expression/variable_node.h"
+
+namespace Expression {
+
+namespace {
+
+constexpr std::uint32_t kNoError = 0;
+constexpr std::uint32_t kPowError = 1;
+constexpr std::uint32_t kLnError = 2;
+constexpr std::uint32_t kLogError = 3;
+
+// Names of the variables a tree reads.
+void collectVariables(const Node* node, std::unordered_set<const Node*>& visited,
+                      std::unordered_set<std::string>& names) {
+    if (!visited.insert(node).second) {
+        return;
+    }
+    NodeShape shape = shapeOf(node);
+    if (shape.op == OpCode::LoadVar) {
+        names.insert(shape.variable->getName());
+    }
+    for (std::size_t i = 0; i < shape.arity; ++i) {
+        collectVariables(shape.operand(i), visited, names);
+    }
+}
+
+bool isZero(const Node* node) {
+    const NumberNode* number = node->as<NumberNode>();
+    return number && number->getValue() == 0;
+}
+
+} // namespace
+
+JacobianEngine::JacobianEngine(const std::vector<Node*>& expressions, const std::vector<std::string>& variables,
+                               ExprArena& arena, JacobianOptions options)
+    : rowCount(expressions.size()), columnCount(variables.size()), withHessians(options.hessians),
+      errorMessages{"", "Math error: 0 raised to a non-positive exponent.", "Math error: ln of non-positive number.",
+                    "Math error: log with invalid base or operand."},
+      zeroPattern(expressions.size() * variables.size(), true) {
+    std::unordered_set<std::string> distinct(variables.begin(), variables.end());
+    if (distinct.size() != variables.size()) {
+        throw std::runtime_error("JacobianEngine: a variable is listed twice.");
+    }
+
+    // Values first, then the partials: evaluate() runs only this prefix of the program.
+    std::vector<std::unordered_set<std::string>> rowVariables(rowCount);
+    for (std::size_t row = 0; row < rowCount; ++row) {
+        std::unordered_set<const Node*> visited;
+        collectVariables(expressions[row], visited, rowVariables[row]);
+        valueOutputs.push_back({lower(expressions[row]), row});
+    }
+    struct Partial {
+        std::size_t row;
+        std::size_t column;
+        Node* node;
+    };
+    std::vector<Partial> partials;
+    for (std::size_t row = 0; row < rowCount; ++row) {
+        for (std::size_t column = 0; column < columnCount; ++column) {
+            if (!rowVariables[row].count(variables[column])) {
+                continue;
+            }
+            Node* partial = expressions[row]->derivative(variables[column], arena)->simplify(arena);
+            if (isZero(partial)) {
+                continue;
+            }
+            zeroPattern[row * columnCount + column] = false;
+            partials.push_back({row, column, partial});
+            jacobianOutputs.push_back({lower(partial), row * columnCount + column});
+        }
+    }
+    jacobianLength = entries.size();
+
+    // Second partials of the non-zero first ones, upper triangle only.
+    if (withHessians) {
+        for (const Partial& partial : partials) {
+            for (std::size_t k = partial.column; k < columnCount; ++k) {
+                if (zeroPattern[partial.row * columnCount + k]) {
+                    continue;  // The row does not depend on x_k at all
+                }
+                Node* second = partial.node->derivative(variables[k], arena)->simplify(arena);
+                if (isZero(second)) {
+                    continue;
+                }
+                std::size_t base = partial.row * columnCount * columnCount;
+                hessianOutputs.push_back({lower(second), base + partial.column * columnCount + k});
+                hessianMirrors.push_back(base + k * columnCount + partial.column);
+            }
+        }
+    }
+    entryOf.clear();
+    values.resize(entries.size());
+    errors.resize(entries.size());
+}
+
+// **Lowering: one entry per structurally distinct subexpression, across all outputs**
+std::uint32_t JacobianEngine::lower(const Node* node) {
+    auto it = entryOf.find(node);
+    if (it != entryOf.end()) {
+        return it->second;
+    }
+    NodeShape shape = shapeOf(node);
+    Entry entry{shape.op, 0, {0, 0}};
+    switch (shape.op) {
+    case OpCode::PushConst:
+        entry.operand = static_cast<std::uint32_t>(constants.size());
+        constants.push_back(shape.value);
+        break;
+    case OpCode::LoadVar: {
+        std::size_t slot = shape.variable->getSlot();
+        entry.operand = static_cast<std::uint32_t>(slot);
+        slotCount = std::max(slotCount, slot + 1);
+        bool known = std::any_of(programVariables.begin(), programVariables.end(),
+                                 [&](const CompiledVariable& variable) { return variable.slot == slot; });
+        if (!known) {
+            programVariables.push_back({shape.variable->getName(), static_cast<std::uint32_t>(slot)});
+        }
+        break;
+    }
+    case OpCode::Call: {
+        std::vector<std::uint32_t> args;
+        for (std::size_t i = 0; i < shape.arity; ++i) {
+            args.push_back(lower(shape.operand(i)));
+        }
+        entry.operand = static_cast<std::uint32_t>(functions.size());
+        functions.push_back(shape.function->getCallback());
+        entry.args[0] = static_cast<std::uint32_t>(callArgs.size());
+        entry.args[1] = static_cast<std::uint32_t>(args.size());
+        callArgs.insert(callArgs.end(), args.begin(), args.end());
+        break;
+    }
+    default:
+        entry.args[0] = lower(shape.operand(0));
+        entry.args[1] = shape.arity == 2 ? lower(shape.operand(1)) : entry.args[0];
+        if (shape.op == OpCode::Div) {
+            entry.operand = static_cast<std::uint32_t>(errorMessages.size());
+            errorMessages.push_back("Division by zero error in " + node->toString());
+        }
+        break;
+    }
+    std::uint32_t index = static_cast<std::uint32_t>(entries.size());
+    entries.push_back(entry);
+    entryOf.emplace(node, index);
+    return index;
+}
+
+// **Evaluation**
+// Every entry carries the error its own Node::evaluate would raise first: the left
+// operand's, else the right operand's, else its own check. Values are computed regardless,
+// so one failing entry does not stop the others.
+void JacobianEngine::sweep(const double* slots, std::size_t length) {
+    thrownMessages.clear();
+    for (std::size_t i = 0; i < length; ++i) {
+        const Entry& entry = entries[i];
+        if (entry.op == OpCode::Call) {
+            call(i);
+            continue;
+        }
+        const double a = values[entry.args[0]];
+        const double b = values[entry.args[1]];
+        std::uint32_t error = kNoError;
+        if (entry.op != OpCode::PushConst && entry.op != OpCode::LoadVar) {
+            error = errors[entry.args[0]] ? errors[entry.args[0]] : errors[entry.args[1]];
+        }
+        switch (entry.op) {
+        case OpCode::PushConst:
+            values[i] = constants[entry.operand];
+            break;
+        case OpCode::LoadVar:
+            values[i] = slots[entry.operand];
+            break;
+        case OpCode::Add:
+            values[i] = a + b;
+            break;
+        case OpCode::Sub:
+            values[i] = a - b;
+            break;
+        case OpCode::Mul:
+            values[i] = a * b;
+            break;
+        case OpCode::Div:
+            if (b == 0 && !error) {
+                error = entry.operand;
+            }
+            values[i] = a / b;
+            break;
+        case OpCode::Pow:
+            if (a == 0 && b <= 0 && !error) {
+                error = kPowError;
+            }
+            values[i] = std::pow(a, b);
+            break;
+        case OpCode::Sin:
+            values[i] = std::sin(a);
+            break;
+        case OpCode::Cos:
+            values[i] = std::cos(a);
+            break;
+        case OpCode::Ln:
+            if (a <= 0 && !error) {
+                error = kLnError;
+            }
+            values[i] = std::log(a);
+            break;
+        case OpCode::Log:
+            if ((a <= 0 || a == 1 || b <= 0) && !error) {
+                error = kLogError;
+            }
+            values[i] = std::log(b) / std::log(a);
+            break;
+        case OpCode::Eq:
+            values[i] = std::fabs(a - b) < 1e-9 ? 1.0 : 0.0;
+            break;
+        default:
+            throw std::runtime_error("Unsupported instruction in the Jacobian program.");
+        }
+        errors[i] = error;
+    }
+}
+
+// Arguments fail first, in order; then whatever the callback throws.
+void JacobianEngine::call(std::size_t index) {
+    const Entry& entry = entries[index];
+    const std::uint32_t* args = callArgs.data() + entry.args[0];
+    std::uint32_t error = kNoError;
+    callValues.resize(entry.args[1]);
+    for (std::uint32_t k = 0; k < entry.args[1]; ++k) {
+        callValues[k] = values[args[k]];
+        if (!error) {
+            error = errors[args[k]];
+        }
+    }
+    values[index] = 0;
+    if (!error) {
+        try {
+            values[index] = functions[entry.operand](callValues);
+        } catch (const std::exception& ex) {
+            error = static_cast<std::uint32_t>(errorMessages.size() + thrownMessages.size());
+            thrownMessages.push_back(ex.what());
+        }
+    }
+    errors[index] = error;
+}
+
+void JacobianEngine::checkErrors(const std::vector<Output>& outputs) const {
+    for (const Output& output : outputs) {
+        std::uint32_t error = errors[output.entry];
+        if (error != kNoError) {
+            throw std::runtime_error(error < errorMessages.size() ? errorMessages[error]
+                                                                  : thrownMessages[error - errorMessages.size()]);
+        }
+    }
+}
+
+void JacobianEngine::evaluate(const double* slots, double* valuesOut, double* jacobian) {
+    sweep(slots, jacobianLength);
+    if (valuesOut) {
+        checkErrors(valueOutputs);
+    }
+    checkErrors(jacobianOutputs);
+    if (valuesOut) {
+        for (const Output& output : valueOutputs) {
+            valuesOut[output.position] = values[output.entry];
+        }
+    }
+    std::fill(jacobian, jacobian + rowCount * columnCount, 0.0);
+    for (const Output& output : jacobianOutputs) {
+        jacobian[output.position] = values[output.entry];
+    }
+}
+
+void JacobianEngine::evaluate(const Env& env, double* valuesOut, double* jacobian) {
+    std::vector<double> slots(slotCount, 0.0);
+    for (const CompiledVariable& variable : programVariables) {
+        auto it = env.find(variable.name);
+        if (it != env.end()) {
+            slots[variable.slot] = it->second;
+        }
+    }
+    evaluate(slots.data(), valuesOut, jacobian);
+}
+
+void JacobianEngine::evaluateHessians(const double* slots, double* hessians) {
+    if (!withHessians) {
+        throw std::runtime_error("JacobianEngine was built without Hessians (see JacobianOptions).");
+    }
+    sweep(slots, entries.size());
+    checkErrors(hessianOutputs);
+    std::fill(hessians, hessians + rowCount * columnCount * columnCount, 0.0);
+    for (std::size_t i = 0; i < hessianOutputs.size(); ++i) {
+        double value = values[hessianOutputs[i].entry];
+        hessians[hessianOutputs[i].position] = value;
+        hessians[hessianMirrors[i]] = value;
+    }
+}
+
+std::size_t JacobianEngine::getRowCount() const {
+    return rowCount;
+}
+
+std::size_t JacobianEngine::getColumnCount() const {
+    return columnCount;
+}
+
+std::size_t JacobianEngine::getSlotCount() const {
+    return slotCount;
+}
+
+bool JacobianEngine::isStructurallyZero(std::size_t row, std::size_t column) const {
+    return zeroPattern[row * columnCount + column];
+}
+
+std::size_t JacobianEngine::getNonZeroCount() const {
+    return jacobianOutputs.size();
+}
+
+std::size_t JacobianEngine::getHessianNonZeroCount() const {
+    return hessianOutputs.size();
+}
+
+std::size_t JacobianEngine::getProgramLength() const {
+    return entries.size();
+}
+
+std::size_t JacobianEngine::getJacobianProgramLength() const {
+    return jacobianLength;
+}
+
+} // namespace Expression
@@ -0,0 +1,243 @@
+#include "compiler/compiled_expr.h"
+#include "compiler/cse_pass.h"
+#include "expression/variable_node.h"
+
+namespace Expression {
+
+namespace {
+
+// Value stacks, slot and temp arrays up to this size live on the C++ stack; larger ones use the heap.
+constexpr std::size_t kInlineBufferSize = 64;
+
+} // namespace
+
+CompiledExpr::CompiledExpr(const Node* root, CompileOptions options) {
+    if (!root) {
+        throw std::runtime_error("Cannot compile a null expression.");
+    }
+    if (options.eliminateCommonSubexpressions) {
+        CsePass cse(root);
+        lower(root, &cse);
+        std::uint64_t computed = 0;
+        for (const Instruction& ins : code) {
+            computed += ins.op != OpCode::StoreTemp && ins.op != OpCode::LoadTemp;
+        }
+        eliminatedNodeCount = cse.getTreeNodeCount() - computed;
+        tempOfValue.clear();
+    } else {
+        lower(root, nullptr);
+    }
+}
+
+// **Lowering (postorder, left operand first to match Node::evaluate)**
+void CompiledExpr::lower(const Node* node, const CsePass* cse) {
+    std::uint32_t value = 0;
+    if (cse) {
+        value = cse->valueNumber(node);
+        auto temp = tempOfValue.find(value);
+        if (temp != tempOfValue.end()) {
+            emit(OpCode::LoadTemp, temp->second, +1);
+            return;
+        }
+    }
+
+    NodeShape shape = shapeOf(node);
+    for (std::size_t i = 0; i < shape.arity; ++i) {
+        lower(shape.operand(i), cse);
+    }
+
+    switch (shape.op) {
+    case OpCode::PushConst:
+        constants.push_back(shape.value);
+        emit(OpCode::PushConst, static_cast<std::uint32_t>(constants.size() - 1), +1);
+        break;
+    case OpCode::LoadVar:
+        recordVariable(shape.variable->getName(), shape.variable->getSlot());
+        emit(OpCode::LoadVar, static_cast<std::uint32_t>(shape.variable->getSlot()), +1);
+        break;
+    case OpCode::Div:
+        errorMessages.push_back("Division by zero error in " + node->toString());
+        emit(OpCode::Div, static_cast<std::uint32_t>(errorMessages.size() - 1), -1);
+        break;
+    case OpCode::Call:
+        functions.push_back({shape.function->getName(), shape.function->getExpectedArgCount(),
+                             shape.function->getCallback(), shape.function->getDerivativeCallback()});
+        emit(OpCode::Call, static_cast<std::uint32_t>(functions.size() - 1), 1 - static_cast<int>(shape.arity));
+        break;
+    default:
+        emit(shape.op, 0, 1 - static_cast<int>(shape.arity));
+        break;
+    }
+
+    if (cse && cse->isShared(value)) {
+        std::uint32_t temp = static_cast<std::uint32_t>(tempCount++);
+        tempOfValue.emplace(value, temp);
+        emit(OpCode::StoreTemp, temp, 0);
+    }
+}
+
+void CompiledExpr::emit(OpCode op, std::uint32_t operand, int stackEffect) {
+    code.push_back({op, operand});
+    stackDepth = static_cast<std::size_t>(static_cast<long>(stackDepth) + stackEffect);
+    maxStackDepth = std::max(maxStackDepth, stackDepth);
+}
+
+void CompiledExpr::recordVariable(const std::string& name, std::size_t slot) {
+    for (const CompiledVariable& variable : variables) {
+        if (variable.slot == slot) {
+            return;
+        }
+    }
+    variables.push_back({name, static_cast<std::uint32_t>(slot)});
+    slotCount = std::max(slotCount, slot + 1);
+}
+
+// **Evaluation**
+double CompiledExpr::evaluate(const Env &env) const {
+    // Missing variables default to 0, as in VariableNode::evaluate.
+    double inlineSlots[kInlineBufferSize];
+    std::vector<double> heapSlots;
+    double* slots = inlineSlots;
+    if (slotCount > kInlineBufferSize) {
+        heapSlots.resize(slotCount);
+        slots = heapSlots.data();
+    }
+    for (const CompiledVariable& variable : variables) {
+        auto it = env.find(variable.name);
+        slots[variable.slot] = it != env.end() ? it->second : 0.0;
+    }
+    return evaluate(slots);
+}
+
+double CompiledExpr::evaluate(const double* slots) const {
+    double inlineStack[kInlineBufferSize];
+    std::vector<double> heapStack;
+    double* stack = inlineStack;
+    if (maxStackDepth > kInlineBufferSize) {
+        heapStack.resize(maxStackDepth);
+        stack = heapStack.data();
+    }
+
+    double inlineTemps[kInlineBufferSize];
+    std::vector<double> heapTemps;
+    double* temps = inlineTemps;
+    if (tempCount > kInlineBufferSize) {
+        heapTemps.resize(tempCount);
+        temps = heapTemps.data();
+    }
+
+    std::vector<double> args;
+    double* top = stack;  // One past the topmost value.
+
+    for (const Instruction& ins : code) {
+        switch (ins.op) {
+        case OpCode::PushConst:
+            *top++ = constants[ins.operand];
+            break;
+        case OpCode::LoadVar:
+            *top++ = slots[ins.operand];
+            break;
+        case OpCode::Add:
+            --top;
+            top[-1] = top[-1] + top[0];
+            break;
+        case OpCode::Sub:
+            --top;
+            top[-1] = top[-1] - top[0];
+            break;
+        case OpCode::Mul:
+            --top;
+            top[-1] = top[-1] * top[0];
+            break;
+        case OpCode::Div:
+            --top;
+            if (top[0] == 0) {
+                throw std::runtime_error(errorMessages[ins.operand]);
+            }
+            top[-1] = top[-1] / top[0];
+            break;
+        case OpCode::Pow:
+            --top;
+            if (top[-1] == 0 && top[0] <= 0) {
+                throw std::runtime_error("Math error: 0 raised to a non-positive exponent.");
+            }
+            top[-1] = std::pow(top[-1], top[0]);
+            break;
+        case OpCode::Sin:
+            top[-1] = std::sin(top[-1]);
+            break;
+        case OpCode::Cos:
+            top[-1] = std::cos(top[-1]);
+            break;
+        case OpCode::Ln:
+            if (top[-1] <= 0) {
+                throw std::runtime_error("Math error: ln of non-positive number.");
+            }
+            top[-1] = std::log(top[-1]);
+            break;
+        case OpCode::Log:
+            --top;
+            if (top[-1] <= 0 || top[-1] == 1 || top[0] <= 0) {
+                throw std::runtime_error("Math error: log with invalid base or operand.");
+            }
+            top[-1] = std::log(top[0]) / std::log(top[-1]);
+            break;
+        case OpCode::Eq:
+            --top;
+            top[-1] = std::fabs(top[-1] - top[0]) < 1e-9 ? 1.0 : 0.0;
+            break;
+        case OpCode::Call: {
+            const CompiledFunction& fn = functions[ins.operand];
+            top -= fn.argCount;
+            args.assign(top, top + fn.argCount);
+            *top++ = fn.callback(args);
+            break;
+        }
+        case OpCode::StoreTemp:
+            temps[ins.operand] = top[-1];
+            break;
+        case OpCode::LoadTemp:
+            *top++ = temps[ins.operand];
+            break;
+        }
+    }
+    return top[-1];
+}
+
+const std::vector<Instruction>& CompiledExpr::getCode() const {
+    return code;
+}
+
+const std::vector<double>& CompiledExpr::getConstants() const {
+    return constants;
+}
+
+const std::vector<CompiledVariable>& CompiledExpr::getVariables() const {
+    return variables;
+}
+
+const std::vector<CompiledFunction>& CompiledExpr::getFunctions() const {
+    return functions;
+}
+
+const std::vector<std::string>& CompiledExpr::getErrorMessages() const {
+    return errorMessages;
+}
+
+std::size_t CompiledExpr::getMaxStackDepth() const {
+    return maxStackDepth;
+}
+
+std::size_t CompiledExpr::getSlotCount() const {
+    return slotCount;
+}
+
+std::size_t CompiledExpr::getTempCount() const {
+    return tempCount;
+}
+
+std::uint64_t CompiledExpr::getEliminatedNodeCount() const {
+    return eliminatedNodeCount;
+}
+
+} // namespace Expression
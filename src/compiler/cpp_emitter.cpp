@@ -0,0 +1,380 @@
+#include "compiler/cpp_emitter.h"
+#include "compiler/node_shape.h"
+#include "memory/expr_arena.h"
+
+namespace Expression {
+
+namespace {
+
+// Compilers rewrite pow with a literal operand (pow(x, 2.0) as x * x, pow(2.0, x) as
+// exp2(x)), which can differ in the last bit from the libm pow Node::evaluate calls. The
+// volatile operands keep the call as it is.
+constexpr const char* kPowerHelper =
+    "namespace {\n\n"
+    "double power(double base, double exponent) {\n"
+    "    volatile double opaqueBase = base;\n"
+    "    volatile double opaqueExponent = exponent;\n"
+    "    return std::pow(opaqueBase, opaqueExponent);\n"
+    "}\n\n"
+    "} // namespace\n\n";
+
+bool isIdentifier(const std::string& name) {
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(), [](char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    });
+}
+
+// Exact literal: hexadecimal floating point round-trips every bit.
+std::string literal(double value) {
+    if (std::isnan(value)) {
+        return "std::numeric_limits<double>::quiet_NaN()";
+    }
+    if (std::isinf(value)) {
+        return value > 0 ? "std::numeric_limits<double>::infinity()" : "(-std::numeric_limits<double>::infinity())";
+    }
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%a", value);
+    return std::signbit(value) ? "(" + std::string(buffer) + ")" : std::string(buffer);
+}
+
+std::string quoted(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\%03o", static_cast<unsigned char>(c));
+            out += escape;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+// Straight-line code for the outputs of one emitted function. Structurally equal
+// subexpressions map to one temporary, across all outputs.
+class FunctionBody {
+public:
+    FunctionBody(const std::vector<std::string>& variables, std::map<std::string, int>& userFunctions)
+        : userFunctions(userFunctions) {
+        for (std::size_t i = 0; i < variables.size(); ++i) {
+            if (!slotOf.emplace(variables[i], i).second) {
+                throw std::runtime_error("Variable " + variables[i] + " is listed twice.");
+            }
+        }
+    }
+
+    bool usesPowerHelper() const { return callsPower; }
+
+    // C++ expression for the node's value: a literal, vars[i] or a temporary.
+    std::string operand(const Node* node) {
+        auto it = values.find(node);
+        if (it != values.end()) {
+            return it->second;
+        }
+        std::string value = compute(node);
+        values.emplace(node, value);
+        return value;
+    }
+
+    std::string code;
+
+private:
+    std::string compute(const Node* node) {
+        NodeShape shape = shapeOf(node);
+        if (shape.op == OpCode::PushConst) {
+            return constant(shape.value);
+        }
+        if (shape.op == OpCode::LoadVar) {
+            auto slot = slotOf.find(shape.variable->getName());
+            if (slot == slotOf.end()) {
+                throw std::runtime_error("Variable " + shape.variable->getName() + " is not a parameter of the formula.");
+            }
+            return "vars[" + std::to_string(slot->second) + "]";
+        }
+        if (isConstant(node)) {
+            try {
+                CompileOptions options;
+                options.eliminateCommonSubexpressions = false;
+                return constant(CompiledExpr(node, options).evaluate(static_cast<const double*>(nullptr)));
+            } catch (const std::runtime_error&) {
+                // Invalid math: emit the operations so the error is raised at run time
+            }
+        }
+
+        std::vector<std::string> args;
+        for (std::size_t i = 0; i < shape.arity; ++i) {
+            args.push_back(operand(shape.operand(i)));
+        }
+        switch (shape.op) {
+        case OpCode::Add:
+            return temporary(args[0] + " + " + args[1]);
+        case OpCode::Sub:
+            return temporary(args[0] + " - " + args[1]);
+        case OpCode::Mul:
+            return temporary(args[0] + " * " + args[1]);
+        case OpCode::Div:
+            checkAny({{args[1], Test::Zero}}, "Division by zero error in " + node->toString());
+            return temporary(args[0] + " / " + args[1]);
+        case OpCode::Pow:
+            checkAll({{args[0], Test::Zero}, {args[1], Test::AtMostZero}},
+                     "Math error: 0 raised to a non-positive exponent.");
+            if (literals.count(args[0]) || literals.count(args[1])) {
+                callsPower = true;  // See kPowerHelper
+                return temporary("power(" + args[0] + ", " + args[1] + ")");
+            }
+            return temporary("std::pow(" + args[0] + ", " + args[1] + ")");
+        case OpCode::Sin:
+            return temporary("std::sin(" + args[0] + ")");
+        case OpCode::Cos:
+            return temporary("std::cos(" + args[0] + ")");
+        case OpCode::Ln:
+            checkAny({{args[0], Test::AtMostZero}}, "Math error: ln of non-positive number.");
+            return temporary("std::log(" + args[0] + ")");
+        case OpCode::Log:
+            checkAny({{args[0], Test::AtMostZero}, {args[0], Test::One}, {args[1], Test::AtMostZero}},
+                     "Math error: log with invalid base or operand.");
+            return temporary(logarithm(args[1]) + " / " + logarithm(args[0]));
+        case OpCode::Eq:
+            return temporary("std::fabs(" + args[0] + " - " + args[1] + ") < 1e-9 ? 1.0 : 0.0");
+        case OpCode::Call:
+            return call(shape.function, args);
+        default:
+            throw std::runtime_error("Cannot emit C++ for " + node->toString());
+        }
+    }
+
+    std::string call(const FunctionNode* function, const std::vector<std::string>& args) {
+        const std::string& name = function->getName();
+        if (!isIdentifier(name)) {
+            throw std::runtime_error("Function name " + name + " is not a C++ identifier.");
+        }
+        auto [known, inserted] = userFunctions.emplace(name, function->getExpectedArgCount());
+        if (!inserted && known->second != function->getExpectedArgCount()) {
+            throw std::runtime_error("Function " + name + " is called with different argument counts.");
+        }
+        std::string array = "a" + std::to_string(tempCount);
+        code += "    const double " + array + "[] = {";
+        for (std::size_t i = 0; i < args.size(); ++i) {
+            code += (i > 0 ? ", " : "") + args[i];
+        }
+        code += args.empty() ? "0};\n" : "};\n";
+        return temporary(name + "(" + array + ")");
+    }
+
+    std::string temporary(const std::string& expression) {
+        std::string name = "t" + std::to_string(tempCount++);
+        code += "    const double " + name + " = " + expression + ";\n";
+        return name;
+    }
+
+    // The log of a literal (usually a log base) is taken here, with the libm Node::evaluate
+    // uses, rather than left for the compiler to fold with its own arithmetic.
+    std::string logarithm(const std::string& operand) {
+        auto it = literals.find(operand);
+        return it == literals.end() ? "std::log(" + operand + ")" : constant(std::log(it->second));
+    }
+
+    std::string constant(double value) {
+        std::string text = literal(value);
+        literals.emplace(text, value);
+        return text;
+    }
+
+    // **Error checks**
+    // A test on a literal operand is decided here: a check that can never fail is left
+    // out, one that always fails is emitted as `if (true)` so it still throws at run time.
+    enum class Test { Zero, AtMostZero, One };
+
+    bool decide(const std::string& operand, Test test, bool& holds) const {
+        auto it = literals.find(operand);
+        if (it == literals.end()) {
+            return false;
+        }
+        double value = it->second;
+        holds = test == Test::Zero ? value == 0 : test == Test::AtMostZero ? value <= 0 : value == 1;
+        return true;
+    }
+
+    static std::string text(const std::string& operand, Test test) {
+        return operand + (test == Test::Zero ? " == 0" : test == Test::AtMostZero ? " <= 0" : " == 1");
+    }
+
+    // Throw if any of the tests holds.
+    void checkAny(const std::vector<std::pair<std::string, Test>>& tests, const std::string& message) {
+        std::string condition;
+        for (const auto& [operand, test] : tests) {
+            bool holds;
+            if (decide(operand, test, holds)) {
+                if (holds) {
+                    condition = "true";
+                    break;
+                }
+                continue;
+            }
+            condition += (condition.empty() ? "" : " || ") + text(operand, test);
+        }
+        if (!condition.empty()) {
+            check(condition, message);
+        }
+    }
+
+    // Throw if all of the tests hold.
+    void checkAll(const std::vector<std::pair<std::string, Test>>& tests, const std::string& message) {
+        std::string condition;
+        for (const auto& [operand, test] : tests) {
+            bool holds;
+            if (decide(operand, test, holds)) {
+                if (!holds) {
+                    return;
+                }
+                continue;
+            }
+            condition += (condition.empty() ? "" : " && ") + text(operand, test);
+        }
+        check(condition.empty() ? "true" : condition, message);
+    }
+
+    void check(const std::string& condition, const std::string& message) {
+        code += "    if (" + condition + ") {\n";
+        code += "        throw std::runtime_error(" + quoted(message) + ");\n";
+        code += "    }\n";
+    }
+
+    // No variables and no user functions below the node.
+    bool isConstant(const Node* node) {
+        auto it = constants.find(node);
+        if (it != constants.end()) {
+            return it->second;
+        }
+        NodeShape shape = shapeOf(node);
+        bool result = shape.op != OpCode::LoadVar && shape.op != OpCode::Call;
+        for (std::size_t i = 0; result && i < shape.arity; ++i) {
+            result = isConstant(shape.operand(i));
+        }
+        constants.emplace(node, result);
+        return result;
+    }
+
+    std::map<std::string, int>& userFunctions;
+    std::unordered_map<std::string, std::size_t> slotOf;
+    std::unordered_map<const Node*, std::string, NodeHash, NodeEqual> values;
+    std::unordered_map<const Node*, bool> constants;
+    std::unordered_map<std::string, double> literals;  // Literal text -> value
+    bool callsPower = false;
+    std::size_t tempCount = 0;
+};
+
+std::string parameterList(const std::vector<std::string>& variables) {
+    std::string list;
+    for (std::size_t i = 0; i < variables.size(); ++i) {
+        list += (i > 0 ? ", " : "") + variables[i];
+    }
+    return list;
+}
+
+} // namespace
+
+CppEmitter::CppEmitter(std::string nameSpace) : nameSpace(std::move(nameSpace)) {}
+
+void CppEmitter::addFormula(const std::string& name, const Node* root, const std::vector<std::string>& variables) {
+    emit(name, name + "(" + parameterList(variables) + ") = " + root->toString(), {root}, variables, true);
+}
+
+void CppEmitter::addDerivative(const std::string& name, const Node* root, const std::string& variable,
+                               const std::vector<std::string>& variables, ExprArena& arena) {
+    emit(name, "d/d" + variable + " of " + root->toString() + ", vars = {" + parameterList(variables) + "}",
+         {differentiate(root, variable, arena)}, variables, true);
+}
+
+void CppEmitter::addGradient(const std::string& name, const Node* root, const std::vector<std::string>& variables,
+                             ExprArena& arena) {
+    std::vector<const Node*> partials;
+    for (const std::string& variable : variables) {
+        partials.push_back(differentiate(root, variable, arena));
+    }
+    emit(name, "gradient of " + root->toString() + " with respect to {" + parameterList(variables) + "}", partials,
+         variables, false);
+}
+
+// A call to f differentiates into calls to its partials f_d<i>, emitted as user functions.
+Node* CppEmitter::differentiate(const Node* root, const std::string& variable, ExprArena& arena) const {
+    return root->derivative(variable, arena)->simplify(arena);
+}
+
+void CppEmitter::emit(const std::string& name, const std::string& comment, const std::vector<const Node*>& outputs,
+                      const std::vector<std::string>& variables, bool returnsValue) {
+    if (!isIdentifier(name)) {
+        throw std::runtime_error("Formula name " + name + " is not a C++ identifier.");
+    }
+    if (!names.insert(name).second) {
+        throw std::runtime_error("Formula " + name + " is defined twice.");
+    }
+    std::map<std::string, int> functions = userFunctions;  // Kept only if the formula is emitted
+    FunctionBody body(variables, functions);
+    std::vector<std::string> results;
+    try {
+        for (const Node* output : outputs) {
+            results.push_back(body.operand(output));
+        }
+    } catch (...) {
+        names.erase(name);
+        throw;
+    }
+    userFunctions = std::move(functions);
+    usesPower = usesPower || body.usesPowerHelper();
+
+    auto signature = [&](const std::string& vars) {
+        return returnsValue ? "double " + name + "(" + vars + ")" : "void " + name + "(" + vars + ", double* gradient)";
+    };
+    declarations += "// " + comment + "\n" + signature("const double* vars") + ";\n\n";
+    definitions += signature("[[maybe_unused]] const double* vars") + " {\n" + body.code;
+    if (returnsValue) {
+        definitions += "    return " + results[0] + ";\n";
+    } else {
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            definitions += "    gradient[" + std::to_string(i) + "] = " + results[i] + ";\n";
+        }
+    }
+    definitions += "}\n\n";
+    ++formulaCount;
+}
+
+std::size_t CppEmitter::getFormulaCount() const {
+    return formulaCount;
+}
+
+// **Output**
+void CppEmitter::writeHeader(std::ostream& out, const std::string& includeGuard) const {
+    out << "// Generated by CppEmitter. Do not edit.\n"
+        << "#ifndef " << includeGuard << "\n"
+        << "#define " << includeGuard << "\n\n"
+        << "namespace " << nameSpace << " {\n\n";
+    if (!userFunctions.empty()) {
+        out << "// User functions the formulas call; define them in the program. args holds the arguments.\n";
+        for (const auto& [function, argCount] : userFunctions) {
+            out << "double " << function << "(const double* args);  // " << argCount
+                << (argCount == 1 ? " argument\n" : " arguments\n");
+        }
+        out << "\n";
+    }
+    out << declarations << "} // namespace " << nameSpace << "\n\n#endif\n";
+}
+
+void CppEmitter::writeSource(std::ostream& out, const std::string& includePath) const {
+    out << "// Generated by CppEmitter. Do not edit.\n"
+        << "#include \"" << includePath << "\"\n\n"
+        << "#include <cmath>\n"
+        << "#include <limits>\n"
+        << "#include <stdexcept>\n\n"
+        << "namespace " << nameSpace << " {\n\n"
+        << (usesPower ? kPowerHelper : "") << definitions << "} // namespace " << nameSpace << "\n";
+}
+
+} // namespace Expression
@@ -0,0 +1,102 @@
+#include "compiler/cse_pass.h"
+#include "expression/variable_node.h"
+
+namespace Expression {
+
+std::size_t CsePass::ValueKeyHash::operator()(const ValueKey& key) const {
+    std::size_t h = std::hash<std::uint64_t>()(key.payload);
+    h ^= static_cast<std::size_t>(key.op) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    h ^= std::hash<std::uint32_t>()(key.operands[0]) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    h ^= std::hash<std::uint32_t>()(key.operands[1]) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h;
+}
+
+CsePass::CsePass(const Node* root) {
+    std::uint32_t rootValue = number(root);
+    values[rootValue].uses += 1;
+    treeNodeCount = treeSize(root);
+}
+
+// **Value numbering (each distinct node pointer is visited once)**
+std::uint32_t CsePass::number(const Node* node) {
+    auto known = numbers.find(node);
+    if (known != numbers.end()) {
+        return known->second;
+    }
+
+    NodeShape shape = shapeOf(node);
+    std::vector<std::uint32_t> operandValues(shape.arity);
+    for (std::size_t i = 0; i < shape.arity; ++i) {
+        operandValues[i] = number(shape.operand(i));
+    }
+
+    std::uint32_t value;
+    bool isNew = true;
+    if (shape.op == OpCode::Call) {
+        // Callbacks cannot be compared, so every call is its own value.
+        value = static_cast<std::uint32_t>(values.size());
+        values.push_back({});
+    } else {
+        ValueKey key{shape.op, 0, {UINT32_MAX, UINT32_MAX}};
+        if (shape.op == OpCode::PushConst) {
+            std::memcpy(&key.payload, &shape.value, sizeof(key.payload));
+        } else if (shape.op == OpCode::LoadVar) {
+            key.payload = shape.variable->getSlot();
+        }
+        for (std::size_t i = 0; i < shape.arity; ++i) {
+            key.operands[i] = operandValues[i];
+        }
+        auto inserted = keys.emplace(key, static_cast<std::uint32_t>(values.size()));
+        value = inserted.first->second;
+        isNew = inserted.second;
+        if (isNew) {
+            values.push_back({0, shape.arity > 0});
+        }
+    }
+
+    // Count each use of an operand once per distinct parent value.
+    if (isNew) {
+        for (std::uint32_t operandValue : operandValues) {
+            values[operandValue].uses += 1;
+        }
+    }
+    numbers.emplace(node, value);
+    return value;
+}
+
+std::uint64_t CsePass::treeSize(const Node* node) {
+    auto known = treeSizes.find(node);
+    if (known != treeSizes.end()) {
+        return known->second;
+    }
+    NodeShape shape = shapeOf(node);
+    std::uint64_t size = 1;
+    for (std::size_t i = 0; i < shape.arity; ++i) {
+        std::uint64_t operandSize = treeSize(shape.operand(i));
+        size = operandSize > UINT64_MAX - size ? UINT64_MAX : size + operandSize;
+    }
+    treeSizes.emplace(node, size);
+    return size;
+}
+
+std::uint32_t CsePass::valueNumber(const Node* node) const {
+    auto it = numbers.find(node);
+    if (it == numbers.end()) {
+        throw std::runtime_error("Node is not part of the analyzed expression.");
+    }
+    return it->second;
+}
+
+bool CsePass::isShared(std::uint32_t value) const {
+    return values[value].shareable && values[value].uses > 1;
+}
+
+std::size_t CsePass::getUniqueCount() const {
+    return values.size();
+}
+
+std::uint64_t CsePass::getTreeNodeCount() const {
+    return treeNodeCount;
+}
+
+} // namespace Expression
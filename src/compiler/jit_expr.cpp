@@ -0,0 +1,699 @@
+#include "compiler/jit_expr.h"
+
+#if defined(__x86_64__) && defined(__unix__)
+#define EXPR_JIT_X86_64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define EXPR_JIT_X86_64 0
+#endif
+
+namespace Expression {
+
+namespace {
+
+// Variable arrays up to this size live on the C++ stack; larger ones use the heap.
+constexpr std::size_t kInlineBufferSize = 64;
+
+// Errors come back as a quiet NaN carrying this tag in its high half and an error code
+// in its low half. The default NaN of invalid arithmetic never has the tag.
+constexpr std::uint64_t kErrorTag = 0x7ffce70000000000ULL;
+constexpr std::uint64_t kErrorTagMask = 0xffffffff00000000ULL;
+
+enum ErrorCode : std::uint32_t {
+    kPowError = 0,
+    kLnError = 1,
+    kLogError = 2,
+    kCallbackError = 3,
+    kFirstDivisionError = 4  // + index into CompiledExpr::getErrorMessages()
+};
+
+// Set by callFunction when a callback throws; evaluate() rethrows it on the same thread.
+thread_local std::exception_ptr callbackError;
+
+#if EXPR_JIT_X86_64
+
+// Called from generated code. Exceptions must not unwind through frames without unwind
+// information, so they are caught here and reported through the return value.
+int callFunction(const CompiledFunction* function, const double* args, double* result) noexcept {
+    try {
+        *result = function->callback(std::vector<double>(args, args + function->argCount));
+        return 0;
+    } catch (...) {
+        callbackError = std::current_exception();
+        return 1;
+    }
+}
+
+double callSin(double x) {
+    return std::sin(x);
+}
+
+double callCos(double x) {
+    return std::cos(x);
+}
+
+double callLog(double x) {
+    return std::log(x);
+}
+
+double callPow(double x, double y) {
+    return std::pow(x, y);
+}
+
+// **Assembler**
+// Just enough x86-64 encoding for scalar SSE2 arithmetic on [rbp + disp32], [rbx + disp32]
+// and RIP-relative constants, plus jumps and absolute calls.
+constexpr int kRbx = 3;
+constexpr int kRbp = 5;
+
+constexpr std::uint8_t kPrefixDouble = 0xF2;  // movsd and scalar arithmetic
+constexpr std::uint8_t kPrefixPacked = 0x66;  // movapd, andpd, ucomisd
+constexpr std::uint8_t kMovLoad = 0x10;
+constexpr std::uint8_t kMovStore = 0x11;
+constexpr std::uint8_t kMovapd = 0x28;
+constexpr std::uint8_t kUcomisd = 0x2E;
+constexpr std::uint8_t kAndpd = 0x54;
+constexpr std::uint8_t kAdd = 0x58;
+constexpr std::uint8_t kMul = 0x59;
+constexpr std::uint8_t kSub = 0x5C;
+constexpr std::uint8_t kDiv = 0x5E;
+
+// Condition codes (low nibble of Jcc).
+constexpr std::uint8_t kEqual = 0x4;
+constexpr std::uint8_t kNotEqual = 0x5;
+constexpr std::uint8_t kBelowOrEqual = 0x6;
+constexpr std::uint8_t kParity = 0xA;
+
+class Assembler {
+public:
+    std::vector<std::uint8_t> bytes;
+
+    void byte(std::uint8_t b) {
+        bytes.push_back(b);
+    }
+
+    void u32(std::uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            byte(static_cast<std::uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    void u64(std::uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            byte(static_cast<std::uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    void patch32(std::size_t at, std::uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            bytes[at + i] = static_cast<std::uint8_t>(value >> (8 * i));
+        }
+    }
+
+    // op xmm, xmm
+    void sse(std::uint8_t prefix, std::uint8_t op, int dst, int src) {
+        byte(prefix);
+        std::uint8_t rex = 0x40 | (dst >= 8 ? 4 : 0) | (src >= 8 ? 1 : 0);
+        if (rex != 0x40) {
+            byte(rex);
+        }
+        byte(0x0F);
+        byte(op);
+        byte(static_cast<std::uint8_t>(0xC0 | ((dst & 7) << 3) | (src & 7)));
+    }
+
+    // op xmm, [base + disp32] (for kMovStore, the memory operand is the destination)
+    void sseMem(std::uint8_t prefix, std::uint8_t op, int xmm, int base, std::int32_t disp) {
+        byte(prefix);
+        if (xmm >= 8) {
+            byte(0x44);
+        }
+        byte(0x0F);
+        byte(op);
+        byte(static_cast<std::uint8_t>(0x80 | ((xmm & 7) << 3) | base));
+        u32(static_cast<std::uint32_t>(disp));
+    }
+
+    // op xmm, [rip + disp32]; returns where disp32 goes, to be patched once constants are placed.
+    std::size_t sseRip(std::uint8_t prefix, std::uint8_t op, int xmm) {
+        byte(prefix);
+        if (xmm >= 8) {
+            byte(0x44);
+        }
+        byte(0x0F);
+        byte(op);
+        byte(static_cast<std::uint8_t>(0x05 | ((xmm & 7) << 3)));
+        std::size_t at = bytes.size();
+        u32(0);
+        return at;
+    }
+
+    // Jcc rel32; returns where rel32 goes.
+    std::size_t jumpFar(std::uint8_t condition) {
+        byte(0x0F);
+        byte(0x80 | condition);
+        std::size_t at = bytes.size();
+        u32(0);
+        return at;
+    }
+
+    // Jcc rel8 forward; bind the returned position where the jump should land.
+    std::size_t jumpShort(std::uint8_t condition) {
+        byte(0x70 | condition);
+        byte(0);
+        return bytes.size();
+    }
+
+    void bindShort(std::size_t from) {
+        bytes[from - 1] = static_cast<std::uint8_t>(bytes.size() - from);
+    }
+
+    void bindFar(std::size_t at, std::size_t target) {
+        patch32(at, static_cast<std::uint32_t>(static_cast<std::int64_t>(target) - static_cast<std::int64_t>(at + 4)));
+    }
+
+    // mov reg, imm64 for rax (0), rdx (2), rsi (6), rdi (7)
+    void moveImmediate(int reg, std::uint64_t value) {
+        byte(0x48);
+        byte(static_cast<std::uint8_t>(0xB8 + reg));
+        u64(value);
+    }
+
+    // lea reg, [rbp + disp32]
+    void leaFrame(int reg, std::int32_t disp) {
+        byte(0x48);
+        byte(0x8D);
+        byte(static_cast<std::uint8_t>(0x80 | (reg << 3) | kRbp));
+        u32(static_cast<std::uint32_t>(disp));
+    }
+
+    void call(const void* target) {
+        moveImmediate(0, reinterpret_cast<std::uint64_t>(target));
+        byte(0xFF);  // call rax
+        byte(0xD0);
+    }
+};
+
+// **Code generation**
+// The CompiledExpr program is a stack machine whose depth at every instruction is known,
+// so each stack entry gets a fixed home: xmm2..xmm15 for the first 14 entries, a frame
+// slot for deeper ones. Register entries also have a frame slot, used to keep them
+// across calls (every xmm register is caller-saved). xmm0 and xmm1 are scratch.
+constexpr int kRegisterEntries = 14;
+constexpr int kScratch0 = 0;
+constexpr int kScratch1 = 1;
+
+class CodeGenerator {
+public:
+    explicit CodeGenerator(const CompiledExpr& program) : program(program) {
+        std::size_t maxArgs = 0;
+        for (const CompiledFunction& function : program.getFunctions()) {
+            maxArgs = std::max(maxArgs, static_cast<std::size_t>(function.argCount));
+        }
+        // Frame below the saved rbx at [rbp - 8]: entry homes, temps, one scratch slot, call arguments.
+        tempBase = program.getMaxStackDepth();
+        scratchSlot = tempBase + program.getTempCount();
+        argBase = scratchSlot + 1;
+        std::size_t slots = argBase + maxArgs;
+        frameSize = 8 * slots + (slots % 2 == 0 ? 8 : 0);  // Keeps rsp 16-byte aligned at calls
+    }
+
+    std::vector<std::uint8_t> generate() {
+        prologue();
+        std::size_t depth = 0;
+        for (const Instruction& ins : program.getCode()) {
+            depth = instruction(ins, depth);
+        }
+        load(kScratch0, 0);
+        epilogue();
+        emitErrorStubs();
+        placeConstants();
+        return std::move(a.bytes);
+    }
+
+private:
+    // **Frame and entries**
+    static std::int32_t frameSlot(std::size_t index) {
+        return -16 - 8 * static_cast<std::int32_t>(index);
+    }
+
+    static bool inRegister(std::size_t entry) {
+        return entry < kRegisterEntries;
+    }
+
+    static int registerOf(std::size_t entry) {
+        return 2 + static_cast<int>(entry);
+    }
+
+    // Register holding the entry: its own, or scratch after loading it from the frame.
+    int fetch(std::size_t entry, int scratch) {
+        if (inRegister(entry)) {
+            return registerOf(entry);
+        }
+        a.sseMem(kPrefixDouble, kMovLoad, scratch, kRbp, frameSlot(entry));
+        return scratch;
+    }
+
+    void load(int xmm, std::size_t entry) {
+        if (inRegister(entry)) {
+            if (xmm != registerOf(entry)) {
+                a.sse(kPrefixPacked, kMovapd, xmm, registerOf(entry));
+            }
+        } else {
+            a.sseMem(kPrefixDouble, kMovLoad, xmm, kRbp, frameSlot(entry));
+        }
+    }
+
+    // Make xmm the value of the entry.
+    void store(std::size_t entry, int xmm) {
+        if (inRegister(entry)) {
+            if (xmm != registerOf(entry)) {
+                a.sse(kPrefixPacked, kMovapd, registerOf(entry), xmm);
+            }
+        } else {
+            a.sseMem(kPrefixDouble, kMovStore, xmm, kRbp, frameSlot(entry));
+        }
+    }
+
+    // Save entries [0, count) that live in registers before a call, and restore them after.
+    void spill(std::size_t count) {
+        for (std::size_t entry = 0; entry < count && inRegister(entry); ++entry) {
+            a.sseMem(kPrefixDouble, kMovStore, registerOf(entry), kRbp, frameSlot(entry));
+        }
+    }
+
+    void reload(std::size_t count) {
+        for (std::size_t entry = 0; entry < count && inRegister(entry); ++entry) {
+            a.sseMem(kPrefixDouble, kMovLoad, registerOf(entry), kRbp, frameSlot(entry));
+        }
+    }
+
+    // **Constants**
+    void constant(std::uint8_t prefix, std::uint8_t op, int xmm, double value) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        constantBits(prefix, op, xmm, bits);
+    }
+
+    void constantBits(std::uint8_t prefix, std::uint8_t op, int xmm, std::uint64_t bits) {
+        auto [it, inserted] = constantIndex.emplace(bits, constantPool.size());
+        if (inserted) {
+            constantPool.push_back(bits);
+        }
+        constantFixups.push_back({a.sseRip(prefix, op, xmm), it->second});
+    }
+
+    // **Errors**
+    void jumpToError(std::uint8_t condition, std::uint32_t code) {
+        errorFixups.push_back({a.jumpFar(condition), code});
+    }
+
+    // Jump to the error when xmm <= limit, but not when xmm is NaN (comparisons with NaN
+    // are false in Node::evaluate, so NaN never raises).
+    void errorIfAtMost(int xmm, double limit, std::uint32_t code) {
+        constant(kPrefixPacked, kUcomisd, xmm, limit);
+        std::size_t unordered = a.jumpShort(kParity);
+        jumpToError(kBelowOrEqual, code);
+        a.bindShort(unordered);
+    }
+
+    void errorIfEqual(int xmm, double value, std::uint32_t code) {
+        constant(kPrefixPacked, kUcomisd, xmm, value);
+        std::size_t unordered = a.jumpShort(kParity);
+        jumpToError(kEqual, code);
+        a.bindShort(unordered);
+    }
+
+    // **Instructions**
+    std::size_t instruction(const Instruction& ins, std::size_t depth) {
+        switch (ins.op) {
+        case OpCode::PushConst: {
+            int xmm = inRegister(depth) ? registerOf(depth) : kScratch0;
+            constant(kPrefixDouble, kMovLoad, xmm, program.getConstants()[ins.operand]);
+            store(depth, xmm);
+            return depth + 1;
+        }
+        case OpCode::LoadVar: {
+            int xmm = inRegister(depth) ? registerOf(depth) : kScratch0;
+            a.sseMem(kPrefixDouble, kMovLoad, xmm, kRbx, 8 * static_cast<std::int32_t>(ins.operand));
+            store(depth, xmm);
+            return depth + 1;
+        }
+        case OpCode::LoadTemp: {
+            int xmm = inRegister(depth) ? registerOf(depth) : kScratch0;
+            a.sseMem(kPrefixDouble, kMovLoad, xmm, kRbp, frameSlot(tempBase + ins.operand));
+            store(depth, xmm);
+            return depth + 1;
+        }
+        case OpCode::StoreTemp:
+            a.sseMem(kPrefixDouble, kMovStore, fetch(depth - 1, kScratch0), kRbp, frameSlot(tempBase + ins.operand));
+            return depth;
+        case OpCode::Add:
+            return arithmetic(kAdd, depth, nullptr);
+        case OpCode::Sub:
+            return arithmetic(kSub, depth, nullptr);
+        case OpCode::Mul:
+            return arithmetic(kMul, depth, nullptr);
+        case OpCode::Div:
+            return arithmetic(kDiv, depth, [&](int, int right) {
+                errorIfEqual(right, 0.0, kFirstDivisionError + ins.operand);
+            });
+        case OpCode::Eq:
+            return equality(depth);
+        case OpCode::Sin:
+            return unaryCall(reinterpret_cast<const void*>(&callSin), depth, nullptr);
+        case OpCode::Cos:
+            return unaryCall(reinterpret_cast<const void*>(&callCos), depth, nullptr);
+        case OpCode::Ln:
+            return unaryCall(reinterpret_cast<const void*>(&callLog), depth, [&](int operand) {
+                errorIfAtMost(operand, 0.0, kLnError);
+            });
+        case OpCode::Pow:
+            return power(depth);
+        case OpCode::Log:
+            return logarithm(depth);
+        case OpCode::Call:
+            return functionCall(ins.operand, depth);
+        }
+        return depth;
+    }
+
+    template <typename Check>
+    std::size_t arithmetic(std::uint8_t op, std::size_t depth, Check check) {
+        int left = fetch(depth - 2, kScratch0);
+        int right = fetch(depth - 1, kScratch1);
+        if constexpr (!std::is_same_v<Check, std::nullptr_t>) {
+            check(left, right);
+        }
+        a.sse(kPrefixDouble, op, left, right);
+        store(depth - 2, left);
+        return depth - 1;
+    }
+
+    // fabs(left - right) < 1e-9 ? 1 : 0
+    std::size_t equality(std::size_t depth) {
+        int left = fetch(depth - 2, kScratch0);
+        int right = fetch(depth - 1, kScratch1);
+        a.sse(kPrefixDouble, kSub, left, right);
+        constantBits(kPrefixDouble, kMovLoad, kScratch1, 0x7fffffffffffffffULL);
+        a.sse(kPrefixPacked, kAndpd, left, kScratch1);
+        constant(kPrefixDouble, kMovLoad, kScratch1, 1e-9);
+        a.sse(kPrefixPacked, kUcomisd, kScratch1, left);  // Above: 1e-9 > |difference|, never for NaN
+        constant(kPrefixDouble, kMovLoad, left, 0.0);
+        std::size_t notEqual = a.jumpShort(kBelowOrEqual);
+        constant(kPrefixDouble, kMovLoad, left, 1.0);
+        a.bindShort(notEqual);
+        store(depth - 2, left);
+        return depth - 1;
+    }
+
+    template <typename Check>
+    std::size_t unaryCall(const void* target, std::size_t depth, Check check) {
+        int operand = fetch(depth - 1, kScratch0);
+        if constexpr (!std::is_same_v<Check, std::nullptr_t>) {
+            check(operand);
+        }
+        spill(depth - 1);
+        load(kScratch0, depth - 1);
+        a.call(target);
+        reload(depth - 1);
+        store(depth - 1, kScratch0);
+        return depth;
+    }
+
+    std::size_t power(std::size_t depth) {
+        int base = fetch(depth - 2, kScratch0);
+        int exponent = fetch(depth - 1, kScratch1);
+        // 0 raised to a non-positive exponent
+        constant(kPrefixPacked, kUcomisd, base, 0.0);
+        std::size_t unordered = a.jumpShort(kParity);
+        std::size_t nonZero = a.jumpShort(kNotEqual);
+        errorIfAtMost(exponent, 0.0, kPowError);
+        a.bindShort(unordered);
+        a.bindShort(nonZero);
+
+        spill(depth - 2);
+        load(kScratch1, depth - 1);
+        load(kScratch0, depth - 2);
+        a.call(reinterpret_cast<const void*>(&callPow));
+        reload(depth - 2);
+        store(depth - 2, kScratch0);
+        return depth - 1;
+    }
+
+    // log(base, x) = ln(x) / ln(base), with base pushed first.
+    std::size_t logarithm(std::size_t depth) {
+        int base = fetch(depth - 2, kScratch0);
+        int operand = fetch(depth - 1, kScratch1);
+        errorIfAtMost(base, 0.0, kLogError);
+        errorIfEqual(base, 1.0, kLogError);
+        errorIfAtMost(operand, 0.0, kLogError);
+
+        spill(depth - 1);  // The base too: it has to survive the first call
+        load(kScratch0, depth - 1);
+        a.call(reinterpret_cast<const void*>(&callLog));
+        a.sseMem(kPrefixDouble, kMovStore, kScratch0, kRbp, frameSlot(scratchSlot));
+        a.sseMem(kPrefixDouble, kMovLoad, kScratch0, kRbp, frameSlot(depth - 2));
+        a.call(reinterpret_cast<const void*>(&callLog));
+        a.sse(kPrefixPacked, kMovapd, kScratch1, kScratch0);
+        a.sseMem(kPrefixDouble, kMovLoad, kScratch0, kRbp, frameSlot(scratchSlot));
+        a.sse(kPrefixDouble, kDiv, kScratch0, kScratch1);
+        reload(depth - 2);
+        store(depth - 2, kScratch0);
+        return depth - 1;
+    }
+
+    std::size_t functionCall(std::uint32_t index, std::size_t depth) {
+        const CompiledFunction& function = program.getFunctions()[index];
+        std::size_t argCount = static_cast<std::size_t>(function.argCount);
+        std::size_t first = depth - argCount;
+        // Arguments in ascending addresses: argument j in frame slot argBase + argCount - 1 - j.
+        for (std::size_t j = 0; j < argCount; ++j) {
+            a.sseMem(kPrefixDouble, kMovStore, fetch(first + j, kScratch0), kRbp,
+                     frameSlot(argBase + argCount - 1 - j));
+        }
+        spill(first);
+        a.moveImmediate(7, reinterpret_cast<std::uint64_t>(&function));  // rdi
+        a.leaFrame(6, frameSlot(argBase + (argCount > 0 ? argCount - 1 : 0)));  // rsi
+        a.leaFrame(2, frameSlot(scratchSlot));  // rdx
+        a.call(reinterpret_cast<const void*>(&callFunction));
+        a.byte(0x85);  // test eax, eax
+        a.byte(0xC0);
+        jumpToError(kNotEqual, kCallbackError);
+        reload(first);
+        a.sseMem(kPrefixDouble, kMovLoad, kScratch0, kRbp, frameSlot(scratchSlot));
+        store(first, kScratch0);
+        return first + 1;
+    }
+
+    // **Prologue, epilogue and out-of-line code**
+    void prologue() {
+        a.byte(0x55);  // push rbp
+        a.byte(0x48);  // mov rbp, rsp
+        a.byte(0x89);
+        a.byte(0xE5);
+        a.byte(0x53);  // push rbx
+        a.byte(0x48);  // sub rsp, frameSize
+        a.byte(0x81);
+        a.byte(0xEC);
+        a.u32(static_cast<std::uint32_t>(frameSize));
+        a.byte(0x48);  // mov rbx, rdi
+        a.byte(0x89);
+        a.byte(0xFB);
+    }
+
+    void epilogue() {
+        a.byte(0x48);  // mov rbx, [rbp - 8]
+        a.byte(0x8B);
+        a.byte(0x5D);
+        a.byte(0xF8);
+        a.byte(0xC9);  // leave
+        a.byte(0xC3);  // ret
+    }
+
+    // One stub per error code: load the tagged NaN and leave.
+    void emitErrorStubs() {
+        std::unordered_map<std::uint32_t, std::size_t> stubOf;
+        for (const Fixup& fixup : errorFixups) {
+            auto [it, inserted] = stubOf.emplace(fixup.value, a.bytes.size());
+            if (inserted) {
+                a.moveImmediate(0, kErrorTag | fixup.value);
+                a.byte(0x66);  // movq xmm0, rax
+                a.byte(0x48);
+                a.byte(0x0F);
+                a.byte(0x6E);
+                a.byte(0xC0);
+                epilogue();
+            }
+            a.bindFar(fixup.at, it->second);
+        }
+    }
+
+    void placeConstants() {
+        while (a.bytes.size() % 8 != 0) {
+            a.byte(0xCC);  // int3
+        }
+        std::size_t poolStart = a.bytes.size();
+        for (std::uint64_t bits : constantPool) {
+            a.u64(bits);
+        }
+        for (const Fixup& fixup : constantFixups) {
+            a.bindFar(fixup.at, poolStart + 8 * fixup.value);
+        }
+    }
+
+    struct Fixup {
+        std::size_t at;
+        std::size_t value;  // Error code or constant index
+    };
+
+    const CompiledExpr& program;
+    Assembler a;
+    std::size_t tempBase;
+    std::size_t scratchSlot;
+    std::size_t argBase;
+    std::size_t frameSize;
+    std::vector<std::uint64_t> constantPool;
+    std::unordered_map<std::uint64_t, std::size_t> constantIndex;
+    std::vector<Fixup> constantFixups;
+    std::vector<Fixup> errorFixups;
+};
+
+#endif
+
+} // namespace
+
+JitExpr::JitExpr(const Node* root, CompileOptions options) : program(root, options) {
+#if EXPR_JIT_X86_64
+    std::vector<std::uint8_t> bytes = CodeGenerator(program).generate();
+    std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    std::size_t size = (bytes.size() + page - 1) / page * page;
+    void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return;  // Interpret instead
+    }
+    std::memcpy(memory, bytes.data(), bytes.size());
+    if (::mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        ::munmap(memory, size);
+        return;
+    }
+    code = memory;
+    mappedSize = size;
+    codeSize = bytes.size();
+    function = reinterpret_cast<Function>(memory);
+#endif
+}
+
+JitExpr::~JitExpr() {
+    release();
+}
+
+JitExpr::JitExpr(JitExpr&& other) noexcept
+    : program(std::move(other.program)), code(other.code), mappedSize(other.mappedSize), codeSize(other.codeSize),
+      function(other.function) {
+    other.code = nullptr;
+    other.function = nullptr;
+}
+
+JitExpr& JitExpr::operator=(JitExpr&& other) noexcept {
+    if (this != &other) {
+        release();
+        program = std::move(other.program);
+        code = other.code;
+        mappedSize = other.mappedSize;
+        codeSize = other.codeSize;
+        function = other.function;
+        other.code = nullptr;
+        other.function = nullptr;
+    }
+    return *this;
+}
+
+void JitExpr::release() {
+#if EXPR_JIT_X86_64
+    if (code) {
+        ::munmap(code, mappedSize);
+    }
+#endif
+    code = nullptr;
+    function = nullptr;
+}
+
+bool JitExpr::isSupported() {
+    return EXPR_JIT_X86_64;
+}
+
+bool JitExpr::isNative() const {
+    return function != nullptr;
+}
+
+JitExpr::Function JitExpr::getFunction() const {
+    return function;
+}
+
+// **Evaluation**
+double JitExpr::evaluate(const double* slots) const {
+    if (!function) {
+        return program.evaluate(slots);
+    }
+    double result = function(slots);
+    return result == result ? result : checkResult(result);
+}
+
+double JitExpr::evaluate(const Env& env) const {
+    if (!function) {
+        return program.evaluate(env);
+    }
+    double inlineSlots[kInlineBufferSize];
+    std::vector<double> heapSlots;
+    double* slots = inlineSlots;
+    if (program.getSlotCount() > kInlineBufferSize) {
+        heapSlots.resize(program.getSlotCount());
+        slots = heapSlots.data();
+    }
+    for (const CompiledVariable& variable : program.getVariables()) {
+        auto it = env.find(variable.name);
+        slots[variable.slot] = it != env.end() ? it->second : 0.0;
+    }
+    return evaluate(slots);
+}
+
+double JitExpr::checkResult(double result) const {
+    std::uint64_t bits;
+    std::memcpy(&bits, &result, sizeof(bits));
+    if ((bits & kErrorTagMask) != kErrorTag) {
+        return result;
+    }
+    std::uint32_t code = static_cast<std::uint32_t>(bits);
+    switch (code) {
+    case kPowError:
+        throw std::runtime_error("Math error: 0 raised to a non-positive exponent.");
+    case kLnError:
+        throw std::runtime_error("Math error: ln of non-positive number.");
+    case kLogError:
+        throw std::runtime_error("Math error: log with invalid base or operand.");
+    case kCallbackError:
+        if (callbackError) {
+            std::exception_ptr error = callbackError;
+            callbackError = nullptr;
+            std::rethrow_exception(error);
+        }
+        return result;
+    default:
+        if (code - kFirstDivisionError < program.getErrorMessages().size()) {
+            throw std::runtime_error(program.getErrorMessages()[code - kFirstDivisionError]);
+        }
+        return result;  // A NaN input that happened to carry the tag
+    }
+}
+
+const CompiledExpr& JitExpr::getProgram() const {
+    return program;
+}
+
+std::size_t JitExpr::getCodeSize() const {
+    return codeSize;
+}
+
+} // namespace Expression
@@ -0,0 +1,86 @@
+#include "compiler/node_shape.h"
+#include "expression/number_node.h"
+#include "expression/variable_node.h"
+#include "expression/addition_node.h"
+#include "expression/subtraction_node.h"
+#include "expression/multiplication_node.h"
+#include "expression/division_node.h"
+#include "expression/exponentiation_node.h"
+#include "expression/sin_node.h"
+#include "expression/cos_node.h"
+#include "expression/ln_node.h"
+#include "expression/log_node.h"
+#include "expression/equality_node.h"
+
+namespace Expression {
+
+const Node* NodeShape::operand(std::size_t i) const {
+    return function ? function->getArguments()[i] : operands[i];
+}
+
+NodeShape shapeOf(const Node* node) {
+    NodeShape shape;
+    auto binary = [&shape](OpCode op, const Node* left, const Node* right) {
+        shape.op = op;
+        shape.arity = 2;
+        shape.operands[0] = left;
+        shape.operands[1] = right;
+    };
+    auto unary = [&shape](OpCode op, const Node* operand) {
+        shape.op = op;
+        shape.arity = 1;
+        shape.operands[0] = operand;
+    };
+
+    switch (node->getKind()) {
+    case NodeKind::Number:
+        shape.op = OpCode::PushConst;
+        shape.value = static_cast<const NumberNode*>(node)->getValue();
+        break;
+    case NodeKind::Variable:
+        shape.op = OpCode::LoadVar;
+        shape.variable = static_cast<const VariableNode*>(node);
+        break;
+    case NodeKind::Addition:
+    case NodeKind::Subtraction:
+    case NodeKind::Multiplication:
+    case NodeKind::Division:
+    case NodeKind::Exponentiation:
+    case NodeKind::Log: {
+        static constexpr OpCode kBinaryOps[] = {OpCode::Add, OpCode::Sub, OpCode::Mul,
+                                                OpCode::Div, OpCode::Pow};
+        auto binaryNode = static_cast<const BinaryOpNode*>(node);
+        OpCode op = node->getKind() == NodeKind::Log
+            ? OpCode::Log
+            : kBinaryOps[static_cast<std::size_t>(node->getKind()) - static_cast<std::size_t>(NodeKind::Addition)];
+        binary(op, binaryNode->getLeft(), binaryNode->getRight());
+        break;
+    }
+    case NodeKind::Equality: {
+        auto eqNode = static_cast<const EqualityNode*>(node);
+        binary(OpCode::Eq, eqNode->getLeft(), eqNode->getRight());
+        break;
+    }
+    case NodeKind::Sin:
+        unary(OpCode::Sin, static_cast<const UnaryOpNode*>(node)->getOperand());
+        break;
+    case NodeKind::Cos:
+        unary(OpCode::Cos, static_cast<const UnaryOpNode*>(node)->getOperand());
+        break;
+    case NodeKind::Ln:
+        unary(OpCode::Ln, static_cast<const UnaryOpNode*>(node)->getOperand());
+        break;
+    case NodeKind::Function: {
+        auto funcNode = static_cast<const FunctionNode*>(node);
+        shape.op = OpCode::Call;
+        shape.function = funcNode;
+        shape.arity = funcNode->getArguments().size();
+        break;
+    }
+    default:
+        throw std::runtime_error("Cannot compile unsupported node: " + node->toString());
+    }
+    return shape;
+}
+
+} // namespace Expression
@@ -1,81 +1,106 @@
 #include "expression/addition_node.h"
+#include "helpers/expr_helper.h"
 #include "expression/number_node.h"
 #include "tracing/trace.h"
 
 namespace Expression {
 
 AdditionNode::AdditionNode(Node* left, Node* right)
-    : BinaryOpNode(left, right) {}
+    : BinaryOpNode(NodeKind::Addition, left, right) {}
 
 AdditionNode::~AdditionNode() {}
 
-double AdditionNode::evaluate(const Env &env) {
-    double leftVal = left->evaluate(env);
-    double rightVal = right->evaluate(env);
+double AdditionNode::evaluate(const double* slots) {
+    double leftVal = left->evaluate(slots);
+    double rightVal = right->evaluate(slots);
     double result = leftVal + rightVal;
-    Trace::addTransformation("Evaluating AdditionNode", toString(), std::to_string(result));
+    if (Trace::enabled(TraceLevel::Full)) {
+        Trace::addTransformation("Evaluating AdditionNode", toString(), std::to_string(result));
+    }
     return result;
 }
 
-std::string AdditionNode::toString() const {
-    return "(" + left->toString() + " + " + right->toString() + ")";
+void AdditionNode::evaluateBatch(const BatchBlock& block, double* out, BatchScratch& scratch) {
+    double* rhs = scratch.acquire();
+    left->evaluateBatch(block, out, scratch);
+    right->evaluateBatch(block, rhs, scratch);
+    for (std::size_t i = 0; i < block.count; ++i) {
+        out[i] = out[i] + rhs[i];
+    }
+    scratch.release();
 }
 
 // **Symbolic Simplification**
-Node* AdditionNode::simplify() const {
-    Node* leftSimplified = left->simplify();
-    Node* rightSimplified = right->simplify();
+Node* AdditionNode::simplifyImpl(ExprArena& arena) const {
+    ExprHelper e(arena);
+    Node* leftSimplified = left->simplify(arena);
+    Node* rightSimplified = right->simplify(arena);
 
-    std::string before = toString();
+    const bool tracing = Trace::enabled(TraceLevel::Summary);
 
     // If both sides are numbers, perform constant folding.
-    if (auto leftNum = dynamic_cast<NumberNode*>(leftSimplified)) {
-        if (auto rightNum = dynamic_cast<NumberNode*>(rightSimplified)) {
-            Node* simplified = new NumberNode(leftNum->getValue() + rightNum->getValue());
-            Trace::addTransformation("Constant folding in AdditionNode", before, simplified->toString());
+    if (auto leftNum = leftSimplified->as<NumberNode>()) {
+        if (auto rightNum = rightSimplified->as<NumberNode>()) {
+            Node* simplified = e.num(leftNum->getValue() + rightNum->getValue());
+            if (tracing) {
+                Trace::addTransformation("Constant folding in AdditionNode", this, simplified);
+            }
             return simplified;
         }
     }
 
     // Identity rule: x + 0 = x
-    if (auto rightNum = dynamic_cast<NumberNode*>(rightSimplified)) {
+    if (auto rightNum = rightSimplified->as<NumberNode>()) {
         if (rightNum->getValue() == 0) {
-            Trace::addTransformation("Simplify AdditionNode", before, leftSimplified->toString());
+            if (tracing) {
+                Trace::addTransformation("Simplify AdditionNode", this, leftSimplified);
+            }
             return leftSimplified;
         }
     }
 
-    if (auto leftNum = dynamic_cast<NumberNode*>(leftSimplified)) {
+    if (auto leftNum = leftSimplified->as<NumberNode>()) {
         if (leftNum->getValue() == 0) {
-            Trace::addTransformation("Simplify AdditionNode", before, rightSimplified->toString());
+            if (tracing) {
+                Trace::addTransformation("Simplify AdditionNode", this, rightSimplified);
+            }
             return rightSimplified;
         }
     }
 
-    Node* simplified = new AdditionNode(leftSimplified, rightSimplified);
-    Trace::addTransformation("Simplify AdditionNode", before, simplified->toString());
+    Node* simplified = e.add(leftSimplified, rightSimplified);
+    if (tracing) {
+        Trace::addTransformation("Simplify AdditionNode", this, simplified);
+    }
     return simplified;
 }
 
 // **Symbolic Differentiation**
-Node* AdditionNode::derivative(const std::string& variable) const {
-    std::string before = toString();
-    Node* derivativeResult = new AdditionNode(left->derivative(variable), right->derivative(variable));
-    Trace::addTransformation("Differentiate AdditionNode", before, derivativeResult->toString());
+Node* AdditionNode::derivativeImpl(const std::string& variable, ExprArena& arena) const {
+    ExprHelper e(arena);
+    const bool tracing = Trace::enabled(TraceLevel::Summary);
+    Node* derivativeResult = e.add(left->derivative(variable, arena), right->derivative(variable, arena));
+    if (tracing) {
+        Trace::addTransformation("Differentiate AdditionNode", this, derivativeResult);
+    }
     return derivativeResult;
 }
 
 // **Symbolic Substitution**
-Node* AdditionNode::substitute(const std::string& variable, Node* value) const {
-    std::string before = toString();
-    Node* substituted = new AdditionNode(left->substitute(variable, value), right->substitute(variable, value));
-    Trace::addTransformation("Substituting in AdditionNode", before, substituted->toString());
+Node* AdditionNode::substitute(const std::string& variable, Node* value, ExprArena& arena) const {
+    ExprHelper e(arena);
+    const bool tracing = Trace::enabled(TraceLevel::Summary);
+    Node* substituted = e.add(left->substitute(variable, value, arena), right->substitute(variable, value, arena));
+    if (tracing) {
+        Trace::addTransformation("Substituting in AdditionNode", this, substituted);
+    }
     return substituted;
 }
 
 // **Clone**
-Node* AdditionNode::clone() const {
-    return new AdditionNode(left->clone(), right->clone());
+Node* AdditionNode::clone(ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.add(left->clone(arena), right->clone(arena));
 }
 
 } // namespace Expression
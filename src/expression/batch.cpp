@@ -0,0 +1,79 @@
+#include "expression/batch.h"
+#include "expression/node.h"
+#include "parallel/thread_pool.h"
+
+namespace Expression {
+
+BatchInput::BatchInput(std::size_t rows) : rows(rows) {}
+
+void BatchInput::bind(std::size_t slot, const double* column) {
+    if (columns.size() <= slot) {
+        columns.resize(slot + 1, nullptr);
+    }
+    columns[slot] = column;
+}
+
+std::size_t BatchInput::getRows() const {
+    return rows;
+}
+
+const std::vector<const double*>& BatchInput::getColumns() const {
+    return columns;
+}
+
+double* BatchScratch::acquire() {
+    if (used == blocks.size()) {
+        blocks.emplace_back(new double[kBatchBlockSize]);
+    }
+    return blocks[used++].get();
+}
+
+void BatchScratch::release() {
+    --used;
+}
+
+void BatchScratch::reset() {
+    used = 0;
+}
+
+void evaluateBatch(Node* expr, const BatchInput& input, double* out) {
+    BatchScratch scratch;
+    evaluateBatch(expr, input, out, scratch);
+}
+
+void evaluateBatch(Node* expr, const BatchInput& input, double* out, BatchScratch& scratch) {
+    // A node that threw mid-block leaves buffers acquired; start from a clean stack.
+    scratch.reset();
+    const std::vector<const double*>& columns = input.getColumns();
+    for (std::size_t begin = 0; begin < input.getRows(); begin += kBatchBlockSize) {
+        BatchBlock block{columns.data(), columns.size(), begin,
+                         std::min(kBatchBlockSize, input.getRows() - begin)};
+        expr->evaluateBatch(block, out + begin, scratch);
+    }
+}
+
+namespace {
+
+// One per thread; padded so the scratch counters of two threads never share a cache line.
+struct alignas(64) ThreadScratch {
+    BatchScratch scratch;
+};
+
+} // namespace
+
+void evaluateBatch(Node* expr, const BatchInput& input, double* out, ThreadPool& pool) {
+    const std::vector<const double*>& columns = input.getColumns();
+    const std::size_t rows = input.getRows();
+    std::vector<ThreadScratch> scratch(pool.getThreadCount());
+    pool.parallelFor((rows + kParallelChunkRows - 1) / kParallelChunkRows, [&](std::size_t chunk, std::size_t worker) {
+        BatchScratch& own = scratch[worker].scratch;
+        own.reset();
+        const std::size_t end = std::min(rows, (chunk + 1) * kParallelChunkRows);
+        for (std::size_t begin = chunk * kParallelChunkRows; begin < end; begin += kBatchBlockSize) {
+            BatchBlock block{columns.data(), columns.size(), begin, std::min(kBatchBlockSize, end - begin)};
+            expr->evaluateBatch(block, out + begin, own);
+        }
+    });
+}
+
+} // namespace Expression
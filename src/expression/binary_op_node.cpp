@@ -1,13 +1,23 @@
 #include "expression/binary_op_node.h"
+#include "helpers/expr_helper.h"
 
 namespace Expression {
 
-BinaryOpNode::BinaryOpNode(Node* left, Node* right)
-    : left(left), right(right) {}
+BinaryOpNode::BinaryOpNode(NodeKind kind, Node* left, Node* right)
+    : Node(kind, combineHash(combineHash(hashSeed(kind), left->getStructuralHash()), right->getStructuralHash())),
+      left(left), right(right) {}
 
 BinaryOpNode::~BinaryOpNode() {
     // delete left;
     // delete right;
 }
 
+Node* BinaryOpNode::getLeft() const {
+    return left;
+}
+
+Node* BinaryOpNode::getRight() const {
+    return right;
+}
+
 } // namespace Expression
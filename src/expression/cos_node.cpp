@@ -1,4 +1,5 @@
 #include "expression/cos_node.h"
+#include "helpers/expr_helper.h"
 #include "expression/number_node.h"
 #include "expression/multiplication_node.h"
 #include "expression/sin_node.h"
@@ -6,51 +7,66 @@
 namespace Expression {
 
 CosNode::CosNode(Node* operand)
-    : UnaryOpNode(operand) {}
+    : UnaryOpNode(NodeKind::Cos, operand) {}
 
 CosNode::~CosNode() {}
 
-double CosNode::evaluate(const Env &env) {
-    double opVal = operand->evaluate(env);
+double CosNode::evaluate(const double* slots) {
+    double opVal = operand->evaluate(slots);
     double result = std::cos(opVal);
-    Trace::addTransformation("Evaluating CosNode", toString(), std::to_string(result));
+    if (Trace::enabled(TraceLevel::Full)) {
+        Trace::addTransformation("Evaluating CosNode", toString(), std::to_string(result));
+    }
     return result;
 }
 
-std::string CosNode::toString() const {
-    return "cos(" + operand->toString() + ")";
+void CosNode::evaluateBatch(const BatchBlock& block, double* out, BatchScratch& scratch) {
+    operand->evaluateBatch(block, out, scratch);
+    for (std::size_t i = 0; i < block.count; ++i) {
+        out[i] = std::cos(out[i]);
+    }
 }
 
 // **Simplification**
-Node* CosNode::simplify() const {
-    std::string before = toString();
-    Node* simplified = new CosNode(operand->simplify());
-    Trace::addTransformation("Simplify CosNode", before, simplified->toString());
+Node* CosNode::simplifyImpl(ExprArena& arena) const {
+    ExprHelper e(arena);
+    const bool tracing = Trace::enabled(TraceLevel::Summary);
+    Node* simplified = e.cos(operand->simplify(arena));
+    if (tracing) {
+        Trace::addTransformation("Simplify CosNode", this, simplified);
+    }
     return simplified;
 }
 
 // **Differentiation (d/dx cos(x) = -sin(x) * dx)**
-Node* CosNode::derivative(const std::string& variable) const {
-    std::string before = toString();
-    Node* derivativeResult = new MultiplicationNode(
-        new NumberNode(-1), // Negative sign from differentiation
-        new MultiplicationNode(new SinNode(operand->clone()), operand->derivative(variable))
+Node* CosNode::derivativeImpl(const std::string& variable, ExprArena& arena) const {
+    ExprHelper e(arena);
+    const bool tracing = Trace::enabled(TraceLevel::Summary);
+    Node* derivativeResult = e.mul(
+        e.num(-1), // Negative sign from differentiation
+        e.mul(e.sin(operand->clone(arena)), operand->derivative(variable, arena))
     );
-    Trace::addTransformation("Differentiate CosNode", before, derivativeResult->toString());
+    if (tracing) {
+        Trace::addTransformation("Differentiate CosNode", this, derivativeResult);
+    }
     return derivativeResult;
 }
 
 // **Substitution**
-Node* CosNode::substitute(const std::string& variable, Node* value) const {
-    std::string before = toString();
-    Node* substituted = new CosNode(operand->substitute(variable, value));
-    Trace::addTransformation("Substituting in CosNode", before, substituted->toString());
+Node* CosNode::substitute(const std::string& variable, Node* value, ExprArena& arena) const {
+    ExprHelper e(arena);
+    const bool tracing = Trace::enabled(TraceLevel::Summary);
+    Node* substituted = e.cos(operand->substitute(variable, value, arena));
+    if (tracing) {
+        Trace::addTransformation("Substituting in CosNode", this, substituted);
+    }
     return substituted;
 }
 
 // **Clone**
-Node* CosNode::clone() const {
-    return new CosNode(operand->clone());
+Node* CosNode::clone(ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.cos(operand->clone(arena));
 }
 
 } // namespace Expression
@@ -1,4 +1,5 @@
 #include "expression/division_node.h"
+#include "helpers/expr_helper.h"
 #include "expression/number_node.h"
 #include "expression/multiplication_node.h"
 #include "expression/subtraction_node.h"
@@ -8,82 +9,104 @@
 namespace Expression {
 
 DivisionNode::DivisionNode(Node* left, Node* right)
-    : BinaryOpNode(left, right) {}
+    : BinaryOpNode(NodeKind::Division, left, right) {}
 
 DivisionNode::~DivisionNode() {}
 
-double DivisionNode::evaluate(const Env &env) {
-    double leftVal = left->evaluate(env);
-    double rightVal = right->evaluate(env);
+double DivisionNode::evaluate(const double* slots) {
+    double leftVal = left->evaluate(slots);
+    double rightVal = right->evaluate(slots);
 
     if (rightVal == 0) {
         throw std::runtime_error("Division by zero error in " + toString());
     }
 
     double result = leftVal / rightVal;
-    Trace::addTransformation("Evaluating DivisionNode", toString(), std::to_string(result));
+    if (Trace::enabled(TraceLevel::Full)) {
+        Trace::addTransformation("Evaluating DivisionNode", toString(), std::to_string(result));
+    }
     return result;
 }
 
-std::string DivisionNode::toString() const {
-    return "(" + left->toString() + " / " + right->toString() + ")";
+void DivisionNode::evaluateBatch(const BatchBlock& block, double* out, BatchScratch& scratch) {
+    double* rhs = scratch.acquire();
+    left->evaluateBatch(block, out, scratch);
+    right->evaluateBatch(block, rhs, scratch);
+
+    // Check the whole block first so the division loop stays branch-free.
+    bool divisionByZero = false;
+    for (std::size_t i = 0; i < block.count; ++i) {
+        divisionByZero |= rhs[i] == 0;
+    }
+    if (divisionByZero) {
+        throw std::runtime_error("Division by zero error in " + toString());
+    }
+
+    for (std::size_t i = 0; i < block.count; ++i) {
+        out[i] = out[i] / rhs[i];
+    }
+    scratch.release();
 }
 
 // **Symbolic Simplification**
-Node* DivisionNode::simplify() const {
-    Node* leftSimplified = left->simplify();
-    Node* rightSimplified = right->simplify();
+Node* DivisionNode::simplifyImpl(ExprArena& arena) const {
+    ExprHelper e(arena);
+    Node* leftSimplified = left->simplify(arena);
+    Node* rightSimplified = right->simplify(arena);
 
     // If both sides are numbers, perform constant folding.
-    if (auto leftNum = dynamic_cast<NumberNode*>(leftSimplified)) {
-        if (auto rightNum = dynamic_cast<NumberNode*>(rightSimplified)) {
+    if (auto leftNum = leftSimplified->as<NumberNode>()) {
+        if (auto rightNum = rightSimplified->as<NumberNode>()) {
             if (rightNum->getValue() == 0) {
                 throw std::runtime_error("Attempted division by zero in simplification.");
             }
-            return new NumberNode(leftNum->getValue() / rightNum->getValue());
+            return e.num(leftNum->getValue() / rightNum->getValue());
         }
     }
 
     // Identity rule: x / 1 = x
-    if (auto rightNum = dynamic_cast<NumberNode*>(rightSimplified)) {
+    if (auto rightNum = rightSimplified->as<NumberNode>()) {
         if (rightNum->getValue() == 1) {
             return leftSimplified;
         }
     }
 
     // Zero rule: 0 / x = 0
-    if (auto leftNum = dynamic_cast<NumberNode*>(leftSimplified)) {
+    if (auto leftNum = leftSimplified->as<NumberNode>()) {
         if (leftNum->getValue() == 0) {
-            return new NumberNode(0);
+            return e.num(0);
         }
     }
 
-    return new DivisionNode(leftSimplified, rightSimplified);
+    return e.div(leftSimplified, rightSimplified);
 }
 
 // **Symbolic Differentiation (Quotient Rule)**
-Node* DivisionNode::derivative(const std::string& variable) const {
-    Node* f_prime = left->derivative(variable);
-    Node* g_prime = right->derivative(variable);
-
-    Node* numerator = new SubtractionNode(
-        new MultiplicationNode(f_prime, right->clone()),
-        new MultiplicationNode(left->clone(), g_prime)
+Node* DivisionNode::derivativeImpl(const std::string& variable, ExprArena& arena) const {
+    ExprHelper e(arena);
+    Node* f_prime = left->derivative(variable, arena);
+    Node* g_prime = right->derivative(variable, arena);
+
+    Node* numerator = e.sub(
+        e.mul(f_prime, right->clone(arena)),
+        e.mul(left->clone(arena), g_prime)
     );
 
-    Node* denominator = new MultiplicationNode(right->clone(), right->clone());
+    Node* denominator = e.mul(right->clone(arena), right->clone(arena));
 
-    return new DivisionNode(numerator, denominator);
+    return e.div(numerator, denominator);
 }
 
 // **Symbolic Substitution**
-Node* DivisionNode::substitute(const std::string& variable, Node* value) const {
-    return new DivisionNode(left->substitute(variable, value), right->substitute(variable, value));
+Node* DivisionNode::substitute(const std::string& variable, Node* value, ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.div(left->substitute(variable, value, arena), right->substitute(variable, value, arena));
 }
 
 // **Clone**
-Node* DivisionNode::clone() const {
-    return new DivisionNode(left->clone(), right->clone());
+Node* DivisionNode::clone(ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.div(left->clone(arena), right->clone(arena));
 }
 
 } // namespace Expression
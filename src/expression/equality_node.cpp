@@ -1,4 +1,5 @@
 #include "expression/equality_node.h"
+#include "helpers/expr_helper.h"
 #include "expression/variable_node.h"
 #include "expression/number_node.h"
 #include "tracing/trace.h"
@@ -6,68 +7,98 @@
 namespace Expression {
 
 EqualityNode::EqualityNode(Node* left, Node* right)
-    : left(left), right(right) {}
+    : Node(NodeKind::Equality, combineHash(combineHash(hashSeed(NodeKind::Equality), left->getStructuralHash()),
+                                           right->getStructuralHash())),
+      left(left), right(right) {}
 
 EqualityNode::~EqualityNode() {
     // delete left;
     // delete right;
 }
 
-double EqualityNode::evaluate(const Env &env) {
-    double leftVal = left->evaluate(env);
-    double rightVal = right->evaluate(env);
+double EqualityNode::evaluate(const double* slots) {
+    double leftVal = left->evaluate(slots);
+    double rightVal = right->evaluate(slots);
     bool equal = std::fabs(leftVal - rightVal) < 1e-9; // Small tolerance
-    Trace::addTransformation("Evaluating EqualityNode", left->toString() + " == " + right->toString(), equal ? "true" : "false");
+    if (Trace::enabled(TraceLevel::Full)) {
+        Trace::addTransformation("Evaluating EqualityNode", left->toString() + " == " + right->toString(), equal ? "true" : "false");
+    }
     return equal ? 1.0 : 0.0;
 }
 
-std::string EqualityNode::toString() const {
-    return "(" + left->toString() + " == " + right->toString() + ")";
+void EqualityNode::evaluateBatch(const BatchBlock& block, double* out, BatchScratch& scratch) {
+    double* rhs = scratch.acquire();
+    left->evaluateBatch(block, out, scratch);
+    right->evaluateBatch(block, rhs, scratch);
+    for (std::size_t i = 0; i < block.count; ++i) {
+        out[i] = std::fabs(out[i] - rhs[i]) < 1e-9 ? 1.0 : 0.0; // Small tolerance
+    }
+    scratch.release();
 }
 
 // **Simplify: Remove unnecessary expressions**
-Node* EqualityNode::simplify() const {
-    Node* leftSimplified = left->simplify();
-    Node* rightSimplified = right->simplify();
+Node* EqualityNode::simplifyImpl(ExprArena& arena) const {
+    ExprHelper e(arena);
+    Node* leftSimplified = left->simplify(arena);
+    Node* rightSimplified = right->simplify(arena);
     
-    if (leftSimplified->toString() == rightSimplified->toString()) {
-        Trace::addTransformation("Simplify EqualityNode", toString(), "true");
-        return new NumberNode(1);
+    if (structurallyEqual(leftSimplified, rightSimplified)) {
+        if (Trace::enabled(TraceLevel::Summary)) {
+            Trace::addTransformation("Simplify EqualityNode", toString(), "true");
+        }
+        return e.num(1);
     }
-    return new EqualityNode(leftSimplified, rightSimplified);
+    return e.eq(leftSimplified, rightSimplified);
 }
 
 // **Derivative: The derivative of an equation is just the difference**
-Node* EqualityNode::derivative(const std::string& variable) const {
-    return new EqualityNode(left->derivative(variable), right->derivative(variable));
+Node* EqualityNode::derivativeImpl(const std::string& variable, ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.eq(left->derivative(variable, arena), right->derivative(variable, arena));
 }
 
 // **Substitute variable with a value/expression**
-Node* EqualityNode::substitute(const std::string& variable, Node* value) const {
-    return new EqualityNode(left->substitute(variable, value), right->substitute(variable, value));
+Node* EqualityNode::substitute(const std::string& variable, Node* value, ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.eq(left->substitute(variable, value, arena), right->substitute(variable, value, arena));
 }
 
 // **Clone the equality node**
-Node* EqualityNode::clone() const {
-    return new EqualityNode(left->clone(), right->clone());
+Node* EqualityNode::clone(ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.eq(left->clone(arena), right->clone(arena));
 }
 
 // **Solve for a given variable (simple rearrangement)**
-Node* EqualityNode::solveFor(const std::string& variable) const {
-    if (auto varNode = dynamic_cast<VariableNode*>(left)) {
-        if (varNode->toString() == variable) {
-            Trace::addTransformation("Solving equation", toString(), right->toString());
-            return right->clone();
+Node* EqualityNode::solveFor(const std::string& variable, ExprArena& arena) const {
+    if (auto varNode = left->as<VariableNode>()) {
+        if (varNode->getName() == variable) {
+            if (Trace::enabled(TraceLevel::Summary)) {
+                Trace::addTransformation("Solving equation", this, right);
+            }
+            return right->clone(arena);
         }
-    } else if (auto varNode = dynamic_cast<VariableNode*>(right)) {
-        if (varNode->toString() == variable) {
-            Trace::addTransformation("Solving equation", toString(), left->toString());
-            return left->clone();
+    } else if (auto varNode = right->as<VariableNode>()) {
+        if (varNode->getName() == variable) {
+            if (Trace::enabled(TraceLevel::Summary)) {
+                Trace::addTransformation("Solving equation", this, left);
+            }
+            return left->clone(arena);
         }
     }
 
-    Trace::addTransformation("Unable to solve equation for " + variable, toString(), "Unsolved");
-    return clone(); // Return as-is if unsolvable
+    if (Trace::enabled(TraceLevel::Summary)) {
+        Trace::addTransformation("Unable to solve equation for " + variable, toString(), "Unsolved");
+    }
+    return clone(arena); // Return as-is if unsolvable
+}
+
+Node* EqualityNode::getLeft() const {
+    return left;
+}
+
+Node* EqualityNode::getRight() const {
+    return right;
 }
 
 } // namespace Expression
@@ -1,4 +1,5 @@
 #include "expression/exponentiation_node.h"
+#include "helpers/expr_helper.h"
 #include "expression/multiplication_node.h"
 #include "expression/division_node.h"
 #include "expression/addition_node.h"
@@ -8,36 +9,54 @@
 namespace Expression {
 
 ExponentiationNode::ExponentiationNode(Node* base, Node* exponent)
-    : BinaryOpNode(base, exponent) {}
+    : BinaryOpNode(NodeKind::Exponentiation, base, exponent) {}
 
 ExponentiationNode::~ExponentiationNode() {}
 
-double ExponentiationNode::evaluate(const Env &env) {
-    double baseVal = left->evaluate(env);
-    double exponentVal = right->evaluate(env);
+double ExponentiationNode::evaluate(const double* slots) {
+    double baseVal = left->evaluate(slots);
+    double exponentVal = right->evaluate(slots);
     
     if (baseVal == 0 && exponentVal <= 0) {
         throw std::runtime_error("Math error: 0 raised to a non-positive exponent.");
     }
 
     double result = std::pow(baseVal, exponentVal);
-    Trace::addTransformation("Evaluating ExponentiationNode", toString(), std::to_string(result));
+    if (Trace::enabled(TraceLevel::Full)) {
+        Trace::addTransformation("Evaluating ExponentiationNode", toString(), std::to_string(result));
+    }
     return result;
 }
 
-std::string ExponentiationNode::toString() const {
-    return "(" + left->toString() + " ^ " + right->toString() + ")";
+void ExponentiationNode::evaluateBatch(const BatchBlock& block, double* out, BatchScratch& scratch) {
+    double* exponent = scratch.acquire();
+    left->evaluateBatch(block, out, scratch);
+    right->evaluateBatch(block, exponent, scratch);
+
+    bool invalid = false;
+    for (std::size_t i = 0; i < block.count; ++i) {
+        invalid |= out[i] == 0 && exponent[i] <= 0;
+    }
+    if (invalid) {
+        throw std::runtime_error("Math error: 0 raised to a non-positive exponent.");
+    }
+
+    for (std::size_t i = 0; i < block.count; ++i) {
+        out[i] = std::pow(out[i], exponent[i]);
+    }
+    scratch.release();
 }
 
 // **Symbolic Simplification**
-Node* ExponentiationNode::simplify() const {
-    Node* baseSimplified = left->simplify();
-    Node* exponentSimplified = right->simplify();
+Node* ExponentiationNode::simplifyImpl(ExprArena& arena) const {
+    ExprHelper e(arena);
+    Node* baseSimplified = left->simplify(arena);
+    Node* exponentSimplified = right->simplify(arena);
 
     // x^0 = 1
-    if (auto exponentNum = dynamic_cast<NumberNode*>(exponentSimplified)) {
+    if (auto exponentNum = exponentSimplified->as<NumberNode>()) {
         if (exponentNum->getValue() == 0) {
-            return new NumberNode(1);
+            return e.num(1);
         }
         if (exponentNum->getValue() == 1) {
             return baseSimplified;
@@ -45,49 +64,52 @@ Node* ExponentiationNode::simplify() const {
     }
 
     // 0^x = 0 (except when x = 0)
-    if (auto baseNum = dynamic_cast<NumberNode*>(baseSimplified)) {
+    if (auto baseNum = baseSimplified->as<NumberNode>()) {
         if (baseNum->getValue() == 0) {
-            return new NumberNode(0);
+            return e.num(0);
         }
         if (baseNum->getValue() == 1) {
-            return new NumberNode(1);
+            return e.num(1);
         }
     }
 
-    return new ExponentiationNode(baseSimplified, exponentSimplified);
+    return e.exp(baseSimplified, exponentSimplified);
 }
 
 // **Symbolic Differentiation (General Power Rule)**
-Node* ExponentiationNode::derivative(const std::string& variable) const {
+Node* ExponentiationNode::derivativeImpl(const std::string& variable, ExprArena& arena) const {
+    ExprHelper e(arena);
     // If exponent is constant, apply power rule: d/dx (f(x)^n) = n * f(x)^(n-1) * f'(x)
-    if (auto exponentNum = dynamic_cast<NumberNode*>(right)) {
+    if (auto exponentNum = right->as<NumberNode>()) {
         double n = exponentNum->getValue();
-        return new MultiplicationNode(
-            new MultiplicationNode(new NumberNode(n), 
-                new ExponentiationNode(left->clone(), new NumberNode(n - 1))
+        return e.mul(
+            e.mul(e.num(n), 
+                e.exp(left->clone(arena), e.num(n - 1))
             ),
-            left->derivative(variable)
+            left->derivative(variable, arena)
         );
     }
 
     // General case: d/dx (f(x)^g(x)) = f^g * (g' * ln(f) + g * f'/f)
-    Node* term1 = new MultiplicationNode(right->derivative(variable), new LnNode(left->clone()));
-    Node* term2 = new MultiplicationNode(right->clone(), new DivisionNode(left->derivative(variable), left->clone()));
+    Node* term1 = e.mul(right->derivative(variable, arena), e.ln(left->clone(arena)));
+    Node* term2 = e.mul(right->clone(arena), e.div(left->derivative(variable, arena), left->clone(arena)));
 
-    Node* fullDerivative = new MultiplicationNode(new ExponentiationNode(left->clone(), right->clone()), 
-                        new AdditionNode(term1, term2));
+    Node* fullDerivative = e.mul(e.exp(left->clone(arena), right->clone(arena)), 
+                        e.add(term1, term2));
 
     return fullDerivative;
 }
 
 // **Symbolic Substitution**
-Node* ExponentiationNode::substitute(const std::string& variable, Node* value) const {
-    return new ExponentiationNode(left->substitute(variable, value), right->substitute(variable, value));
+Node* ExponentiationNode::substitute(const std::string& variable, Node* value, ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.exp(left->substitute(variable, value, arena), right->substitute(variable, value, arena));
 }
 
 // **Clone**
-Node* ExponentiationNode::clone() const {
-    return new ExponentiationNode(left->clone(), right->clone());
+Node* ExponentiationNode::clone(ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.exp(left->clone(arena), right->clone(arena));
 }
 
 } // namespace Expression
@@ -1,78 +1,161 @@
 #include "expression/function_node.h"
+#include "helpers/expr_helper.h"
 #include "tracing/trace.h"
 
 namespace Expression {
 
-FunctionNode::FunctionNode(const std::string& name, int expectedArgCount, const std::vector<Node*>& arguments, FunctionCallback callback)
-    : name(name), expectedArgCount(expectedArgCount), arguments(arguments), callback(callback) {
+FunctionNode::FunctionNode(const std::string& name, int expectedArgCount, const std::vector<Node*>& arguments, FunctionCallback callback,
+                           DerivativeCallback derivativeCallback)
+    : FunctionNode(name, expectedArgCount, arguments,
+                   std::make_shared<const Callbacks>(Callbacks{std::move(callback), std::move(derivativeCallback)})) {}
+
+FunctionNode::FunctionNode(const std::string& name, int expectedArgCount, const std::vector<Node*>& arguments,
+                           std::shared_ptr<const Callbacks> callbacks)
+    : Node(NodeKind::Function, hashOf(name, arguments)), name(name), expectedArgCount(expectedArgCount), arguments(arguments),
+      callbacks(std::move(callbacks)) {
     if (arguments.size() != static_cast<size_t>(expectedArgCount)) {
          throw std::runtime_error("Function " + name + " expects " + std::to_string(expectedArgCount) +
                                   " arguments, but got " + std::to_string(arguments.size()));
     }
 }
 
+std::uint64_t FunctionNode::hashOf(const std::string& name, const std::vector<Node*>& arguments) {
+    std::uint64_t hash = combineHash(hashSeed(NodeKind::Function), std::hash<std::string>()(name));
+    for (const Node* argument : arguments) {
+        hash = combineHash(hash, argument->getStructuralHash());
+    }
+    return hash;
+}
+
 FunctionNode::~FunctionNode() {
     // for (auto arg : arguments) {
     //     delete arg;
     // }
 }
 
-double FunctionNode::evaluate(const Env &env) {
+double FunctionNode::evaluate(const double* slots) {
     if (arguments.size() != static_cast<size_t>(expectedArgCount)) {
          throw std::runtime_error("Function " + name + " expects " + std::to_string(expectedArgCount) +
                                   " arguments, but got " + std::to_string(arguments.size()));
     }
     std::vector<double> argValues;
     for (auto arg : arguments) {
-        argValues.push_back(arg->evaluate(env));
+        argValues.push_back(arg->evaluate(slots));
+    }
+    double result = callbacks->callback(argValues);
+    if (Trace::enabled(TraceLevel::Full)) {
+        Trace::addTransformation("Evaluating FunctionNode: " + name, toString(), std::to_string(result));
     }
-    double result = callback(argValues);
-    Trace::addTransformation("Evaluating FunctionNode: " + name, toString(), std::to_string(result));
     return result;
 }
 
-std::string FunctionNode::toString() const {
-    std::ostringstream oss;
-    oss << name << "(";
-    bool first = true;
+void FunctionNode::evaluateBatch(const BatchBlock& block, double* out, BatchScratch& scratch) {
+    std::vector<double*> argColumns;
     for (auto arg : arguments) {
-        if (!first) {
-            oss << ", ";
+        double* column = scratch.acquire();
+        arg->evaluateBatch(block, column, scratch);
+        argColumns.push_back(column);
+    }
+
+    std::vector<double> argValues(arguments.size());
+    for (std::size_t i = 0; i < block.count; ++i) {
+        for (std::size_t a = 0; a < argColumns.size(); ++a) {
+            argValues[a] = argColumns[a][i];
         }
-        oss << arg->toString();
-        first = false;
+        out[i] = callbacks->callback(argValues);
+    }
+
+    for (std::size_t a = 0; a < argColumns.size(); ++a) {
+        scratch.release();
     }
-    oss << ")";
-    return oss.str();
 }
 
 // **Simplification**
-Node* FunctionNode::simplify() const {
+Node* FunctionNode::simplifyImpl(ExprArena& arena) const {
+    ExprHelper e(arena);
     std::vector<Node*> simplifiedArgs;
     for (auto arg : arguments) {
-        simplifiedArgs.push_back(arg->simplify());
+        simplifiedArgs.push_back(arg->simplify(arena));
     }
-    return new FunctionNode(name, expectedArgCount, simplifiedArgs, callback);
+    return e.func(name, expectedArgCount, simplifiedArgs, callbacks);
 }
 
-// **Derivative (not implemented, requires function definitions)**
-Node* FunctionNode::derivative(const std::string& variable) const {
-    Trace::addTransformation("Derivative of function " + name + " is not implemented", toString(), "Unchanged");
-    return clone();
+// **Derivative: chain rule, sum of df/darg_i * darg_i/dx**
+// Each partial is a call to <name>_d<i>, evaluated through the derivative callback. Arguments
+// that do not depend on the variable are skipped, so no callback is needed if none does.
+Node* FunctionNode::derivativeImpl(const std::string& variable, ExprArena& arena) const {
+    ExprHelper e(arena);
+    Node* result = nullptr;
+    for (std::size_t i = 0; i < arguments.size(); ++i) {
+        Node* inner = arguments[i]->derivative(variable, arena);
+        const NumberNode* constant = inner->as<NumberNode>();
+        if (constant && constant->getValue() == 0) {
+            continue;
+        }
+        if (!callbacks->derivative) {
+            throw std::runtime_error("Function " + name + " has no derivative callback to differentiate it with.");
+        }
+        std::vector<Node*> args;
+        for (Node* arg : arguments) {
+            args.push_back(arg->clone(arena));
+        }
+        DerivativeCallback partialOf = callbacks->derivative;
+        Node* partial = e.func(name + "_d" + std::to_string(i), expectedArgCount, args,
+                               [partialOf, i](const std::vector<double>& values) { return partialOf(values, i); });
+        Node* term = e.mul(partial, inner);
+        result = result ? e.add(result, term) : term;
+    }
+    if (!result) {
+        result = e.num(0);
+    }
+    if (Trace::enabled(TraceLevel::Summary)) {
+        Trace::addTransformation("Differentiate FunctionNode", this, result);
+    }
+    return result;
 }
 
 // **Substitution**
-Node* FunctionNode::substitute(const std::string& variable, Node* value) const {
+Node* FunctionNode::substitute(const std::string& variable, Node* value, ExprArena& arena) const {
+    ExprHelper e(arena);
     std::vector<Node*> substitutedArgs;
     for (auto arg : arguments) {
-        substitutedArgs.push_back(arg->substitute(variable, value));
+        substitutedArgs.push_back(arg->substitute(variable, value, arena));
     }
-    return new FunctionNode(name, expectedArgCount, substitutedArgs, callback);
+    return e.func(name, expectedArgCount, substitutedArgs, callbacks);
 }
 
 // **Clone**
-Node* FunctionNode::clone() const {
-    return new FunctionNode(name, expectedArgCount, arguments, callback);
+Node* FunctionNode::clone(ExprArena& arena) const {
+    ExprHelper e(arena);
+    std::vector<Node*> clonedArgs;
+    for (auto arg : arguments) {
+        clonedArgs.push_back(arg->clone(arena));
+    }
+    return e.func(name, expectedArgCount, clonedArgs, callbacks);
+}
+
+const std::string& FunctionNode::getName() const {
+    return name;
+}
+
+int FunctionNode::getExpectedArgCount() const {
+    return expectedArgCount;
+}
+
+const std::vector<Node*>& FunctionNode::getArguments() const {
+    return arguments;
+}
+
+const FunctionNode::FunctionCallback& FunctionNode::getCallback() const {
+    return callbacks->callback;
+}
+
+const FunctionNode::DerivativeCallback& FunctionNode::getDerivativeCallback() const {
+    return callbacks->derivative;
+}
+
+const std::shared_ptr<const FunctionNode::Callbacks>& FunctionNode::getCallbacks() const {
+    return callbacks;
 }
 
 } // namespace Expression
@@ -1,58 +1,77 @@
 #include "expression/ln_node.h"
+#include "helpers/expr_helper.h"
 #include "expression/division_node.h"
 #include "tracing/trace.h"
 
 namespace Expression {
 
 LnNode::LnNode(Node* operand)
-    : UnaryOpNode(operand) {}
+    : UnaryOpNode(NodeKind::Ln, operand) {}
 
 LnNode::~LnNode() {}
 
-double LnNode::evaluate(const Env &env) {
-    double operandVal = operand->evaluate(env);
+double LnNode::evaluate(const double* slots) {
+    double operandVal = operand->evaluate(slots);
 
     if (operandVal <= 0) {
         throw std::runtime_error("Math error: ln of non-positive number.");
     }
 
     double result = std::log(operandVal);
-    Trace::addTransformation("Evaluating LnNode", toString(), std::to_string(result));
+    if (Trace::enabled(TraceLevel::Full)) {
+        Trace::addTransformation("Evaluating LnNode", toString(), std::to_string(result));
+    }
     return result;
 }
 
-std::string LnNode::toString() const {
-    return "ln(" + operand->toString() + ")";
+void LnNode::evaluateBatch(const BatchBlock& block, double* out, BatchScratch& scratch) {
+    operand->evaluateBatch(block, out, scratch);
+
+    bool invalid = false;
+    for (std::size_t i = 0; i < block.count; ++i) {
+        invalid |= out[i] <= 0;
+    }
+    if (invalid) {
+        throw std::runtime_error("Math error: ln of non-positive number.");
+    }
+
+    for (std::size_t i = 0; i < block.count; ++i) {
+        out[i] = std::log(out[i]);
+    }
 }
 
 // **Symbolic Simplification**
-Node* LnNode::simplify() const {
-    Node* simplifiedOperand = operand->simplify();
+Node* LnNode::simplifyImpl(ExprArena& arena) const {
+    ExprHelper e(arena);
+    Node* simplifiedOperand = operand->simplify(arena);
 
     // ln(1) = 0
-    if (auto numNode = dynamic_cast<NumberNode*>(simplifiedOperand)) {
+    if (auto numNode = simplifiedOperand->as<NumberNode>()) {
         if (numNode->getValue() == 1) {
-            return new NumberNode(0);
+            return e.num(0);
         }
     }
 
-    return new LnNode(simplifiedOperand);
+    return e.ln(simplifiedOperand);
 }
 
 // **Symbolic Differentiation**
-Node* LnNode::derivative(const std::string& variable) const {
-    // d/dx ln(x) = 1/x
-    return new DivisionNode(new NumberNode(1), operand->clone());
+Node* LnNode::derivativeImpl(const std::string& variable, ExprArena& arena) const {
+    ExprHelper e(arena);
+    // d/dx ln(f) = f' / f
+    return e.div(operand->derivative(variable, arena), operand->clone(arena));
 }
 
 // **Symbolic Substitution**
-Node* LnNode::substitute(const std::string& variable, Node* value) const {
-    return new LnNode(operand->substitute(variable, value));
+Node* LnNode::substitute(const std::string& variable, Node* value, ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.ln(operand->substitute(variable, value, arena));
 }
 
 // **Clone**
-Node* LnNode::clone() const {
-    return new LnNode(operand->clone());
+Node* LnNode::clone(ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.ln(operand->clone(arena));
 }
 
 } // namespace Expression
@@ -1,4 +1,5 @@
 #include "expression/log_node.h"
+#include "helpers/expr_helper.h"
 #include "expression/ln_node.h"
 #include "expression/division_node.h"
 #include "expression/multiplication_node.h"
@@ -7,57 +8,89 @@
 namespace Expression {
 
 LogNode::LogNode(Node* base, Node* operand)
-    : BinaryOpNode(base, operand) {}
+    : BinaryOpNode(NodeKind::Log, base, operand) {}
 
 LogNode::~LogNode() {}
 
-double LogNode::evaluate(const Env &env) {
-    double baseVal = left->evaluate(env);
-    double operandVal = right->evaluate(env);
+double LogNode::evaluate(const double* slots) {
+    double baseVal = left->evaluate(slots);
+    double operandVal = right->evaluate(slots);
 
     if (baseVal <= 0 || baseVal == 1 || operandVal <= 0) {
         throw std::runtime_error("Math error: log with invalid base or operand.");
     }
 
     double result = std::log(operandVal) / std::log(baseVal);
-    Trace::addTransformation("Evaluating LogNode", toString(), std::to_string(result));
+    if (Trace::enabled(TraceLevel::Full)) {
+        Trace::addTransformation("Evaluating LogNode", toString(), std::to_string(result));
+    }
     return result;
 }
 
-std::string LogNode::toString() const {
-    return "log(" + left->toString() + ", " + right->toString() + ")";
+void LogNode::evaluateBatch(const BatchBlock& block, double* out, BatchScratch& scratch) {
+    double* operandVals = scratch.acquire();
+    left->evaluateBatch(block, out, scratch);
+    right->evaluateBatch(block, operandVals, scratch);
+
+    bool invalid = false;
+    for (std::size_t i = 0; i < block.count; ++i) {
+        invalid |= out[i] <= 0 || out[i] == 1 || operandVals[i] <= 0;
+    }
+    if (invalid) {
+        throw std::runtime_error("Math error: log with invalid base or operand.");
+    }
+
+    for (std::size_t i = 0; i < block.count; ++i) {
+        out[i] = std::log(operandVals[i]) / std::log(out[i]);
+    }
+    scratch.release();
 }
 
 // **Symbolic Simplification**
-Node* LogNode::simplify() const {
-    Node* baseSimplified = left->simplify();
-    Node* operandSimplified = right->simplify();
+Node* LogNode::simplifyImpl(ExprArena& arena) const {
+    ExprHelper e(arena);
+    Node* baseSimplified = left->simplify(arena);
+    Node* operandSimplified = right->simplify(arena);
 
     // log_b(b) = 1
-    if (baseSimplified->toString() == operandSimplified->toString()) {
-        return new NumberNode(1);
+    if (structurallyEqual(baseSimplified, operandSimplified)) {
+        return e.num(1);
     }
 
-    return new LogNode(baseSimplified, operandSimplified);
+    return e.log(baseSimplified, operandSimplified);
 }
 
 // **Symbolic Differentiation**
-Node* LogNode::derivative(const std::string& variable) const {
-    // d/dx log_b(x) = 1 / (x ln(b))
-    return new DivisionNode(
-        new NumberNode(1),
-        new MultiplicationNode(right->clone(), new LnNode(left->clone()))
+Node* LogNode::derivativeImpl(const std::string& variable, ExprArena& arena) const {
+    ExprHelper e(arena);
+    // Constant base: d/dx log_b(f) = f' / (f ln(b))
+    if (left->is<NumberNode>()) {
+        return e.div(
+            right->derivative(variable, arena),
+            e.mul(right->clone(arena), e.ln(left->clone(arena)))
+        );
+    }
+
+    // General case: log_b(f) = ln(f) / ln(b), so the derivative is
+    // (f'/f * ln(b) - ln(f) * b'/b) / ln(b)^2
+    Node* lnBase = e.ln(left->clone(arena));
+    Node* numerator = e.sub(
+        e.mul(e.div(right->derivative(variable, arena), right->clone(arena)), lnBase),
+        e.mul(e.ln(right->clone(arena)), e.div(left->derivative(variable, arena), left->clone(arena)))
     );
+    return e.div(numerator, e.mul(lnBase, lnBase));
 }
 
 // **Symbolic Substitution**
-Node* LogNode::substitute(const std::string& variable, Node* value) const {
-    return new LogNode(left->substitute(variable, value), right->substitute(variable, value));
+Node* LogNode::substitute(const std::string& variable, Node* value, ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.log(left->substitute(variable, value, arena), right->substitute(variable, value, arena));
 }
 
 // **Clone**
-Node* LogNode::clone() const {
-    return new LogNode(left->clone(), right->clone());
+Node* LogNode::clone(ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.log(left->clone(arena), right->clone(arena));
 }
 
 } // namespace Expression
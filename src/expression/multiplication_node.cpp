@@ -1,4 +1,5 @@
 #include "expression/multiplication_node.h"
+#include "helpers/expr_helper.h"
 #include "expression/number_node.h"
 #include "expression/addition_node.h"
 #include "tracing/trace.h"
@@ -6,87 +7,117 @@
 namespace Expression {
 
 MultiplicationNode::MultiplicationNode(Node* left, Node* right)
-    : BinaryOpNode(left, right) {}
+    : BinaryOpNode(NodeKind::Multiplication, left, right) {}
 
 MultiplicationNode::~MultiplicationNode() {}
 
-double MultiplicationNode::evaluate(const Env &env) {
-    double leftVal = left->evaluate(env);
-    double rightVal = right->evaluate(env);
+double MultiplicationNode::evaluate(const double* slots) {
+    double leftVal = left->evaluate(slots);
+    double rightVal = right->evaluate(slots);
     double result = leftVal * rightVal;
-    Trace::addTransformation("Evaluating MultiplicationNode", toString(), std::to_string(result));
+    if (Trace::enabled(TraceLevel::Full)) {
+        Trace::addTransformation("Evaluating MultiplicationNode", toString(), std::to_string(result));
+    }
     return result;
 }
 
-std::string MultiplicationNode::toString() const {
-    return "(" + left->toString() + " * " + right->toString() + ")";
+void MultiplicationNode::evaluateBatch(const BatchBlock& block, double* out, BatchScratch& scratch) {
+    double* rhs = scratch.acquire();
+    left->evaluateBatch(block, out, scratch);
+    right->evaluateBatch(block, rhs, scratch);
+    for (std::size_t i = 0; i < block.count; ++i) {
+        out[i] = out[i] * rhs[i];
+    }
+    scratch.release();
 }
 
 // **Symbolic Simplification**
-Node* MultiplicationNode::simplify() const {
-    Node* leftSimplified = left->simplify();
-    Node* rightSimplified = right->simplify();
+Node* MultiplicationNode::simplifyImpl(ExprArena& arena) const {
+    ExprHelper e(arena);
+    Node* leftSimplified = left->simplify(arena);
+    Node* rightSimplified = right->simplify(arena);
     
-    std::string before = toString();
+    const bool tracing = Trace::enabled(TraceLevel::Summary);
 
     // If both sides are numbers, perform constant folding.
-    if (auto leftNum = dynamic_cast<NumberNode*>(leftSimplified)) {
-        if (auto rightNum = dynamic_cast<NumberNode*>(rightSimplified)) {
-            Node* simplified = new NumberNode(leftNum->getValue() * rightNum->getValue());
-            Trace::addTransformation("Constant folding in MultiplicationNode", before, simplified->toString());
+    if (auto leftNum = leftSimplified->as<NumberNode>()) {
+        if (auto rightNum = rightSimplified->as<NumberNode>()) {
+            Node* simplified = e.num(leftNum->getValue() * rightNum->getValue());
+            if (tracing) {
+                Trace::addTransformation("Constant folding in MultiplicationNode", this, simplified);
+            }
             return simplified;
         }
     }
 
     // Identity Rule: x * 1 = x, x * 0 = 0
-    if (auto rightNum = dynamic_cast<NumberNode*>(rightSimplified)) {
+    if (auto rightNum = rightSimplified->as<NumberNode>()) {
         if (rightNum->getValue() == 1) {
-            Trace::addTransformation("Simplify MultiplicationNode", before, leftSimplified->toString());
+            if (tracing) {
+                Trace::addTransformation("Simplify MultiplicationNode", this, leftSimplified);
+            }
             return leftSimplified;
         }
         if (rightNum->getValue() == 0) {
-            Trace::addTransformation("Simplify MultiplicationNode", before, "0");
-            return new NumberNode(0);
+            Node* zero = e.num(0);
+            if (tracing) {
+                Trace::addTransformation("Simplify MultiplicationNode", this, zero);
+            }
+            return zero;
         }
     }
 
-    if (auto leftNum = dynamic_cast<NumberNode*>(leftSimplified)) {
+    if (auto leftNum = leftSimplified->as<NumberNode>()) {
         if (leftNum->getValue() == 1) {
-            Trace::addTransformation("Simplify MultiplicationNode", before, rightSimplified->toString());
+            if (tracing) {
+                Trace::addTransformation("Simplify MultiplicationNode", this, rightSimplified);
+            }
             return rightSimplified;
         }
         if (leftNum->getValue() == 0) {
-            Trace::addTransformation("Simplify MultiplicationNode", before, "0");
-            return new NumberNode(0);
+            Node* zero = e.num(0);
+            if (tracing) {
+                Trace::addTransformation("Simplify MultiplicationNode", this, zero);
+            }
+            return zero;
         }
     }
 
-    Node* simplified = new MultiplicationNode(leftSimplified, rightSimplified);
-    Trace::addTransformation("Simplify MultiplicationNode", before, simplified->toString());
+    Node* simplified = e.mul(leftSimplified, rightSimplified);
+    if (tracing) {
+        Trace::addTransformation("Simplify MultiplicationNode", this, simplified);
+    }
     return simplified;
 }
 
 // **Symbolic Differentiation (Product Rule)**
-Node* MultiplicationNode::derivative(const std::string& variable) const {
-    std::string before = toString();
-    Node* term1 = new MultiplicationNode(left->derivative(variable), right->clone());
-    Node* term2 = new MultiplicationNode(left->clone(), right->derivative(variable));
-    Node* result = new AdditionNode(term1, term2);
-    Trace::addTransformation("Differentiate MultiplicationNode", before, result->toString());
+Node* MultiplicationNode::derivativeImpl(const std::string& variable, ExprArena& arena) const {
+    ExprHelper e(arena);
+    const bool tracing = Trace::enabled(TraceLevel::Summary);
+    Node* term1 = e.mul(left->derivative(variable, arena), right->clone(arena));
+    Node* term2 = e.mul(left->clone(arena), right->derivative(variable, arena));
+    Node* result = e.add(term1, term2);
+    if (tracing) {
+        Trace::addTransformation("Differentiate MultiplicationNode", this, result);
+    }
     return result;
 }
 
 // **Symbolic Substitution**
-Node* MultiplicationNode::substitute(const std::string& variable, Node* value) const {
-    std::string before = toString();
-    Node* substituted = new MultiplicationNode(left->substitute(variable, value), right->substitute(variable, value));
-    Trace::addTransformation("Substituting in MultiplicationNode", before, substituted->toString());
+Node* MultiplicationNode::substitute(const std::string& variable, Node* value, ExprArena& arena) const {
+    ExprHelper e(arena);
+    const bool tracing = Trace::enabled(TraceLevel::Summary);
+    Node* substituted = e.mul(left->substitute(variable, value, arena), right->substitute(variable, value, arena));
+    if (tracing) {
+        Trace::addTransformation("Substituting in MultiplicationNode", this, substituted);
+    }
     return substituted;
 }
 
 // **Clone**
-Node* MultiplicationNode::clone() const {
-    return new MultiplicationNode(left->clone(), right->clone());
+Node* MultiplicationNode::clone(ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.mul(left->clone(arena), right->clone(arena));
 }
 
 } // namespace Expression
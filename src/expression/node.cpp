@@ -1,7 +1,158 @@
 #include "expression/node.h"
+#include "printer/expr_printer.h"
+#include "memory/expr_arena.h"
+#include "memory/symbolic_cache.h"
+#include "expression/number_node.h"
+#include "expression/variable_node.h"
+#include "expression/binary_op_node.h"
+#include "expression/unary_op_node.h"
+#include "expression/equality_node.h"
+#include "expression/function_node.h"
+
+#include <algorithm>
+#include <unordered_set>
 
 namespace Expression {
 
+Node::Node(NodeKind kind, std::uint64_t structuralHash) : kind(kind), structuralHash(structuralHash) {}
+
 Node::~Node() {}
 
+namespace {
+
+// The distinct variables of a tree, visiting each shared node once.
+void collectVariables(const Node* root, std::vector<const VariableNode*>& variables) {
+    std::unordered_set<const Node*> visited;
+    std::vector<const Node*> pending{root};
+    while (!pending.empty()) {
+        const Node* node = pending.back();
+        pending.pop_back();
+        if (!visited.insert(node).second) {
+            continue;
+        }
+        switch (node->getKind()) {
+        case NodeKind::Number:
+            break;
+        case NodeKind::Variable:
+            variables.push_back(static_cast<const VariableNode*>(node));
+            break;
+        case NodeKind::Sin:
+        case NodeKind::Cos:
+        case NodeKind::Ln:
+            pending.push_back(static_cast<const UnaryOpNode*>(node)->getOperand());
+            break;
+        case NodeKind::Equality:
+            pending.push_back(static_cast<const EqualityNode*>(node)->getLeft());
+            pending.push_back(static_cast<const EqualityNode*>(node)->getRight());
+            break;
+        case NodeKind::Function:
+            for (const Node* argument : static_cast<const FunctionNode*>(node)->getArguments()) {
+                pending.push_back(argument);
+            }
+            break;
+        default:
+            pending.push_back(static_cast<const BinaryOpNode*>(node)->getLeft());
+            pending.push_back(static_cast<const BinaryOpNode*>(node)->getRight());
+            break;
+        }
+    }
+}
+
+} // namespace
+
+double Node::evaluate(const Env &env) {
+    std::vector<const VariableNode*> variables;
+    collectVariables(this, variables);
+    std::size_t slotCount = 0;
+    for (const VariableNode* variable : variables) {
+        slotCount = std::max(slotCount, variable->getSlot() + 1);
+    }
+    std::vector<double> slots(slotCount, 0.0);
+    for (const VariableNode* variable : variables) {
+        auto it = env.find(variable->getName());
+        if (it != env.end()) {
+            slots[variable->getSlot()] = it->second;
+        }
+    }
+    return evaluate(slots.data());
+}
+
+std::string Node::toString() const {
+    return ExprPrinter::toString(this);
+}
+
+// Leaves are cheaper to rebuild than to look up, so only operators go through the cache.
+Node* Node::simplify(ExprArena& arena) const {
+    SymbolicCache* cache = arena.getSymbolicCache();
+    if (!cache || kind == NodeKind::Number || kind == NodeKind::Variable) {
+        return simplifyImpl(arena);
+    }
+    if (Node* cached = cache->findSimplified(this)) {
+        return cached;
+    }
+    Node* result = simplifyImpl(arena);
+    cache->storeSimplified(this, result);
+    return result;
+}
+
+Node* Node::derivative(const std::string& variable, ExprArena& arena) const {
+    SymbolicCache* cache = arena.getSymbolicCache();
+    if (!cache || kind == NodeKind::Number || kind == NodeKind::Variable) {
+        return derivativeImpl(variable, arena);
+    }
+    if (Node* cached = cache->findDerivative(this, variable)) {
+        return cached;
+    }
+    Node* result = derivativeImpl(variable, arena);
+    cache->storeDerivative(this, variable, result);
+    return result;
+}
+
+bool structurallyEqual(const Node* a, const Node* b) {
+    if (a == b) {
+        return true;
+    }
+    if (a->getStructuralHash() != b->getStructuralHash() || a->getKind() != b->getKind()) {
+        return false;
+    }
+    switch (a->getKind()) {
+    case NodeKind::Number: {
+        double x = static_cast<const NumberNode*>(a)->getValue();
+        double y = static_cast<const NumberNode*>(b)->getValue();
+        return std::memcmp(&x, &y, sizeof(double)) == 0;
+    }
+    case NodeKind::Variable:
+        return static_cast<const VariableNode*>(a)->getName() == static_cast<const VariableNode*>(b)->getName();
+    case NodeKind::Sin:
+    case NodeKind::Cos:
+    case NodeKind::Ln:
+        return structurallyEqual(static_cast<const UnaryOpNode*>(a)->getOperand(),
+                                 static_cast<const UnaryOpNode*>(b)->getOperand());
+    case NodeKind::Equality: {
+        auto x = static_cast<const EqualityNode*>(a);
+        auto y = static_cast<const EqualityNode*>(b);
+        return structurallyEqual(x->getLeft(), y->getLeft()) && structurallyEqual(x->getRight(), y->getRight());
+    }
+    case NodeKind::Function: {
+        auto x = static_cast<const FunctionNode*>(a);
+        auto y = static_cast<const FunctionNode*>(b);
+        if (x->getName() != y->getName() || x->getArguments().size() != y->getArguments().size() ||
+            x->getCallbacks() != y->getCallbacks()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < x->getArguments().size(); ++i) {
+            if (!structurallyEqual(x->getArguments()[i], y->getArguments()[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    default: {
+        auto x = static_cast<const BinaryOpNode*>(a);
+        auto y = static_cast<const BinaryOpNode*>(b);
+        return structurallyEqual(x->getLeft(), y->getLeft()) && structurallyEqual(x->getRight(), y->getRight());
+    }
+    }
+}
+
 } // namespace Expression
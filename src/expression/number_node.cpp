@@ -1,36 +1,51 @@
 #include "expression/number_node.h"
+#include "helpers/expr_helper.h"
 
 namespace Expression {
 
-NumberNode::NumberNode(double value) : value(value) {}
+namespace {
+
+std::uint64_t bitsOf(double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+} // namespace
+
+NumberNode::NumberNode(double value) : Node(NodeKind::Number, combineHash(hashSeed(NodeKind::Number), bitsOf(value))), value(value) {}
 
 NumberNode::~NumberNode() {}
 
-double NumberNode::evaluate(const Env &env) {
-    Trace::add("Evaluating NumberNode: " + toString());
+double NumberNode::evaluate(const double* slots) {
+    if (Trace::enabled(TraceLevel::Full)) {
+        Trace::add("Evaluating NumberNode: " + toString());
+    }
     return value;
 }
 
-std::string NumberNode::toString() const {
-    std::ostringstream oss;
-    oss << value;
-    return oss.str();
+void NumberNode::evaluateBatch(const BatchBlock& block, double* out, BatchScratch& scratch) {
+    std::fill(out, out + block.count, value);
 }
 
-Node* NumberNode::simplify() const {
-    return new NumberNode(value);
+Node* NumberNode::simplifyImpl(ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.num(value);
 }
 
-Node* NumberNode::derivative(const std::string& variable) const {
-    return new NumberNode(0);  // d/dx (constant) = 0
+Node* NumberNode::derivativeImpl(const std::string& variable, ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.num(0);  // d/dx (constant) = 0
 }
 
-Node* NumberNode::substitute(const std::string& variable, Node* value) const {
-    return new NumberNode(this->value);
+Node* NumberNode::substitute(const std::string& variable, Node* value, ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.num(this->value);
 }
 
-Node* NumberNode::clone() const {
-    return new NumberNode(value);
+Node* NumberNode::clone(ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.num(value);
 }
 
 double NumberNode::getValue() const {
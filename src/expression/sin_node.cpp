@@ -1,4 +1,5 @@
 #include "expression/sin_node.h"
+#include "helpers/expr_helper.h"
 #include "expression/number_node.h"
 #include "expression/multiplication_node.h"
 #include "expression/cos_node.h"
@@ -6,48 +7,63 @@
 namespace Expression {
 
 SinNode::SinNode(Node* operand)
-    : UnaryOpNode(operand) {}
+    : UnaryOpNode(NodeKind::Sin, operand) {}
 
 SinNode::~SinNode() {}
 
-double SinNode::evaluate(const Env &env) {
-    double opVal = operand->evaluate(env);
+double SinNode::evaluate(const double* slots) {
+    double opVal = operand->evaluate(slots);
     double result = std::sin(opVal);
-    Trace::addTransformation("Evaluating SinNode", toString(), std::to_string(result));
+    if (Trace::enabled(TraceLevel::Full)) {
+        Trace::addTransformation("Evaluating SinNode", toString(), std::to_string(result));
+    }
     return result;
 }
 
-std::string SinNode::toString() const {
-    return "sin(" + operand->toString() + ")";
+void SinNode::evaluateBatch(const BatchBlock& block, double* out, BatchScratch& scratch) {
+    operand->evaluateBatch(block, out, scratch);
+    for (std::size_t i = 0; i < block.count; ++i) {
+        out[i] = std::sin(out[i]);
+    }
 }
 
 // **Simplification**
-Node* SinNode::simplify() const {
-    std::string before = toString();
-    Node* simplified = new SinNode(operand->simplify());
-    Trace::addTransformation("Simplify SinNode", before, simplified->toString());
+Node* SinNode::simplifyImpl(ExprArena& arena) const {
+    ExprHelper e(arena);
+    const bool tracing = Trace::enabled(TraceLevel::Summary);
+    Node* simplified = e.sin(operand->simplify(arena));
+    if (tracing) {
+        Trace::addTransformation("Simplify SinNode", this, simplified);
+    }
     return simplified;
 }
 
 // **Differentiation (d/dx sin(x) = cos(x) * dx)**
-Node* SinNode::derivative(const std::string& variable) const {
-    std::string before = toString();
-    Node* derivativeResult = new MultiplicationNode(new CosNode(operand->clone()), operand->derivative(variable));
-    Trace::addTransformation("Differentiate SinNode", before, derivativeResult->toString());
+Node* SinNode::derivativeImpl(const std::string& variable, ExprArena& arena) const {
+    ExprHelper e(arena);
+    const bool tracing = Trace::enabled(TraceLevel::Summary);
+    Node* derivativeResult = e.mul(e.cos(operand->clone(arena)), operand->derivative(variable, arena));
+    if (tracing) {
+        Trace::addTransformation("Differentiate SinNode", this, derivativeResult);
+    }
     return derivativeResult;
 }
 
 // **Substitution**
-Node* SinNode::substitute(const std::string& variable, Node* value) const {
-    std::string before = toString();
-    Node* substituted = new SinNode(operand->substitute(variable, value));
-    Trace::addTransformation("Substituting in SinNode", before, substituted->toString());
+Node* SinNode::substitute(const std::string& variable, Node* value, ExprArena& arena) const {
+    ExprHelper e(arena);
+    const bool tracing = Trace::enabled(TraceLevel::Summary);
+    Node* substituted = e.sin(operand->substitute(variable, value, arena));
+    if (tracing) {
+        Trace::addTransformation("Substituting in SinNode", this, substituted);
+    }
     return substituted;
 }
 
 // **Clone**
-Node* SinNode::clone() const {
-    return new SinNode(operand->clone());
+Node* SinNode::clone(ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.sin(operand->clone(arena));
 }
 
 } // namespace Expression
@@ -1,66 +1,79 @@
 #include "expression/subtraction_node.h"
+#include "helpers/expr_helper.h"
 #include "expression/number_node.h"
 #include "tracing/trace.h"
 
 namespace Expression {
 
 SubtractionNode::SubtractionNode(Node* left, Node* right)
-    : BinaryOpNode(left, right) {}
+    : BinaryOpNode(NodeKind::Subtraction, left, right) {}
 
 SubtractionNode::~SubtractionNode() {}
 
-double SubtractionNode::evaluate(const Env &env) {
-    double leftVal = left->evaluate(env);
-    double rightVal = right->evaluate(env);
+double SubtractionNode::evaluate(const double* slots) {
+    double leftVal = left->evaluate(slots);
+    double rightVal = right->evaluate(slots);
     double result = leftVal - rightVal;
-    Trace::addTransformation("Evaluating SubtractionNode", toString(), std::to_string(result));
+    if (Trace::enabled(TraceLevel::Full)) {
+        Trace::addTransformation("Evaluating SubtractionNode", toString(), std::to_string(result));
+    }
     return result;
 }
 
-std::string SubtractionNode::toString() const {
-    return "(" + left->toString() + " - " + right->toString() + ")";
+void SubtractionNode::evaluateBatch(const BatchBlock& block, double* out, BatchScratch& scratch) {
+    double* rhs = scratch.acquire();
+    left->evaluateBatch(block, out, scratch);
+    right->evaluateBatch(block, rhs, scratch);
+    for (std::size_t i = 0; i < block.count; ++i) {
+        out[i] = out[i] - rhs[i];
+    }
+    scratch.release();
 }
 
 // **Symbolic Simplification**
-Node* SubtractionNode::simplify() const {
-    Node* leftSimplified = left->simplify();
-    Node* rightSimplified = right->simplify();
+Node* SubtractionNode::simplifyImpl(ExprArena& arena) const {
+    ExprHelper e(arena);
+    Node* leftSimplified = left->simplify(arena);
+    Node* rightSimplified = right->simplify(arena);
 
     // If both sides are numbers, perform constant folding.
-    if (auto leftNum = dynamic_cast<NumberNode*>(leftSimplified)) {
-        if (auto rightNum = dynamic_cast<NumberNode*>(rightSimplified)) {
-            return new NumberNode(leftNum->getValue() - rightNum->getValue());
+    if (auto leftNum = leftSimplified->as<NumberNode>()) {
+        if (auto rightNum = rightSimplified->as<NumberNode>()) {
+            return e.num(leftNum->getValue() - rightNum->getValue());
         }
     }
 
     // Identity rule: x - 0 = x
-    if (auto rightNum = dynamic_cast<NumberNode*>(rightSimplified)) {
+    if (auto rightNum = rightSimplified->as<NumberNode>()) {
         if (rightNum->getValue() == 0) {
             return leftSimplified;
         }
     }
 
     // x - x = 0
-    if (left->toString() == right->toString()) {
-        return new NumberNode(0);
+    if (structurallyEqual(leftSimplified, rightSimplified)) {
+        return e.num(0);
     }
 
-    return new SubtractionNode(leftSimplified, rightSimplified);
+    return e.sub(leftSimplified, rightSimplified);
 }
 
 // **Symbolic Differentiation**
-Node* SubtractionNode::derivative(const std::string& variable) const {
-    return new SubtractionNode(left->derivative(variable), right->derivative(variable));
+Node* SubtractionNode::derivativeImpl(const std::string& variable, ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.sub(left->derivative(variable, arena), right->derivative(variable, arena));
 }
 
 // **Symbolic Substitution**
-Node* SubtractionNode::substitute(const std::string& variable, Node* value) const {
-    return new SubtractionNode(left->substitute(variable, value), right->substitute(variable, value));
+Node* SubtractionNode::substitute(const std::string& variable, Node* value, ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.sub(left->substitute(variable, value, arena), right->substitute(variable, value, arena));
 }
 
 // **Clone**
-Node* SubtractionNode::clone() const {
-    return new SubtractionNode(left->clone(), right->clone());
+Node* SubtractionNode::clone(ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.sub(left->clone(arena), right->clone(arena));
 }
 
 } // namespace Expression
@@ -0,0 +1,52 @@
+#include "expression/symbol_table.h"
+
+namespace Expression {
+
+std::size_t SymbolTable::intern(const std::string& name) {
+    auto it = slots.find(name);
+    if (it != slots.end()) {
+        return it->second;
+    }
+    std::size_t slot = names.size();
+    names.push_back(name);
+    slots.emplace(name, slot);
+    return slot;
+}
+
+bool SymbolTable::contains(const std::string& name) const {
+    return slots.find(name) != slots.end();
+}
+
+std::size_t SymbolTable::lookup(const std::string& name) const {
+    auto it = slots.find(name);
+    if (it == slots.end()) {
+        throw std::runtime_error("Unknown variable: " + name);
+    }
+    return it->second;
+}
+
+const std::string& SymbolTable::nameOf(std::size_t slot) const {
+    if (slot >= names.size()) {
+        throw std::runtime_error("Slot " + std::to_string(slot) + " is not bound to a variable.");
+    }
+    return names[slot];
+}
+
+std::size_t SymbolTable::size() const {
+    return names.size();
+}
+
+std::vector<double> SymbolTable::bind(const Env& env) const {
+    std::vector<double> values(names.size());
+    bind(env, values.data());
+    return values;
+}
+
+void SymbolTable::bind(const Env& env, double* values) const {
+    for (std::size_t slot = 0; slot < names.size(); ++slot) {
+        auto it = env.find(names[slot]);
+        values[slot] = it != env.end() ? it->second : 0.0;
+    }
+}
+
+} // namespace Expression
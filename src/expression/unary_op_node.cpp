@@ -1,11 +1,17 @@
 #include "expression/unary_op_node.h"
+#include "helpers/expr_helper.h"
 
 namespace Expression {
 
-UnaryOpNode::UnaryOpNode(Node* operand) : operand(operand) {}
+UnaryOpNode::UnaryOpNode(NodeKind kind, Node* operand)
+    : Node(kind, combineHash(hashSeed(kind), operand->getStructuralHash())), operand(operand) {}
 
 UnaryOpNode::~UnaryOpNode() {
     // delete operand;
 }
 
+Node* UnaryOpNode::getOperand() const {
+    return operand;
+}
+
 } // namespace Expression
@@ -1,42 +1,58 @@
 #include "expression/variable_node.h"
+#include "helpers/expr_helper.h"
 #include "expression/number_node.h"
 
 namespace Expression {
 
-VariableNode::VariableNode(const std::string& name) : name(name) {}
+VariableNode::VariableNode(const std::string& name, std::size_t slot)
+    : Node(NodeKind::Variable, combineHash(hashSeed(NodeKind::Variable), std::hash<std::string>()(name))),
+      name(name), slot(slot) {}
 
 VariableNode::~VariableNode() {}
 
-double VariableNode::evaluate(const Env &env) {
-    auto it = env.find(name);
-    if (it != env.end()) {
-        return it->second;
-    }
-    return 0.0;  // Default to 0 if not found.
+double VariableNode::evaluate(const double* slots) {
+    return slots[slot];
 }
 
-std::string VariableNode::toString() const {
-    return name;
+void VariableNode::evaluateBatch(const BatchBlock& block, double* out, BatchScratch& scratch) {
+    const double* column = slot < block.columnCount ? block.columns[slot] : nullptr;
+    if (column) {
+        std::copy(column + block.begin, column + block.begin + block.count, out);
+    } else {
+        std::fill(out, out + block.count, 0.0);  // Unbound columns read as 0, like a missing variable.
+    }
 }
 
 // **Simplification**
-Node* VariableNode::simplify() const {
-    return new VariableNode(name);
+Node* VariableNode::simplifyImpl(ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.var(name);
 }
 
 // **Differentiation**
-Node* VariableNode::derivative(const std::string& variable) const {
-    return new NumberNode(name == variable ? 1 : 0);
+Node* VariableNode::derivativeImpl(const std::string& variable, ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.num(name == variable ? 1 : 0);
 }
 
 // **Substitution**
-Node* VariableNode::substitute(const std::string& variable, Node* value) const {
-    return (name == variable) ? value->clone() : new VariableNode(name);
+Node* VariableNode::substitute(const std::string& variable, Node* value, ExprArena& arena) const {
+    ExprHelper e(arena);
+    return (name == variable) ? value->clone(arena) : e.var(name);
 }
 
 // **Clone**
-Node* VariableNode::clone() const {
-    return new VariableNode(name);
+Node* VariableNode::clone(ExprArena& arena) const {
+    ExprHelper e(arena);
+    return e.var(name);
+}
+
+const std::string& VariableNode::getName() const {
+    return name;
+}
+
+std::size_t VariableNode::getSlot() const {
+    return slot;
 }
 
 } // namespace Expression
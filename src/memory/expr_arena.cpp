@@ -0,0 +1,132 @@
+#include "memory/expr_arena.h"
+#include "memory/symbolic_cache.h"
+
+namespace Expression {
+
+ExprArena::ExprArena(std::size_t chunkSize) : chunkSize(chunkSize) {
+    if (chunkSize == 0) {
+        throw std::runtime_error("ExprArena chunk size must be positive.");
+    }
+}
+
+ExprArena::~ExprArena() {
+    setSymbolicCache(nullptr);
+    runFinalizers();
+}
+
+void* ExprArena::allocate(std::size_t size, std::size_t alignment) {
+    if (void* memory = allocateFromChunk(size, alignment)) {
+        return memory;
+    }
+
+    // Move on to the next chunk kept by reset(), or open a new one. Requests larger
+    // than the chunk size get a dedicated chunk of their own.
+    while (currentChunk + 1 < chunks.size()) {
+        ++currentChunk;
+        offset = 0;
+        if (void* memory = allocateFromChunk(size, alignment)) {
+            return memory;
+        }
+    }
+
+    std::size_t newChunkSize = std::max(chunkSize, size + alignment);
+    chunks.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[newChunkSize]), newChunkSize});
+    currentChunk = chunks.size() - 1;
+    offset = 0;
+    return allocateFromChunk(size, alignment);
+}
+
+void* ExprArena::allocateFromChunk(std::size_t size, std::size_t alignment) {
+    if (currentChunk >= chunks.size()) {
+        return nullptr;
+    }
+    Chunk& chunk = chunks[currentChunk];
+    std::uintptr_t base = reinterpret_cast<std::uintptr_t>(chunk.memory.get());
+    std::uintptr_t aligned = (base + offset + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+    std::size_t end = static_cast<std::size_t>(aligned - base) + size;
+    if (end > chunk.size) {
+        return nullptr;
+    }
+    bytesUsed += end - offset;
+    offset = end;
+    return reinterpret_cast<void*>(aligned);
+}
+
+void ExprArena::setHashConsing(bool enabled) {
+    hashConsing = enabled;
+}
+
+bool ExprArena::isHashConsing() const {
+    return hashConsing;
+}
+
+void ExprArena::setSymbolicCache(SymbolicCache* cache) {
+    if (cache == symbolicCache) {
+        return;
+    }
+    if (cache && cache->arena) {
+        throw std::runtime_error("SymbolicCache is already attached to another arena.");
+    }
+    if (symbolicCache) {
+        symbolicCache->invalidate();  // Its results live here and would dangle after a reset
+        symbolicCache->arena = nullptr;
+    }
+    symbolicCache = cache;
+    if (cache) {
+        cache->arena = this;
+    }
+}
+
+SymbolicCache* ExprArena::getSymbolicCache() const {
+    return symbolicCache;
+}
+
+void ExprArena::reset() {
+    if (symbolicCache) {
+        symbolicCache->invalidate();
+    }
+    internTable.clear();
+    internHits = 0;
+    runFinalizers();
+    currentChunk = 0;
+    offset = 0;
+    bytesUsed = 0;
+    allocationCount = 0;
+}
+
+void ExprArena::runFinalizers() {
+    for (auto it = finalizers.rbegin(); it != finalizers.rend(); ++it) {
+        it->destroy(it->object);
+    }
+    finalizers.clear();
+}
+
+std::size_t ExprArena::getBytesUsed() const {
+    return bytesUsed;
+}
+
+std::size_t ExprArena::getBytesReserved() const {
+    std::size_t reserved = 0;
+    for (const Chunk& chunk : chunks) {
+        reserved += chunk.size;
+    }
+    return reserved;
+}
+
+std::size_t ExprArena::getChunkCount() const {
+    return chunks.size();
+}
+
+std::size_t ExprArena::getChunkSize() const {
+    return chunkSize;
+}
+
+std::size_t ExprArena::getAllocationCount() const {
+    return allocationCount;
+}
+
+std::size_t ExprArena::getInternHits() const {
+    return internHits;
+}
+
+} // namespace Expression
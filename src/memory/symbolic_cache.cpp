@@ -0,0 +1,103 @@
+#include "memory/symbolic_cache.h"
+#include "memory/expr_arena.h"
+
+namespace Expression {
+
+std::size_t SymbolicCache::KeyHash::operator()(const Key& key) const {
+    std::size_t h = NodeHash()(key.node);
+    if (key.variable) {
+        h ^= std::hash<std::string>()(*key.variable) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    }
+    return h;
+}
+
+bool SymbolicCache::KeyEqual::operator()(const Key& a, const Key& b) const {
+    if ((a.variable == nullptr) != (b.variable == nullptr)) {
+        return false;
+    }
+    if (a.variable && *a.variable != *b.variable) {
+        return false;
+    }
+    return structurallyEqual(a.node, b.node);
+}
+
+SymbolicCache::SymbolicCache(std::size_t capacity) : capacity(capacity) {
+    if (capacity == 0) {
+        throw std::runtime_error("SymbolicCache capacity must be positive.");
+    }
+}
+
+SymbolicCache::~SymbolicCache() {
+    if (arena) {
+        arena->setSymbolicCache(nullptr);
+    }
+}
+
+Node* SymbolicCache::findSimplified(const Node* node) {
+    return find({node, nullptr});
+}
+
+Node* SymbolicCache::findDerivative(const Node* node, const std::string& variable) {
+    return find({node, &variable});
+}
+
+void SymbolicCache::storeSimplified(const Node* node, Node* result) {
+    store(node, nullptr, result);
+}
+
+void SymbolicCache::storeDerivative(const Node* node, const std::string& variable, Node* result) {
+    store(node, &variable, result);
+}
+
+Node* SymbolicCache::find(const Key& key) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        ++stats.misses;
+        return nullptr;
+    }
+    ++stats.hits;
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->result;
+}
+
+void SymbolicCache::store(const Node* node, const std::string* variable, Node* result) {
+    if (index.count({node, variable})) {
+        return;  // A structurally equal subtree was stored while this one was being processed
+    }
+    if (entries.size() == capacity) {
+        const Entry& oldest = entries.back();
+        index.erase({oldest.node, oldest.isDerivative ? &oldest.variable : nullptr});
+        entries.pop_back();
+        ++stats.evictions;
+    }
+    entries.push_front({node, variable ? *variable : std::string(), variable != nullptr, result});
+    const Entry& entry = entries.front();
+    index.emplace(Key{entry.node, entry.isDerivative ? &entry.variable : nullptr}, entries.begin());
+}
+
+void SymbolicCache::invalidate() {
+    index.clear();
+    entries.clear();
+}
+
+ExprArena* SymbolicCache::getArena() const {
+    return arena;
+}
+
+std::size_t SymbolicCache::size() const {
+    return entries.size();
+}
+
+std::size_t SymbolicCache::getCapacity() const {
+    return capacity;
+}
+
+const SymbolicCacheStats& SymbolicCache::getStats() const {
+    return stats;
+}
+
+void SymbolicCache::resetStats() {
+    stats = SymbolicCacheStats();
+}
+
+} // namespace Expression
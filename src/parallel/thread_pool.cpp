@@ -0,0 +1,155 @@
+#include "parallel/thread_pool.h"
+
+#include <limits>
+
+namespace Expression {
+
+namespace {
+
+constexpr std::size_t kNoFailure = std::numeric_limits<std::size_t>::max();
+
+} // namespace
+
+ThreadPool::ThreadPool(std::size_t threads) : threadCount(threads) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    queues.reset(new WorkQueue[threadCount]);
+    for (std::size_t worker = 1; worker < threadCount; ++worker) {
+        this->threads.emplace_back([this, worker] { workerLoop(worker); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+std::size_t ThreadPool::getThreadCount() const {
+    return threadCount;
+}
+
+std::uint64_t ThreadPool::getStealCount() const {
+    return steals.load(std::memory_order_relaxed);
+}
+
+void ThreadPool::parallelFor(std::size_t taskCount, const std::function<void(std::size_t, std::size_t)>& loopBody) {
+    if (taskCount == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> submit(submitMutex);
+    error = nullptr;
+    failedTask.store(kNoFailure, std::memory_order_relaxed);
+    for (std::size_t worker = 0; worker < threadCount; ++worker) {
+        std::lock_guard<std::mutex> lock(queues[worker].mutex);
+        queues[worker].begin = taskCount * worker / threadCount;
+        queues[worker].end = taskCount * (worker + 1) / threadCount;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        body = &loopBody;
+        busyWorkers = threadCount - 1;
+        ++generation;
+    }
+    wake.notify_all();
+    drain(0);
+    {
+        // Wait for every worker, not just for the tasks: a worker still looking for work
+        // must not see the queues of the next loop.
+        std::unique_lock<std::mutex> lock(stateMutex);
+        finished.wait(lock, [this] { return busyWorkers == 0; });
+        body = nullptr;
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// **Workers**
+void ThreadPool::workerLoop(std::size_t worker) {
+    std::uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+        drain(worker);
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (--busyWorkers == 0) {
+                finished.notify_one();
+            }
+        }
+    }
+}
+
+void ThreadPool::drain(std::size_t worker) {
+    std::size_t task;
+    while (popOwn(worker, task) || steal(worker, task)) {
+        runTask(task, worker);
+    }
+}
+
+bool ThreadPool::popOwn(std::size_t worker, std::size_t& task) {
+    WorkQueue& queue = queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.begin == queue.end) {
+        return false;
+    }
+    task = queue.begin++;
+    return true;
+}
+
+// Take the back half of the first non-empty range after this worker's own; run its first
+// task now and keep the rest as this worker's range.
+bool ThreadPool::steal(std::size_t worker, std::size_t& task) {
+    for (std::size_t offset = 1; offset < threadCount; ++offset) {
+        WorkQueue& victim = queues[(worker + offset) % threadCount];
+        std::size_t begin, end;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.begin == victim.end) {
+                continue;
+            }
+            begin = victim.begin + (victim.end - victim.begin) / 2;
+            end = victim.end;
+            victim.end = begin;
+        }
+        steals.fetch_add(1, std::memory_order_relaxed);
+        WorkQueue& own = queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.begin = begin + 1;
+        own.end = end;
+        task = begin;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::runTask(std::size_t task, std::size_t worker) {
+    if (task > failedTask.load(std::memory_order_relaxed)) {
+        return;  // An earlier task already failed; its error is the one reported
+    }
+    try {
+        (*body)(task, worker);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (task < failedTask.load(std::memory_order_relaxed)) {
+            failedTask.store(task, std::memory_order_relaxed);
+            error = std::current_exception();
+        }
+    }
+}
+
+} // namespace Expression
@@ -0,0 +1,26 @@
+#include "parser/function_registry.h"
+
+namespace Expression {
+
+void FunctionRegistry::add(const std::string& name, int argCount, FunctionNode::FunctionCallback callback,
+                           FunctionNode::DerivativeCallback derivative) {
+    if (name == "sin" || name == "cos" || name == "ln" || name == "log") {
+        throw std::runtime_error("Cannot register built-in function " + name + ".");
+    }
+    if (argCount < 0) {
+        throw std::runtime_error("Function " + name + " must take a non-negative number of arguments.");
+    }
+    definitions[name] = {argCount, std::make_shared<const FunctionNode::Callbacks>(
+        FunctionNode::Callbacks{std::move(callback), std::move(derivative)})};
+}
+
+const FunctionDefinition* FunctionRegistry::find(std::string_view name) const {
+    auto it = definitions.find(name);
+    return it != definitions.end() ? &it->second : nullptr;
+}
+
+std::size_t FunctionRegistry::size() const {
+    return definitions.size();
+}
+
+} // namespace Expression
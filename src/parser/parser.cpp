@@ -0,0 +1,234 @@
+#include "parser/parser.h"
+
+namespace Expression {
+
+namespace {
+
+// Binding strength of each binary operator; 0 for tokens that do not continue an expression.
+constexpr int kEqualityPrecedence = 1;
+constexpr int kSumPrecedence = 2;
+constexpr int kProductPrecedence = 3;
+
+bool isNameStart(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+} // namespace
+
+ParseError::ParseError(const std::string& message, std::size_t position)
+    : std::runtime_error("Parse error at position " + std::to_string(position) + ": " + message),
+      position(position) {}
+
+std::size_t ParseError::getPosition() const {
+    return position;
+}
+
+Parser::Parser(ExprArena& arena, const FunctionRegistry* functions) : e(arena), functions(functions) {}
+
+Node* Parser::parse(std::string_view text) {
+    input = text;
+    cursor = 0;
+    argumentStack.clear();
+    advance();
+    Node* root = parseExpression(kEqualityPrecedence);
+    if (current.kind != TokenKind::End) {
+        fail("unexpected '" + std::string(current.text) + "' after the expression", current.position);
+    }
+    return root;
+}
+
+// **Lexer: one token of lookahead, scanned straight from the input**
+void Parser::advance() {
+    while (cursor < input.size() && std::isspace(static_cast<unsigned char>(input[cursor]))) {
+        ++cursor;
+    }
+    const std::size_t start = cursor;
+    if (cursor == input.size()) {
+        current = {TokenKind::End, start, {}, 0};
+        return;
+    }
+
+    const char c = input[cursor];
+    if (isDigit(c) || (c == '.' && cursor + 1 < input.size() && isDigit(input[cursor + 1]))) {
+        double value = 0;
+        auto [end, ec] = std::from_chars(input.data() + cursor, input.data() + input.size(), value);
+        if (ec == std::errc::result_out_of_range) {
+            fail("number out of range", start);
+        }
+        if (ec != std::errc()) {
+            fail("invalid number", start);
+        }
+        cursor = static_cast<std::size_t>(end - input.data());
+        current = {TokenKind::Number, start, input.substr(start, cursor - start), value};
+        return;
+    }
+    if (isNameStart(c)) {
+        while (cursor < input.size() && (isNameStart(input[cursor]) || isDigit(input[cursor]))) {
+            ++cursor;
+        }
+        current = {TokenKind::Name, start, input.substr(start, cursor - start), 0};
+        return;
+    }
+
+    TokenKind kind;
+    switch (c) {
+    case '+': kind = TokenKind::Plus; break;
+    case '-': kind = TokenKind::Minus; break;
+    case '*': kind = TokenKind::Star; break;
+    case '/': kind = TokenKind::Slash; break;
+    case '^': kind = TokenKind::Caret; break;
+    case '(': kind = TokenKind::LeftParen; break;
+    case ')': kind = TokenKind::RightParen; break;
+    case ',': kind = TokenKind::Comma; break;
+    case '=':
+        if (cursor + 1 < input.size() && input[cursor + 1] == '=') {
+            cursor += 2;
+            current = {TokenKind::EqualEqual, start, input.substr(start, 2), 0};
+            return;
+        }
+        fail("unexpected '=', equality is written '=='", start);
+    default:
+        fail(std::string("unexpected character '") + c + "'", start);
+    }
+    ++cursor;
+    current = {kind, start, input.substr(start, 1), 0};
+}
+
+void Parser::expect(TokenKind kind, const char* what) {
+    if (current.kind != kind) {
+        if (current.kind == TokenKind::End) {
+            fail(std::string("expected ") + what + " but reached the end of the input", current.position);
+        }
+        fail(std::string("expected ") + what + ", found '" + std::string(current.text) + "'", current.position);
+    }
+    advance();
+}
+
+void Parser::fail(const std::string& message, std::size_t position) const {
+    throw ParseError(message, position);
+}
+
+// **Grammar**
+Node* Parser::parseExpression(int minPrecedence) {
+    Node* lhs = parseUnary();
+    while (true) {
+        int precedence = 0;
+        switch (current.kind) {
+        case TokenKind::EqualEqual: precedence = kEqualityPrecedence; break;
+        case TokenKind::Plus:
+        case TokenKind::Minus: precedence = kSumPrecedence; break;
+        case TokenKind::Star:
+        case TokenKind::Slash: precedence = kProductPrecedence; break;
+        default: break;
+        }
+        if (precedence == 0 || precedence < minPrecedence) {
+            return lhs;
+        }
+        const TokenKind op = current.kind;
+        advance();
+        Node* rhs = parseExpression(precedence + 1);  // Left-associative
+        switch (op) {
+        case TokenKind::EqualEqual: lhs = e.eq(lhs, rhs); break;
+        case TokenKind::Plus: lhs = e.add(lhs, rhs); break;
+        case TokenKind::Minus: lhs = e.sub(lhs, rhs); break;
+        case TokenKind::Star: lhs = e.mul(lhs, rhs); break;
+        default: lhs = e.div(lhs, rhs); break;
+        }
+    }
+}
+
+Node* Parser::parseUnary() {
+    if (current.kind == TokenKind::Minus) {
+        advance();
+        Node* operand = parseUnary();
+        if (const NumberNode* num = operand->as<NumberNode>()) {
+            return e.num(-num->getValue());
+        }
+        return e.mul(e.num(-1), operand);
+    }
+    if (current.kind == TokenKind::Plus) {
+        advance();
+        return parseUnary();
+    }
+    Node* base = parsePrimary();
+    if (current.kind == TokenKind::Caret) {
+        advance();
+        return e.exp(base, parseUnary());  // Right-associative
+    }
+    return base;
+}
+
+Node* Parser::parsePrimary() {
+    const Token token = current;
+    switch (token.kind) {
+    case TokenKind::Number:
+        advance();
+        return e.num(token.value);
+    case TokenKind::Name:
+        advance();
+        if (current.kind == TokenKind::LeftParen) {
+            return parseCall(token);
+        }
+        return e.var(std::string(token.text));
+    case TokenKind::LeftParen: {
+        advance();
+        Node* inner = parseExpression(kEqualityPrecedence);
+        expect(TokenKind::RightParen, "')'");
+        return inner;
+    }
+    case TokenKind::End:
+        fail("expected an expression but reached the end of the input", token.position);
+    default:
+        fail("expected an expression, found '" + std::string(token.text) + "'", token.position);
+    }
+}
+
+Node* Parser::parseCall(const Token& name) {
+    advance();  // '('
+    const std::size_t first = argumentStack.size();
+    if (current.kind != TokenKind::RightParen) {
+        while (true) {
+            Node* argument = parseExpression(kEqualityPrecedence);
+            argumentStack.push_back(argument);
+            if (current.kind != TokenKind::Comma) {
+                break;
+            }
+            advance();
+        }
+    }
+    expect(TokenKind::RightParen, "')' or ','");
+    const std::size_t count = argumentStack.size() - first;
+    Node** args = argumentStack.data() + first;
+
+    auto checkCount = [&](std::size_t expected) {
+        if (count != expected) {
+            fail(std::string(name.text) + " expects " + std::to_string(expected) + " argument" +
+                 (expected == 1 ? "" : "s") + ", got " + std::to_string(count), name.position);
+        }
+    };
+
+    Node* call;
+    if (name.text == "sin" || name.text == "cos" || name.text == "ln") {
+        checkCount(1);
+        call = name.text == "sin" ? e.sin(args[0]) : name.text == "cos" ? e.cos(args[0]) : e.ln(args[0]);
+    } else if (name.text == "log") {
+        checkCount(2);
+        call = e.log(args[0], args[1]);
+    } else {
+        const FunctionDefinition* definition = functions ? functions->find(name.text) : nullptr;
+        if (!definition) {
+            fail("unknown function '" + std::string(name.text) + "'", name.position);
+        }
+        checkCount(static_cast<std::size_t>(definition->argCount));
+        call = e.func(std::string(name.text), definition->argCount, std::vector<Node*>(args, args + count),
+                      definition->callbacks);
+    }
+    argumentStack.resize(first);
+    return call;
+}
+
+} // namespace Expression
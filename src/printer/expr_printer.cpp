@@ -0,0 +1,154 @@
+#include "printer/expr_printer.h"
+#include "expression/number_node.h"
+#include "expression/variable_node.h"
+#include "expression/binary_op_node.h"
+#include "expression/unary_op_node.h"
+#include "expression/equality_node.h"
+#include "expression/function_node.h"
+
+namespace Expression {
+
+namespace {
+
+// Binding strength as the parser sees it; leaves and calls never need parentheses.
+constexpr int kPowerPrecedence = 4;
+constexpr int kAtomPrecedence = 5;
+
+int precedenceOf(const Node* node) {
+    switch (node->getKind()) {
+    case NodeKind::Equality: return 1;
+    case NodeKind::Addition:
+    case NodeKind::Subtraction: return 2;
+    case NodeKind::Multiplication:
+    case NodeKind::Division: return 3;
+    case NodeKind::Exponentiation: return kPowerPrecedence;
+    default: return kAtomPrecedence;
+    }
+}
+
+const char* operatorOf(NodeKind kind) {
+    switch (kind) {
+    case NodeKind::Addition: return " + ";
+    case NodeKind::Subtraction: return " - ";
+    case NodeKind::Multiplication: return " * ";
+    case NodeKind::Division: return " / ";
+    case NodeKind::Exponentiation: return " ^ ";
+    default: return " == ";
+    }
+}
+
+} // namespace
+
+ExprPrinter::ExprPrinter(PrintOptions options) : options(options) {}
+
+std::string_view ExprPrinter::print(const Node* root) {
+    buffer.clear();
+    write(root, buffer);
+    return buffer;
+}
+
+void ExprPrinter::append(const Node* root, std::string& out) const {
+    write(root, out);
+}
+
+std::string ExprPrinter::toString(const Node* root, PrintOptions options) {
+    std::string out;
+    ExprPrinter(options).write(root, out);
+    return out;
+}
+
+void ExprPrinter::appendNumber(double value, int precision, std::string& out) {
+    char digits[64];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::general, precision);
+    out.append(digits, result.ptr);
+}
+
+// **Recursive writer**
+void ExprPrinter::write(const Node* node, std::string& out) const {
+    switch (node->getKind()) {
+    case NodeKind::Number:
+        appendNumber(static_cast<const NumberNode*>(node)->getValue(), options.precision, out);
+        return;
+    case NodeKind::Variable:
+        out += static_cast<const VariableNode*>(node)->getName();
+        return;
+    case NodeKind::Sin:
+    case NodeKind::Cos:
+    case NodeKind::Ln:
+        out += node->getKind() == NodeKind::Sin ? "sin(" : node->getKind() == NodeKind::Cos ? "cos(" : "ln(";
+        write(static_cast<const UnaryOpNode*>(node)->getOperand(), out);
+        out += ')';
+        return;
+    case NodeKind::Log: {
+        auto logNode = static_cast<const BinaryOpNode*>(node);
+        out += "log(";
+        write(logNode->getLeft(), out);
+        out += ", ";
+        write(logNode->getRight(), out);
+        out += ')';
+        return;
+    }
+    case NodeKind::Function: {
+        auto funcNode = static_cast<const FunctionNode*>(node);
+        out += funcNode->getName();
+        out += '(';
+        const std::vector<Node*>& args = funcNode->getArguments();
+        for (std::size_t i = 0; i < args.size(); ++i) {
+            if (i > 0) {
+                out += ", ";
+            }
+            write(args[i], out);
+        }
+        out += ')';
+        return;
+    }
+    default:
+        break;
+    }
+
+    const Node* left;
+    const Node* right;
+    if (auto eqNode = node->as<EqualityNode>()) {
+        left = eqNode->getLeft();
+        right = eqNode->getRight();
+    } else {
+        left = static_cast<const BinaryOpNode*>(node)->getLeft();
+        right = static_cast<const BinaryOpNode*>(node)->getRight();
+    }
+
+    if (!options.minimalParentheses) {
+        out += '(';
+        write(left, out);
+        out += operatorOf(node->getKind());
+        write(right, out);
+        out += ')';
+        return;
+    }
+
+    // '^' is right-associative; every other operator is left-associative.
+    const int precedence = precedenceOf(node);
+    const bool power = node->getKind() == NodeKind::Exponentiation;
+    writeOperand(left, precedence, power, out);
+    out += operatorOf(node->getKind());
+    writeOperand(right, precedence, !power, out);
+}
+
+void ExprPrinter::writeOperand(const Node* operand, int parentPrecedence, bool parenthesizeEqual,
+                               std::string& out) const {
+    const int precedence = precedenceOf(operand);
+    bool parenthesize = precedence < parentPrecedence || (precedence == parentPrecedence && parenthesizeEqual);
+    // A negative base: "-2 ^ x" would parse as -(2 ^ x).
+    const NumberNode* num = operand->as<NumberNode>();
+    if (num && std::signbit(num->getValue()) && parentPrecedence == kPowerPrecedence && parenthesizeEqual) {
+        parenthesize = true;
+    }
+    if (parenthesize) {
+        out += '(';
+        write(operand, out);
+        out += ')';
+    } else {
+        write(operand, out);
+    }
+}
+
+} // namespace Expression
@@ -0,0 +1,120 @@
+#include "rewrite/rewriter.h"
+#include "tracing/trace.h"
+
+namespace Expression {
+
+Rewriter::Rewriter(const RuleRegistry& rules, ExprArena& arena, RewriteOptions options)
+    : rules(rules), e(arena), options(options) {}
+
+Node* Rewriter::rewrite(const Node* root) {
+    steps = 0;
+    rewritten.clear();  // Keys of a previous call may point into a source arena reset since
+    return normalize(root);
+}
+
+// **Fixpoint normalization**
+Node* Rewriter::normalize(const Node* node) {
+    if (options.cacheNormalForms) {
+        auto known = rewritten.find(node);
+        if (known != rewritten.end()) {
+            ++stats.cacheHits;
+            return known->second;
+        }
+        auto normal = normalForms.find(node);
+        if (normal != normalForms.end()) {
+            ++stats.cacheHits;
+            return const_cast<Node*>(*normal);
+        }
+    }
+
+    Node* current = rebuild(node);
+    if (options.cacheNormalForms && current != node) {
+        auto normal = normalForms.find(current);
+        if (normal != normalForms.end()) {
+            ++stats.cacheHits;
+            rewritten.emplace(node, const_cast<Node*>(*normal));
+            return const_cast<Node*>(*normal);
+        }
+    }
+
+    ++stats.nodesVisited;
+    Node* result = current;
+    if (Node* next = applyFirst(current)) {
+        result = normalize(next);
+    }
+
+    if (options.cacheNormalForms) {
+        normalForms.insert(result);
+        rewritten.emplace(node, result);
+    }
+    return result;
+}
+
+// The same operator over normalized children, built in the target arena.
+Node* Rewriter::rebuild(const Node* node) {
+    switch (node->getKind()) {
+    case NodeKind::Number:
+        return e.num(static_cast<const NumberNode*>(node)->getValue());
+    case NodeKind::Variable:
+        return e.var(static_cast<const VariableNode*>(node)->getName());
+    case NodeKind::Sin:
+    case NodeKind::Cos:
+    case NodeKind::Ln:
+        return e.build(node->getKind(), normalize(static_cast<const UnaryOpNode*>(node)->getOperand()));
+    case NodeKind::Equality: {
+        auto eqNode = static_cast<const EqualityNode*>(node);
+        Node* left = normalize(eqNode->getLeft());
+        return e.eq(left, normalize(eqNode->getRight()));
+    }
+    case NodeKind::Function: {
+        auto funcNode = static_cast<const FunctionNode*>(node);
+        std::vector<Node*> args;
+        for (Node* arg : funcNode->getArguments()) {
+            args.push_back(normalize(arg));
+        }
+        return e.func(funcNode->getName(), funcNode->getExpectedArgCount(), args, funcNode->getCallbacks());
+    }
+    default: {
+        auto binaryNode = static_cast<const BinaryOpNode*>(node);
+        Node* left = normalize(binaryNode->getLeft());
+        return e.build(node->getKind(), left, normalize(binaryNode->getRight()));
+    }
+    }
+}
+
+// Result of the first rule that rewrites the node, or nullptr when it is in normal form.
+Node* Rewriter::applyFirst(Node* node) {
+    const std::vector<RewriteRule>& candidates =
+        options.indexByKind ? rules.rulesFor(node->getKind()) : rules.getRules();
+    for (const RewriteRule& rule : candidates) {
+        ++stats.rulesTried;
+        if (rule.root != node->getKind()) {
+            continue;
+        }
+        Node* next = rule.apply(node, e);
+        if (!next || next == node) {
+            continue;
+        }
+        ++stats.rulesApplied;
+        if (++steps > options.maxSteps) {
+            throw std::runtime_error("Rewrite did not reach a fixpoint within " +
+                                     std::to_string(options.maxSteps) + " rule applications.");
+        }
+        if (Trace::enabled(TraceLevel::Summary)) {
+            Trace::addTransformation("Rewrite rule: " + rule.name, node, next);
+        }
+        return next;
+    }
+    return nullptr;
+}
+
+const RewriteStats& Rewriter::getStats() const {
+    return stats;
+}
+
+void Rewriter::clearCache() {
+    normalForms.clear();
+    rewritten.clear();
+}
+
+} // namespace Expression
@@ -0,0 +1,23 @@
+#include "rewrite/rule_registry.h"
+
+namespace Expression {
+
+void RuleRegistry::add(const std::string& name, NodeKind root, RewriteRule::Apply apply) {
+    RewriteRule rule{name, root, std::move(apply)};
+    byKind[static_cast<std::size_t>(root)].push_back(rule);
+    rules.push_back(std::move(rule));
+}
+
+const std::vector<RewriteRule>& RuleRegistry::rulesFor(NodeKind kind) const {
+    return byKind[static_cast<std::size_t>(kind)];
+}
+
+const std::vector<RewriteRule>& RuleRegistry::getRules() const {
+    return rules;
+}
+
+std::size_t RuleRegistry::size() const {
+    return rules.size();
+}
+
+} // namespace Expression
@@ -0,0 +1,280 @@
+#include "rewrite/rule_registry.h"
+
+namespace Expression {
+
+namespace {
+
+// **Matching helpers**
+const NumberNode* number(const Node* node) {
+    return node->as<NumberNode>();
+}
+
+bool isValue(const Node* node, double value) {
+    const NumberNode* num = number(node);
+    return num && num->getValue() == value;
+}
+
+Node* leftOf(const Node* node) {
+    return static_cast<const BinaryOpNode*>(node)->getLeft();
+}
+
+Node* rightOf(const Node* node) {
+    return static_cast<const BinaryOpNode*>(node)->getRight();
+}
+
+// A term c * base, where a bare base has the coefficient 1. Constants are not terms.
+struct Term {
+    double coefficient;
+    Node* base;
+};
+
+bool asTerm(Node* node, Term& term) {
+    if (number(node)) {
+        return false;
+    }
+    if (node->is<MultiplicationNode>()) {
+        if (const NumberNode* coefficient = number(leftOf(node))) {
+            term = {coefficient->getValue(), rightOf(node)};
+            return true;
+        }
+    }
+    term = {1, node};
+    return true;
+}
+
+// base ^ exponent with a numeric exponent, where a bare base has the exponent 1.
+struct Power {
+    Node* base;
+    double exponent;
+};
+
+bool asPower(Node* node, Power& power) {
+    if (number(node)) {
+        return false;
+    }
+    if (node->is<ExponentiationNode>()) {
+        if (const NumberNode* exponent = number(rightOf(node))) {
+            power = {leftOf(node), exponent->getValue()};
+            return true;
+        }
+    }
+    power = {node, 1};
+    return true;
+}
+
+bool isPositiveInteger(double value) {
+    return value >= 1 && value == std::floor(value);
+}
+
+void addAdditionRules(RuleRegistry& registry) {
+    registry.add("fold constants", NodeKind::Addition, [](Node* node, ExprHelper& e) -> Node* {
+        const NumberNode* a = number(leftOf(node));
+        const NumberNode* b = number(rightOf(node));
+        return a && b ? e.num(a->getValue() + b->getValue()) : nullptr;
+    });
+    registry.add("x + 0 = x", NodeKind::Addition, [](Node* node, ExprHelper&) -> Node* {
+        return isValue(rightOf(node), 0) ? leftOf(node) : nullptr;
+    });
+    registry.add("0 + x = x", NodeKind::Addition, [](Node* node, ExprHelper&) -> Node* {
+        return isValue(leftOf(node), 0) ? rightOf(node) : nullptr;
+    });
+    registry.add("constant first", NodeKind::Addition, [](Node* node, ExprHelper& e) -> Node* {
+        return number(rightOf(node)) ? e.add(rightOf(node), leftOf(node)) : nullptr;
+    });
+    // c1 + (c2 + x) = (c1 + c2) + x
+    registry.add("combine constants", NodeKind::Addition, [](Node* node, ExprHelper& e) -> Node* {
+        const NumberNode* a = number(leftOf(node));
+        Node* right = rightOf(node);
+        if (!a || !right->is<AdditionNode>()) {
+            return nullptr;
+        }
+        const NumberNode* b = number(leftOf(right));
+        return b ? e.add(e.num(a->getValue() + b->getValue()), rightOf(right)) : nullptr;
+    });
+    // (c + x) + y = c + (x + y) and x + (c + y) = c + (x + y)
+    registry.add("hoist constant", NodeKind::Addition, [](Node* node, ExprHelper& e) -> Node* {
+        Node* left = leftOf(node);
+        Node* right = rightOf(node);
+        if (number(left)) {
+            return nullptr;
+        }
+        if (left->is<AdditionNode>() && number(leftOf(left))) {
+            return e.add(leftOf(left), e.add(rightOf(left), right));
+        }
+        if (right->is<AdditionNode>() && number(leftOf(right))) {
+            return e.add(leftOf(right), e.add(left, rightOf(right)));
+        }
+        return nullptr;
+    });
+    // a*x + b*x = (a + b)*x
+    registry.add("collect like terms", NodeKind::Addition, [](Node* node, ExprHelper& e) -> Node* {
+        Term a, b;
+        if (!asTerm(leftOf(node), a) || !asTerm(rightOf(node), b) || !structurallyEqual(a.base, b.base)) {
+            return nullptr;
+        }
+        return e.mul(e.num(a.coefficient + b.coefficient), a.base);
+    });
+    // (y + a*x) + b*x = y + (a + b)*x and (a*x + y) + b*x = (a + b)*x + y
+    registry.add("collect like terms across a sum", NodeKind::Addition, [](Node* node, ExprHelper& e) -> Node* {
+        Node* left = leftOf(node);
+        Term b;
+        if (!left->is<AdditionNode>() || !asTerm(rightOf(node), b)) {
+            return nullptr;
+        }
+        Term a;
+        if (asTerm(rightOf(left), a) && structurallyEqual(a.base, b.base)) {
+            return e.add(leftOf(left), e.mul(e.num(a.coefficient + b.coefficient), b.base));
+        }
+        if (asTerm(leftOf(left), a) && structurallyEqual(a.base, b.base)) {
+            return e.add(e.mul(e.num(a.coefficient + b.coefficient), b.base), rightOf(left));
+        }
+        return nullptr;
+    });
+}
+
+void addSubtractionRules(RuleRegistry& registry) {
+    registry.add("fold constants", NodeKind::Subtraction, [](Node* node, ExprHelper& e) -> Node* {
+        const NumberNode* a = number(leftOf(node));
+        const NumberNode* b = number(rightOf(node));
+        return a && b ? e.num(a->getValue() - b->getValue()) : nullptr;
+    });
+    registry.add("x - 0 = x", NodeKind::Subtraction, [](Node* node, ExprHelper&) -> Node* {
+        return isValue(rightOf(node), 0) ? leftOf(node) : nullptr;
+    });
+    // a*x - b*x = (a - b)*x, which covers x - x = 0 once the product folds
+    registry.add("collect like terms", NodeKind::Subtraction, [](Node* node, ExprHelper& e) -> Node* {
+        Term a, b;
+        if (!asTerm(leftOf(node), a) || !asTerm(rightOf(node), b) || !structurallyEqual(a.base, b.base)) {
+            return nullptr;
+        }
+        return e.mul(e.num(a.coefficient - b.coefficient), a.base);
+    });
+}
+
+void addMultiplicationRules(RuleRegistry& registry) {
+    registry.add("fold constants", NodeKind::Multiplication, [](Node* node, ExprHelper& e) -> Node* {
+        const NumberNode* a = number(leftOf(node));
+        const NumberNode* b = number(rightOf(node));
+        return a && b ? e.num(a->getValue() * b->getValue()) : nullptr;
+    });
+    registry.add("x * 0 = 0", NodeKind::Multiplication, [](Node* node, ExprHelper& e) -> Node* {
+        return isValue(leftOf(node), 0) || isValue(rightOf(node), 0) ? e.num(0) : nullptr;
+    });
+    registry.add("x * 1 = x", NodeKind::Multiplication, [](Node* node, ExprHelper&) -> Node* {
+        return isValue(rightOf(node), 1) ? leftOf(node) : nullptr;
+    });
+    registry.add("1 * x = x", NodeKind::Multiplication, [](Node* node, ExprHelper&) -> Node* {
+        return isValue(leftOf(node), 1) ? rightOf(node) : nullptr;
+    });
+    registry.add("constant first", NodeKind::Multiplication, [](Node* node, ExprHelper& e) -> Node* {
+        return number(rightOf(node)) ? e.mul(rightOf(node), leftOf(node)) : nullptr;
+    });
+    // c1 * (c2 * x) = (c1 * c2) * x
+    registry.add("combine constants", NodeKind::Multiplication, [](Node* node, ExprHelper& e) -> Node* {
+        const NumberNode* a = number(leftOf(node));
+        Node* right = rightOf(node);
+        if (!a || !right->is<MultiplicationNode>()) {
+            return nullptr;
+        }
+        const NumberNode* b = number(leftOf(right));
+        return b ? e.mul(e.num(a->getValue() * b->getValue()), rightOf(right)) : nullptr;
+    });
+    // (c * x) * y = c * (x * y) and x * (c * y) = c * (x * y)
+    registry.add("hoist constant", NodeKind::Multiplication, [](Node* node, ExprHelper& e) -> Node* {
+        Node* left = leftOf(node);
+        Node* right = rightOf(node);
+        if (number(left)) {
+            return nullptr;
+        }
+        if (left->is<MultiplicationNode>() && number(leftOf(left))) {
+            return e.mul(leftOf(left), e.mul(rightOf(left), right));
+        }
+        if (right->is<MultiplicationNode>() && number(leftOf(right))) {
+            return e.mul(leftOf(right), e.mul(left, rightOf(right)));
+        }
+        return nullptr;
+    });
+    // x^a * x^b = x^(a + b) for positive integers a and b, including x * x = x^2. Other
+    // exponents would drop errors: x * x^-1 throws at x = 0 and x^0.5 * x^0.5 is NaN for
+    // x < 0, while x^0 and x are defined there.
+    registry.add("merge powers", NodeKind::Multiplication, [](Node* node, ExprHelper& e) -> Node* {
+        Power a, b;
+        if (!asPower(leftOf(node), a) || !asPower(rightOf(node), b) || !isPositiveInteger(a.exponent) ||
+            !isPositiveInteger(b.exponent) || !structurallyEqual(a.base, b.base)) {
+            return nullptr;
+        }
+        return e.exp(a.base, e.num(a.exponent + b.exponent));
+    });
+}
+
+void addDivisionRules(RuleRegistry& registry) {
+    registry.add("fold constants", NodeKind::Division, [](Node* node, ExprHelper& e) -> Node* {
+        const NumberNode* a = number(leftOf(node));
+        const NumberNode* b = number(rightOf(node));
+        if (!a || !b) {
+            return nullptr;
+        }
+        if (b->getValue() == 0) {
+            throw std::runtime_error("Attempted division by zero in simplification.");
+        }
+        return e.num(a->getValue() / b->getValue());
+    });
+    registry.add("x / 1 = x", NodeKind::Division, [](Node* node, ExprHelper&) -> Node* {
+        return isValue(rightOf(node), 1) ? leftOf(node) : nullptr;
+    });
+    registry.add("0 / x = 0", NodeKind::Division, [](Node* node, ExprHelper& e) -> Node* {
+        return isValue(leftOf(node), 0) ? e.num(0) : nullptr;
+    });
+}
+
+void addExponentiationRules(RuleRegistry& registry) {
+    registry.add("x ^ 0 = 1", NodeKind::Exponentiation, [](Node* node, ExprHelper& e) -> Node* {
+        return isValue(rightOf(node), 0) ? e.num(1) : nullptr;
+    });
+    registry.add("x ^ 1 = x", NodeKind::Exponentiation, [](Node* node, ExprHelper&) -> Node* {
+        return isValue(rightOf(node), 1) ? leftOf(node) : nullptr;
+    });
+    registry.add("0 ^ x = 0", NodeKind::Exponentiation, [](Node* node, ExprHelper& e) -> Node* {
+        return isValue(leftOf(node), 0) ? e.num(0) : nullptr;
+    });
+    registry.add("1 ^ x = 1", NodeKind::Exponentiation, [](Node* node, ExprHelper& e) -> Node* {
+        return isValue(leftOf(node), 1) ? e.num(1) : nullptr;
+    });
+}
+
+void addFunctionRules(RuleRegistry& registry) {
+    registry.add("ln(1) = 0", NodeKind::Ln, [](Node* node, ExprHelper& e) -> Node* {
+        return isValue(static_cast<UnaryOpNode*>(node)->getOperand(), 1) ? e.num(0) : nullptr;
+    });
+    registry.add("sin(0) = 0", NodeKind::Sin, [](Node* node, ExprHelper& e) -> Node* {
+        return isValue(static_cast<UnaryOpNode*>(node)->getOperand(), 0) ? e.num(0) : nullptr;
+    });
+    registry.add("cos(0) = 1", NodeKind::Cos, [](Node* node, ExprHelper& e) -> Node* {
+        return isValue(static_cast<UnaryOpNode*>(node)->getOperand(), 0) ? e.num(1) : nullptr;
+    });
+    registry.add("log_b(b) = 1", NodeKind::Log, [](Node* node, ExprHelper& e) -> Node* {
+        return structurallyEqual(leftOf(node), rightOf(node)) ? e.num(1) : nullptr;
+    });
+    registry.add("log_b(1) = 0", NodeKind::Log, [](Node* node, ExprHelper& e) -> Node* {
+        return isValue(rightOf(node), 1) ? e.num(0) : nullptr;
+    });
+    registry.add("x = x is true", NodeKind::Equality, [](Node* node, ExprHelper& e) -> Node* {
+        auto eqNode = static_cast<EqualityNode*>(node);
+        return structurallyEqual(eqNode->getLeft(), eqNode->getRight()) ? e.num(1) : nullptr;
+    });
+}
+
+} // namespace
+
+RuleRegistry makeStandardRules() {
+    RuleRegistry registry;
+    addAdditionRules(registry);
+    addSubtractionRules(registry);
+    addMultiplicationRules(registry);
+    addDivisionRules(registry);
+    addExponentiationRules(registry);
+    addFunctionRules(registry);
+    return registry;
+}
+
+} // namespace Expression
@@ -0,0 +1,406 @@
+#include "serialize/expr_library.h"
+#include "helpers/expr_helper.h"
+
+#include <cerrno>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Expression {
+
+namespace {
+
+// Value stacks up to this size live on the C++ stack; larger ones use the heap.
+constexpr std::size_t kInlineStackSize = 64;
+
+bool sectionFits(std::uint64_t offset, std::uint64_t count, std::uint64_t elementSize, std::uint64_t fileSize) {
+    return offset % alignof(double) == 0 && offset <= fileSize && count <= (fileSize - offset) / elementSize;
+}
+
+} // namespace
+
+// **Opening**
+ExprLibrary ExprLibrary::open(const std::string& path, const FunctionRegistry* functions) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open formula library " + path + ": " + std::strerror(errno));
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot map formula library " + path + ": empty or unreadable file.");
+    }
+    const std::size_t size = static_cast<std::size_t>(info.st_size);
+    void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // The mapping keeps the file alive
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("Cannot map formula library " + path + ": " + std::strerror(errno));
+    }
+
+    ExprLibrary library;
+    library.mapping = mapped;
+    library.mappingSize = size;
+    library.attach(mapped, size, functions);  // On failure the destructor unmaps
+    return library;
+}
+
+ExprLibrary::ExprLibrary(const void* data, std::size_t size, const FunctionRegistry* functions) {
+    attach(data, size, functions);
+}
+
+ExprLibrary::ExprLibrary(ExprLibrary&& other) noexcept {
+    *this = std::move(other);
+}
+
+ExprLibrary& ExprLibrary::operator=(ExprLibrary&& other) noexcept {
+    if (this != &other) {
+        release();
+        mapping = std::exchange(other.mapping, nullptr);
+        mappingSize = std::exchange(other.mappingSize, 0);
+        base = std::exchange(other.base, nullptr);
+        header = std::exchange(other.header, nullptr);
+        formulas = std::exchange(other.formulas, nullptr);
+        records = std::exchange(other.records, nullptr);
+        constants = std::exchange(other.constants, nullptr);
+        symbols = std::exchange(other.symbols, nullptr);
+        this->functions = std::exchange(other.functions, nullptr);
+        strings = std::exchange(other.strings, nullptr);
+        resolved = std::move(other.resolved);
+    }
+    return *this;
+}
+
+ExprLibrary::~ExprLibrary() {
+    release();
+}
+
+void ExprLibrary::release() {
+    if (mapping) {
+        ::munmap(mapping, mappingSize);
+        mapping = nullptr;
+        mappingSize = 0;
+    }
+}
+
+// Check the header and section bounds; the records themselves are checked as they are read.
+void ExprLibrary::attach(const void* data, std::size_t size, const FunctionRegistry* registry) {
+    base = static_cast<const char*>(data);
+    if (reinterpret_cast<std::uintptr_t>(base) % alignof(double) != 0) {
+        throw std::runtime_error("Formula library data must be 8-byte aligned.");
+    }
+    if (size < sizeof(ExprFormat::FileHeader)) {
+        corrupt("file is smaller than its header");
+    }
+    header = reinterpret_cast<const ExprFormat::FileHeader*>(base);
+    if (std::memcmp(header->magic, ExprFormat::kMagic, sizeof(header->magic)) != 0) {
+        throw std::runtime_error("Not a formula library: bad magic number.");
+    }
+    if (header->byteOrderMark != ExprFormat::kByteOrderMark) {
+        throw std::runtime_error("Formula library was written with a different byte order.");
+    }
+    if (header->version != ExprFormat::kVersion) {
+        throw std::runtime_error("Unsupported formula library version " + std::to_string(header->version) +
+                                 " (expected " + std::to_string(ExprFormat::kVersion) + ").");
+    }
+    if (header->fileSize != size) {
+        corrupt("file size does not match its header");
+    }
+    if (!sectionFits(header->formulasOffset, header->formulaCount, sizeof(ExprFormat::FormulaEntry), size) ||
+        !sectionFits(header->recordsOffset, header->recordCount, sizeof(ExprFormat::NodeRecord), size) ||
+        !sectionFits(header->constantsOffset, header->constantCount, sizeof(double), size) ||
+        !sectionFits(header->symbolsOffset, header->symbolCount, sizeof(ExprFormat::StringRef), size) ||
+        !sectionFits(header->functionsOffset, header->functionCount, sizeof(ExprFormat::FunctionEntry), size) ||
+        header->stringsOffset > size || header->stringBytes > size - header->stringsOffset) {
+        corrupt("section outside the file");
+    }
+    formulas = reinterpret_cast<const ExprFormat::FormulaEntry*>(base + header->formulasOffset);
+    records = reinterpret_cast<const ExprFormat::NodeRecord*>(base + header->recordsOffset);
+    constants = reinterpret_cast<const double*>(base + header->constantsOffset);
+    symbols = reinterpret_cast<const ExprFormat::StringRef*>(base + header->symbolsOffset);
+    functions = reinterpret_cast<const ExprFormat::FunctionEntry*>(base + header->functionsOffset);
+    strings = base + header->stringsOffset;
+
+    resolved.assign(header->functionCount, nullptr);
+    for (std::uint32_t i = 0; i < header->functionCount; ++i) {
+        std::string_view name = text(functions[i].name);
+        const FunctionDefinition* definition = registry ? registry->find(name) : nullptr;
+        if (definition && static_cast<std::uint32_t>(definition->argCount) != functions[i].argCount) {
+            throw std::runtime_error("Function " + std::string(name) + " takes " +
+                                     std::to_string(functions[i].argCount) + " arguments in the library but " +
+                                     std::to_string(definition->argCount) + " in the registry.");
+        }
+        resolved[i] = definition;
+    }
+}
+
+// **Lookup**
+std::size_t ExprLibrary::getFormulaCount() const {
+    return header->formulaCount;
+}
+
+std::string_view ExprLibrary::getName(std::size_t formula) const {
+    return text(formulaAt(formula).name);
+}
+
+std::size_t ExprLibrary::find(std::string_view name) const {
+    for (std::size_t i = 0; i < header->formulaCount; ++i) {
+        if (text(formulas[i].name) == name) {
+            return i;
+        }
+    }
+    return npos;
+}
+
+std::size_t ExprLibrary::getSymbolCount() const {
+    return header->symbolCount;
+}
+
+std::string_view ExprLibrary::getSymbol(std::size_t symbol) const {
+    if (symbol >= header->symbolCount) {
+        throw std::out_of_range("Symbol index " + std::to_string(symbol) + " is out of range.");
+    }
+    return text(symbols[symbol]);
+}
+
+const ExprFormat::FormulaEntry& ExprLibrary::formulaAt(std::size_t formula) const {
+    if (formula >= header->formulaCount) {
+        throw std::out_of_range("Formula index " + std::to_string(formula) + " is out of range.");
+    }
+    const ExprFormat::FormulaEntry& entry = formulas[formula];
+    if (entry.recordCount == 0 || entry.firstRecord > header->recordCount ||
+        entry.recordCount > header->recordCount - entry.firstRecord || entry.maxStackDepth > entry.recordCount) {
+        corrupt("formula records outside the record section");
+    }
+    return entry;
+}
+
+std::string_view ExprLibrary::text(const ExprFormat::StringRef& ref) const {
+    if (ref.offset > header->stringBytes || ref.length > header->stringBytes - ref.offset) {
+        corrupt("string outside the string section");
+    }
+    return std::string_view(strings + ref.offset, ref.length);
+}
+
+const FunctionDefinition& ExprLibrary::functionAt(std::uint32_t function) const {
+    if (!resolved[function]) {
+        throw std::runtime_error("Function " + std::string(text(functions[function].name)) + " is not registered.");
+    }
+    return *resolved[function];
+}
+
+void ExprLibrary::corrupt(const char* what) const {
+    throw std::runtime_error(std::string("Corrupt formula library: ") + what + ".");
+}
+
+// **Evaluation: a stack machine over the mapped records**
+double ExprLibrary::evaluate(std::size_t formula, const double* slots) const {
+    const std::uint32_t symbolCount = header->symbolCount;
+    return run(formulaAt(formula), [&](std::uint32_t symbol) {
+        if (symbol >= symbolCount) {
+            corrupt("variable outside the symbol table");
+        }
+        return slots[symbol];
+    });
+}
+
+double ExprLibrary::evaluate(std::size_t formula, const Env& env) const {
+    std::string name;
+    return run(formulaAt(formula), [&](std::uint32_t symbol) {
+        std::string_view symbolName = getSymbol(symbol);
+        name.assign(symbolName.data(), symbolName.size());
+        auto it = env.find(name);
+        return it != env.end() ? it->second : 0.0;
+    });
+}
+
+template<typename LoadVariable>
+double ExprLibrary::run(const ExprFormat::FormulaEntry& entry, LoadVariable&& loadVariable) const {
+    double inlineStack[kInlineStackSize];
+    std::vector<double> heapStack;
+    double* stack = inlineStack;
+    if (entry.maxStackDepth > kInlineStackSize) {
+        heapStack.resize(entry.maxStackDepth);
+        stack = heapStack.data();
+    }
+    std::vector<double> args;  // Only allocates for user function calls
+
+    std::size_t depth = 0;
+    const ExprFormat::NodeRecord* record = records + entry.firstRecord;
+    const ExprFormat::NodeRecord* end = record + entry.recordCount;
+    for (; record != end; ++record) {
+        const std::size_t arity = record->arity;
+        if (arity > depth || depth - arity + 1 > entry.maxStackDepth) {
+            corrupt("record stack underflow or overflow");
+        }
+        double* top = stack + depth;
+        switch (static_cast<NodeKind>(record->kind)) {
+        case NodeKind::Number:
+            if (arity != 0 || record->payload >= header->constantCount) {
+                corrupt("bad constant record");
+            }
+            *top = constants[record->payload];
+            break;
+        case NodeKind::Variable:
+            if (arity != 0) {
+                corrupt("bad variable record");
+            }
+            *top = loadVariable(record->payload);
+            break;
+        case NodeKind::Addition:
+        case NodeKind::Subtraction:
+        case NodeKind::Multiplication:
+        case NodeKind::Division:
+        case NodeKind::Exponentiation:
+        case NodeKind::Log:
+        case NodeKind::Equality: {
+            if (arity != 2) {
+                corrupt("binary record without two children");
+            }
+            const double lhs = top[-2];
+            const double rhs = top[-1];
+            double& result = top[-2];
+            switch (static_cast<NodeKind>(record->kind)) {
+            case NodeKind::Addition: result = lhs + rhs; break;
+            case NodeKind::Subtraction: result = lhs - rhs; break;
+            case NodeKind::Multiplication: result = lhs * rhs; break;
+            case NodeKind::Division:
+                if (rhs == 0) {
+                    const std::size_t index = static_cast<std::size_t>(record - records);
+                    if (record->size == 0 || record->size > index + 1) {
+                        corrupt("bad subtree size");
+                    }
+                    ExprArena scratch;
+                    const Node* division = build(index + 1 - record->size, record->size, scratch);
+                    throw std::runtime_error("Division by zero error in " + division->toString());
+                }
+                result = lhs / rhs;
+                break;
+            case NodeKind::Exponentiation:
+                if (lhs == 0 && rhs <= 0) {
+                    throw std::runtime_error("Math error: 0 raised to a non-positive exponent.");
+                }
+                result = std::pow(lhs, rhs);
+                break;
+            case NodeKind::Log:
+                if (lhs <= 0 || lhs == 1 || rhs <= 0) {
+                    throw std::runtime_error("Math error: log with invalid base or operand.");
+                }
+                result = std::log(rhs) / std::log(lhs);
+                break;
+            default:
+                result = std::fabs(lhs - rhs) < 1e-9 ? 1.0 : 0.0;
+                break;
+            }
+            break;
+        }
+        case NodeKind::Sin:
+        case NodeKind::Cos:
+        case NodeKind::Ln:
+            if (arity != 1) {
+                corrupt("unary record without one child");
+            }
+            if (record->kind == static_cast<std::uint8_t>(NodeKind::Sin)) {
+                top[-1] = std::sin(top[-1]);
+            } else if (record->kind == static_cast<std::uint8_t>(NodeKind::Cos)) {
+                top[-1] = std::cos(top[-1]);
+            } else {
+                if (top[-1] <= 0) {
+                    throw std::runtime_error("Math error: ln of non-positive number.");
+                }
+                top[-1] = std::log(top[-1]);
+            }
+            break;
+        case NodeKind::Function: {
+            if (record->payload >= header->functionCount || functions[record->payload].argCount != arity) {
+                corrupt("bad function record");
+            }
+            const FunctionDefinition& definition = functionAt(record->payload);
+            args.assign(top - arity, top);
+            top[-static_cast<std::ptrdiff_t>(arity)] = definition.callbacks->callback(args);
+            break;
+        }
+        default:
+            corrupt("unknown node kind");
+        }
+        depth = depth - arity + 1;
+    }
+    if (depth != 1) {
+        corrupt("formula does not reduce to one value");
+    }
+    return stack[0];
+}
+
+// **Rebuilding nodes**
+Node* ExprLibrary::load(std::size_t formula, ExprArena& arena) const {
+    const ExprFormat::FormulaEntry& entry = formulaAt(formula);
+    return build(entry.firstRecord, entry.recordCount, arena);
+}
+
+Node* ExprLibrary::build(std::size_t firstRecord, std::size_t recordCount, ExprArena& arena) const {
+    ExprHelper e(arena);
+    std::vector<Node*> stack;
+    for (std::size_t i = firstRecord; i < firstRecord + recordCount; ++i) {
+        const ExprFormat::NodeRecord& record = records[i];
+        const std::size_t arity = record.arity;
+        if (arity > stack.size()) {
+            corrupt("record stack underflow");
+        }
+        Node* node;
+        switch (static_cast<NodeKind>(record.kind)) {
+        case NodeKind::Number:
+            if (arity != 0 || record.payload >= header->constantCount) {
+                corrupt("bad constant record");
+            }
+            node = e.num(constants[record.payload]);
+            break;
+        case NodeKind::Variable:
+            if (arity != 0) {
+                corrupt("bad variable record");
+            }
+            node = e.var(std::string(getSymbol(record.payload)));
+            break;
+        case NodeKind::Function: {
+            if (record.payload >= header->functionCount || functions[record.payload].argCount != arity) {
+                corrupt("bad function record");
+            }
+            const FunctionDefinition& definition = functionAt(record.payload);
+            std::vector<Node*> args(stack.end() - static_cast<std::ptrdiff_t>(arity), stack.end());
+            node = e.func(std::string(text(functions[record.payload].name)), definition.argCount, args,
+                          definition.callbacks);
+            break;
+        }
+        case NodeKind::Sin:
+        case NodeKind::Cos:
+        case NodeKind::Ln:
+            if (arity != 1) {
+                corrupt("unary record without one child");
+            }
+            node = e.build(static_cast<NodeKind>(record.kind), stack.back());
+            break;
+        case NodeKind::Addition:
+        case NodeKind::Subtraction:
+        case NodeKind::Multiplication:
+        case NodeKind::Division:
+        case NodeKind::Exponentiation:
+        case NodeKind::Log:
+        case NodeKind::Equality:
+            if (arity != 2) {
+                corrupt("binary record without two children");
+            }
+            node = e.build(static_cast<NodeKind>(record.kind), stack[stack.size() - 2], stack.back());
+            break;
+        default:
+            corrupt("unknown node kind");
+        }
+        stack.resize(stack.size() - arity);
+        stack.push_back(node);
+    }
+    if (stack.size() != 1) {
+        corrupt("formula does not reduce to one value");
+    }
+    return stack.back();
+}
+
+} // namespace Expression
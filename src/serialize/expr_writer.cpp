@@ -0,0 +1,225 @@
+#include "serialize/expr_writer.h"
+#include "expression/number_node.h"
+#include "expression/variable_node.h"
+#include "expression/binary_op_node.h"
+#include "expression/unary_op_node.h"
+#include "expression/equality_node.h"
+#include "expression/function_node.h"
+
+#include <fstream>
+#include <limits>
+
+namespace Expression {
+
+namespace {
+
+constexpr std::size_t kSectionAlignment = 8;
+
+std::uint64_t alignSection(std::uint64_t offset) {
+    return (offset + kSectionAlignment - 1) & ~static_cast<std::uint64_t>(kSectionAlignment - 1);
+}
+
+std::uint32_t checkedCount(std::size_t count, const char* what) {
+    if (count > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error(std::string("Formula library has too many ") + what + ".");
+    }
+    return static_cast<std::uint32_t>(count);
+}
+
+} // namespace
+
+std::size_t ExprWriter::add(const Node* root, const std::string& name) {
+    if (!root) {
+        throw std::runtime_error("Cannot serialize a null expression.");
+    }
+    ExprFormat::FormulaEntry entry{};
+    entry.firstRecord = checkedCount(records.size(), "nodes");
+    entry.name = stringRef(name);
+    stackDepth = 0;
+    maxStackDepth = 0;
+    try {
+        entry.recordCount = encode(root);
+    } catch (...) {
+        records.resize(entry.firstRecord);  // Pooled entries stay; they are harmless
+        throw;
+    }
+    entry.maxStackDepth = static_cast<std::uint32_t>(maxStackDepth);
+    formulas.push_back(entry);
+    return formulas.size() - 1;
+}
+
+std::size_t ExprWriter::getFormulaCount() const {
+    return formulas.size();
+}
+
+// **Encoding: postorder, children first**
+std::uint32_t ExprWriter::encode(const Node* node) {
+    const std::size_t start = records.size();
+    std::size_t arity = 0;
+    std::uint32_t payload = 0;
+    std::uint32_t firstChildSize = 0;
+    auto encodeChild = [&](const Node* child) {
+        std::uint32_t size = encode(child);
+        if (arity++ == 0) {
+            firstChildSize = size;
+        }
+    };
+
+    switch (node->getKind()) {
+    case NodeKind::Number:
+        payload = constantIndex(static_cast<const NumberNode*>(node)->getValue());
+        break;
+    case NodeKind::Variable:
+        payload = symbolIndex(static_cast<const VariableNode*>(node)->getName());
+        break;
+    case NodeKind::Sin:
+    case NodeKind::Cos:
+    case NodeKind::Ln:
+        encodeChild(static_cast<const UnaryOpNode*>(node)->getOperand());
+        break;
+    case NodeKind::Equality:
+        encodeChild(static_cast<const EqualityNode*>(node)->getLeft());
+        encodeChild(static_cast<const EqualityNode*>(node)->getRight());
+        break;
+    case NodeKind::Function: {
+        const auto* function = static_cast<const FunctionNode*>(node);
+        payload = functionIndex(function);
+        for (const Node* argument : function->getArguments()) {
+            encodeChild(argument);
+        }
+        break;
+    }
+    default:
+        encodeChild(static_cast<const BinaryOpNode*>(node)->getLeft());
+        encodeChild(static_cast<const BinaryOpNode*>(node)->getRight());
+        break;
+    }
+
+    const std::size_t size = records.size() - start + 1;
+    pushRecord(node->getKind(), arity, payload, checkedCount(size, "nodes"),
+               arity ? static_cast<std::uint32_t>(size - firstChildSize) : 0);
+    return static_cast<std::uint32_t>(size);
+}
+
+void ExprWriter::pushRecord(NodeKind kind, std::size_t arity, std::uint32_t payload, std::uint32_t size,
+                            std::uint32_t firstChild) {
+    if (arity > std::numeric_limits<std::uint16_t>::max()) {
+        throw std::runtime_error("Cannot serialize a call with " + std::to_string(arity) + " arguments.");
+    }
+    ExprFormat::NodeRecord record{};
+    record.kind = static_cast<std::uint8_t>(kind);
+    record.arity = static_cast<std::uint16_t>(arity);
+    record.payload = payload;
+    record.size = size;
+    record.firstChild = firstChild;
+    records.push_back(record);
+
+    // Each record pops its children and pushes its own value.
+    stackDepth = stackDepth - arity + 1;
+    maxStackDepth = std::max(maxStackDepth, stackDepth);
+}
+
+// **Pools**
+std::uint32_t ExprWriter::constantIndex(double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    auto [it, inserted] = constantOfBits.emplace(bits, static_cast<std::uint32_t>(constants.size()));
+    if (inserted) {
+        checkedCount(constants.size() + 1, "constants");
+        constants.push_back(value);
+    }
+    return it->second;
+}
+
+std::uint32_t ExprWriter::symbolIndex(const std::string& name) {
+    auto [it, inserted] = symbolOfName.emplace(name, static_cast<std::uint32_t>(symbols.size()));
+    if (inserted) {
+        checkedCount(symbols.size() + 1, "variables");
+        symbols.push_back(stringRef(name));
+    }
+    return it->second;
+}
+
+std::uint32_t ExprWriter::functionIndex(const FunctionNode* function) {
+    const std::string& name = function->getName();
+    auto [it, inserted] = functionOfName.emplace(name, static_cast<std::uint32_t>(functions.size()));
+    if (inserted) {
+        ExprFormat::FunctionEntry entry{};
+        entry.name = stringRef(name);
+        entry.argCount = static_cast<std::uint32_t>(function->getExpectedArgCount());
+        functions.push_back(entry);
+    } else if (functions[it->second].argCount != static_cast<std::uint32_t>(function->getExpectedArgCount())) {
+        throw std::runtime_error("Function " + name + " is used with different argument counts.");
+    }
+    return it->second;
+}
+
+ExprFormat::StringRef ExprWriter::stringRef(const std::string& text) {
+    auto it = stringOfText.find(text);
+    if (it != stringOfText.end()) {
+        return it->second;
+    }
+    ExprFormat::StringRef ref{checkedCount(strings.size(), "characters of text"),
+                              checkedCount(text.size(), "characters of text")};
+    strings += text;
+    checkedCount(strings.size(), "characters of text");
+    stringOfText.emplace(text, ref);
+    return ref;
+}
+
+// **Output**
+void ExprWriter::write(std::ostream& out) const {
+    ExprFormat::FileHeader header{};
+    std::memcpy(header.magic, ExprFormat::kMagic, sizeof(header.magic));
+    header.version = ExprFormat::kVersion;
+    header.byteOrderMark = ExprFormat::kByteOrderMark;
+    header.formulaCount = static_cast<std::uint32_t>(formulas.size());
+    header.recordCount = static_cast<std::uint32_t>(records.size());
+    header.constantCount = static_cast<std::uint32_t>(constants.size());
+    header.symbolCount = static_cast<std::uint32_t>(symbols.size());
+    header.functionCount = static_cast<std::uint32_t>(functions.size());
+    header.stringBytes = static_cast<std::uint32_t>(strings.size());
+
+    std::uint64_t offset = sizeof(header);
+    auto place = [&](std::uint64_t bytes) {
+        offset = alignSection(offset);
+        std::uint64_t start = offset;
+        offset += bytes;
+        return start;
+    };
+    header.formulasOffset = place(formulas.size() * sizeof(ExprFormat::FormulaEntry));
+    header.recordsOffset = place(records.size() * sizeof(ExprFormat::NodeRecord));
+    header.constantsOffset = place(constants.size() * sizeof(double));
+    header.symbolsOffset = place(symbols.size() * sizeof(ExprFormat::StringRef));
+    header.functionsOffset = place(functions.size() * sizeof(ExprFormat::FunctionEntry));
+    header.stringsOffset = place(strings.size());
+    header.fileSize = offset;
+
+    std::uint64_t written = 0;
+    auto emit = [&](std::uint64_t sectionOffset, const void* data, std::size_t bytes) {
+        static const char padding[kSectionAlignment] = {};
+        out.write(padding, static_cast<std::streamsize>(sectionOffset - written));
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        written = sectionOffset + bytes;
+    };
+    emit(0, &header, sizeof(header));
+    emit(header.formulasOffset, formulas.data(), formulas.size() * sizeof(ExprFormat::FormulaEntry));
+    emit(header.recordsOffset, records.data(), records.size() * sizeof(ExprFormat::NodeRecord));
+    emit(header.constantsOffset, constants.data(), constants.size() * sizeof(double));
+    emit(header.symbolsOffset, symbols.data(), symbols.size() * sizeof(ExprFormat::StringRef));
+    emit(header.functionsOffset, functions.data(), functions.size() * sizeof(ExprFormat::FunctionEntry));
+    emit(header.stringsOffset, strings.data(), strings.size());
+    if (!out) {
+        throw std::runtime_error("Failed to write formula library.");
+    }
+}
+
+void ExprWriter::writeFile(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot open " + path + " for writing.");
+    }
+    write(out);
+}
+
+} // namespace Expression
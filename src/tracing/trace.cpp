@@ -1,58 +1,307 @@
 #include "tracing/trace.h"
+#include "tracing/trace_writer.h"
+#include "printer/expr_printer.h"
+
+#include <chrono>
 
 namespace Expression {
 
-// Definition of static members.
-std::ostringstream Trace::oss;
-std::vector<std::string> Trace::messages;
-std::vector<TransformationStep> Trace::transformationSteps;
+namespace {
+
+std::uint64_t now() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// **Formatting**
+void appendText(const TraceRecord& record, std::string& out) {
+    if (record.isTransformation) {
+        out += "Transformation: ";
+        out += record.text;
+        out += "\n    Before: ";
+        out += record.before;
+        out += "\n    After : ";
+        out += record.after;
+    } else {
+        out += record.text;
+    }
+}
+
+std::string formatTrace(const std::vector<TraceRecord>& records) {
+    std::string out;
+    for (const TraceRecord& record : records) {
+        appendText(record, out);
+        out += '\n';
+    }
+    return out;
+}
+
+template <typename Destination>
+void writeRecords(Destination& destination, const std::vector<TraceRecord>& records,
+                  const TraceExportOptions& options) {
+    TraceWriter writer(destination);
+    writer.write(records, options);
+}
+
+std::string formatJson(const std::vector<TraceRecord>& records) {
+    std::string out;
+    TraceExportOptions options;
+    options.pretty = true;
+    writeRecords(out, records, options);
+    return out;
+}
+
+// **Aggregation**
+struct ThreadSink {
+    TraceSink sink;
+    std::atomic<bool> retired{false};  // The owning thread has exited and records no more
+};
+
+// Registry of per-thread sinks. Draining moves their records into one timeline ordered
+// by timestamp; records of one thread keep their order on ties.
+class Aggregator {
+public:
+    static Aggregator& instance() {
+        static Aggregator aggregator;
+        return aggregator;
+    }
+
+    std::shared_ptr<ThreadSink> registerThread() {
+        auto sink = std::make_shared<ThreadSink>();
+        std::lock_guard<std::mutex> lock(mutex);
+        sinks.push_back(sink);
+        return sink;
+    }
+
+    // Run read on the merged timeline. Threads keep recording meanwhile, but sinks
+    // created during a long export wait to register until it ends.
+    template <typename Read>
+    auto read(Read readTimeline) {
+        std::lock_guard<std::mutex> lock(mutex);
+        collect();
+        return readTimeline(static_cast<const std::vector<TraceRecord>&>(timeline));
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        collect();
+        timeline.clear();
+    }
+
+private:
+    void collect() {
+        for (std::size_t i = 0; i < sinks.size();) {
+            // Read the flag first: once it is set, this drain sees the thread's last record.
+            bool retired = sinks[i]->retired.load(std::memory_order_acquire);
+            std::size_t begin = pending.size();
+            sinks[i]->sink.drainInto(pending);
+            // steady_clock is monotonic, so each sink's records are already in order.
+            std::inplace_merge(pending.begin(), pending.begin() + begin, pending.end(), earlier);
+            if (retired) {
+                sinks[i] = std::move(sinks.back());
+                sinks.pop_back();
+            } else {
+                ++i;
+            }
+        }
+        std::size_t middle = timeline.size();
+        std::move(pending.begin(), pending.end(), std::back_inserter(timeline));
+        pending.clear();
+        std::inplace_merge(timeline.begin(), timeline.begin() + middle, timeline.end(), earlier);
+    }
+
+    static bool earlier(const TraceRecord& a, const TraceRecord& b) {
+        return a.timestamp < b.timestamp;
+    }
+
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadSink>> sinks;
+    std::vector<TraceRecord> pending;   // Drained this round, before merging into timeline
+    std::vector<TraceRecord> timeline;  // Everything drained since the last clear()
+};
+
+// Keeps the thread's sink registered after the thread exits so its last records can
+// still be collected; the aggregator drops it once drained.
+struct ThreadSinkHandle {
+    std::shared_ptr<ThreadSink> sink;
+
+    ~ThreadSinkHandle() {
+        if (sink) {
+            sink->retired.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadSinkHandle threadSink;
+thread_local TraceSink* scopedSink = nullptr;
+
+TraceSink& currentSink() {
+    if (scopedSink) {
+        return *scopedSink;
+    }
+    if (!threadSink.sink) {
+        threadSink.sink = Aggregator::instance().registerThread();
+    }
+    return threadSink.sink->sink;
+}
+
+std::size_t roundUpToPowerOfTwo(std::size_t n) {
+    std::size_t capacity = 1;
+    while (capacity < n) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+} // namespace
+
+// **TraceSink**
+TraceSink::TraceSink(std::size_t capacity) {
+    if (capacity == 0) {
+        throw std::runtime_error("TraceSink capacity must be positive.");
+    }
+    capacity = roundUpToPowerOfTwo(capacity);
+    slots.reset(new TraceRecord[capacity]);
+    mask = capacity - 1;
+}
+
+void TraceSink::record(TraceRecord&& record) {
+    std::size_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) > mask) {
+        spill(h);
+    }
+    slots[h & mask] = std::move(record);
+    head.store(h + 1, std::memory_order_release);
+}
+
+// Hand the full ring over to the consumers as it is and continue in a fresh one, so a
+// sink nobody drains costs no more per record than a vector would. Only the producer
+// replaces slots, and consumers touch it only under consumerMutex.
+void TraceSink::spill(std::size_t h) {
+    std::lock_guard<std::mutex> lock(consumerMutex);
+    std::size_t t = tail.load(std::memory_order_relaxed);
+    if (h - t <= mask) {
+        return;  // A consumer drained the ring while this thread waited for the lock
+    }
+    std::unique_ptr<TraceRecord[]> next = spare ? std::move(spare) : std::make_unique<TraceRecord[]>(mask + 1);
+    spilled.push_back({std::move(slots), t, h});
+    slots = std::move(next);
+    tail.store(h, std::memory_order_release);
+    spills.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TraceSink::drainInto(std::vector<TraceRecord>& out) {
+    std::lock_guard<std::mutex> lock(consumerMutex);
+    for (SpilledRing& ring : spilled) {
+        for (std::size_t i = ring.begin; i != ring.end; ++i) {
+            out.push_back(std::move(ring.slots[i & mask]));
+        }
+        spare = std::move(ring.slots);
+    }
+    spilled.clear();
+    std::size_t t = tail.load(std::memory_order_relaxed);
+    std::size_t h = head.load(std::memory_order_acquire);
+    for (; t != h; ++t) {
+        out.push_back(std::move(slots[t & mask]));
+    }
+    tail.store(t, std::memory_order_release);
+}
+
+std::string TraceSink::getTrace() {
+    std::vector<TraceRecord> records;
+    drainInto(records);
+    return formatTrace(records);
+}
+
+std::string TraceSink::exportToJson() {
+    std::vector<TraceRecord> records;
+    drainInto(records);
+    return formatJson(records);
+}
+
+void TraceSink::exportTo(std::ostream& out, const TraceExportOptions& options) {
+    std::vector<TraceRecord> records;
+    drainInto(records);
+    writeRecords(out, records, options);
+}
+
+void TraceSink::exportTo(int fd, const TraceExportOptions& options) {
+    std::vector<TraceRecord> records;
+    drainInto(records);
+    writeRecords(fd, records, options);
+}
+
+std::uint64_t TraceSink::getSpillCount() const {
+    return spills.load(std::memory_order_relaxed);
+}
+
+// **TraceScope**
+TraceScope::TraceScope(TraceSink& sink) : previous(scopedSink) {
+    scopedSink = &sink;
+}
+
+TraceScope::~TraceScope() {
+    scopedSink = previous;
+}
+
+// **Trace**
+void Trace::setLevel(TraceLevel level) {
+    currentLevel.store(level, std::memory_order_relaxed);
+}
+
+TraceLevel Trace::getLevel() {
+    return currentLevel.load(std::memory_order_relaxed);
+}
 
 void Trace::add(const std::string& message) {
-    // Add message to plain text stream.
-    oss << message << "\n";
-    // Also store in the messages vector.
-    messages.push_back(message);
+    TraceRecord record;
+    record.timestamp = now();
+    record.text = message;
+    currentSink().record(std::move(record));
 }
 
 void Trace::addTransformation(const std::string& description, const std::string& before, const std::string& after) {
-    TransformationStep step{description, before, after};
-    transformationSteps.push_back(step);
-    // Also log to the plain text trace.
-    std::ostringstream ossStep;
-    ossStep << "Transformation: " << description << "\n"
-            << "    Before: " << before << "\n"
-            << "    After : " << after;
-    add(ossStep.str());
+    TraceRecord record;
+    record.timestamp = now();
+    record.isTransformation = true;
+    record.text = description;
+    record.before = before;
+    record.after = after;
+    currentSink().record(std::move(record));
+}
+
+void Trace::addTransformation(const std::string& description, const Node* before, const Node* after) {
+    TraceRecord record;
+    record.timestamp = now();
+    record.isTransformation = true;
+    record.text = description;
+    record.before = ExprPrinter::toString(before);
+    record.after = ExprPrinter::toString(after);
+    currentSink().record(std::move(record));
 }
 
 void Trace::clear() {
-    oss.str("");
-    oss.clear();
-    messages.clear();
-    transformationSteps.clear();
+    Aggregator::instance().clear();
 }
 
 std::string Trace::getTrace() {
-    return oss.str();
+    return Aggregator::instance().read(formatTrace);
 }
 
 std::string Trace::exportToJson() {
-    // Create a JSON object.
-    nlohmann::json j;
-    j["messages"] = messages;
-    
-    // Build an array of transformation steps.
-    j["transformationSteps"] = nlohmann::json::array();
-    for (const auto& step : transformationSteps) {
-        nlohmann::json jStep;
-        jStep["description"] = step.description;
-        jStep["before"] = step.before;
-        jStep["after"] = step.after;
-        j["transformationSteps"].push_back(jStep);
-    }
-    
-    // Return the JSON dump (pretty-printed with indent of 4 spaces).
-    return j.dump(4);
+    return Aggregator::instance().read(formatJson);
+}
+
+void Trace::exportTo(std::ostream& out, const TraceExportOptions& options) {
+    Aggregator::instance().read([&](const std::vector<TraceRecord>& records) {
+        writeRecords(out, records, options);
+    });
+}
+
+void Trace::exportTo(int fd, const TraceExportOptions& options) {
+    Aggregator::instance().read([&](const std::vector<TraceRecord>& records) {
+        writeRecords(fd, records, options);
+    });
 }
 
 } // namespace Expression
@@ -0,0 +1,224 @@
+#include "tracing/trace_writer.h"
+
+#include <cerrno>
+#include <unistd.h>
+
+namespace Expression {
+
+namespace {
+
+bool needsEscape(unsigned char c) {
+    return c < 0x20 || c == '"' || c == '\\';
+}
+
+} // namespace
+
+TraceWriter::TraceWriter(std::ostream& out) {
+    destination = [&out](const char* data, std::size_t size) {
+        out.write(data, static_cast<std::streamsize>(size));
+        if (!out) {
+            throw std::runtime_error("Trace export failed: stream write error.");
+        }
+    };
+    buffer.reserve(kChunkSize);
+}
+
+TraceWriter::TraceWriter(int fd) {
+    destination = [fd](const char* data, std::size_t size) {
+        while (size > 0) {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error(std::string("Trace export failed: ") + std::strerror(errno));
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+    };
+    buffer.reserve(kChunkSize);
+}
+
+TraceWriter::TraceWriter(std::string& out) {
+    destination = [&out](const char* data, std::size_t size) { out.append(data, size); };
+    buffer.reserve(kChunkSize);
+}
+
+void TraceWriter::write(const std::vector<TraceRecord>& records, const TraceExportOptions& options) {
+    if (options.format == TraceFormat::JsonLines) {
+        writeJsonLines(records);
+    } else {
+        writeJson(records, options.pretty);
+    }
+    flush();
+}
+
+// **JSON**
+// One object with keys in nlohmann's (sorted) order: every record under "messages", the
+// transformations again under "transformationSteps".
+void TraceWriter::writeJson(const std::vector<TraceRecord>& records, bool prettyPrint) {
+    pretty = prettyPrint;
+    put('{');
+    newline(1);
+    key("messages");
+    if (records.empty()) {
+        put("[]");
+    } else {
+        put('[');
+        for (std::size_t i = 0; i < records.size(); ++i) {
+            if (i > 0) {
+                put(',');
+            }
+            newline(2);
+            recordText(records[i]);
+        }
+        newline(1);
+        put(']');
+    }
+    put(',');
+    newline(1);
+    key("transformationSteps");
+    bool first = true;
+    for (const TraceRecord& record : records) {
+        if (!record.isTransformation) {
+            continue;
+        }
+        put(first ? '[' : ',');
+        first = false;
+        newline(2);
+        put('{');
+        newline(3);
+        key("after");
+        string(record.after);
+        put(',');
+        newline(3);
+        key("before");
+        string(record.before);
+        put(',');
+        newline(3);
+        key("description");
+        string(record.text);
+        newline(2);
+        put('}');
+    }
+    if (first) {
+        put("[]");
+    } else {
+        newline(1);
+        put(']');
+    }
+    newline(0);
+    put('}');
+}
+
+// **JSON Lines**
+// One object per record, in timeline order, each on its own line.
+void TraceWriter::writeJsonLines(const std::vector<TraceRecord>& records) {
+    pretty = false;
+    for (const TraceRecord& record : records) {
+        put("{\"timestamp\":");
+        put(std::to_string(record.timestamp));
+        if (record.isTransformation) {
+            put(",\"type\":\"transformation\",\"description\":");
+            string(record.text);
+            put(",\"before\":");
+            string(record.before);
+            put(",\"after\":");
+            string(record.after);
+        } else {
+            put(",\"type\":\"message\",\"text\":");
+            string(record.text);
+        }
+        put("}\n");
+    }
+}
+
+// **Output**
+void TraceWriter::newline(int depth) {
+    static const char indent[] = "\n            ";  // Room for the deepest level, 3
+    if (pretty) {
+        put(std::string_view(indent, 1 + static_cast<std::size_t>(depth) * 4));
+    }
+}
+
+void TraceWriter::key(const char* name) {
+    put('"');
+    put(name);
+    put(pretty ? "\": " : "\":");
+}
+
+void TraceWriter::string(std::string_view text) {
+    put('"');
+    escaped(text);
+    put('"');
+}
+
+void TraceWriter::recordText(const TraceRecord& record) {
+    put('"');
+    if (record.isTransformation) {
+        put("Transformation: ");
+        escaped(record.text);
+        put("\\n    Before: ");
+        escaped(record.before);
+        put("\\n    After : ");
+        escaped(record.after);
+    } else {
+        escaped(record.text);
+    }
+    put('"');
+}
+
+void TraceWriter::escaped(std::string_view text) {
+    static const char hex[] = "0123456789abcdef";
+    std::size_t run = 0;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (!needsEscape(c)) {
+            continue;
+        }
+        put(text.substr(run, i - run));
+        run = i + 1;
+        switch (c) {
+        case '"': put("\\\""); break;
+        case '\\': put("\\\\"); break;
+        case '\b': put("\\b"); break;
+        case '\f': put("\\f"); break;
+        case '\n': put("\\n"); break;
+        case '\r': put("\\r"); break;
+        case '\t': put("\\t"); break;
+        default: {
+            char code[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 15]};
+            put(std::string_view(code, sizeof(code)));
+        }
+        }
+    }
+    put(text.substr(run));
+}
+
+void TraceWriter::put(std::string_view text) {
+    if (buffer.size() + text.size() > kChunkSize) {
+        flush();
+        if (text.size() > kChunkSize) {
+            destination(text.data(), text.size());
+            return;
+        }
+    }
+    buffer.append(text.data(), text.size());
+}
+
+void TraceWriter::put(char c) {
+    if (buffer.size() >= kChunkSize) {
+        flush();
+    }
+    buffer.push_back(c);
+}
+
+void TraceWriter::flush() {
+    if (!buffer.empty()) {
+        destination(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+}
+
+} // namespace Expression
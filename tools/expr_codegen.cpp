@@ -0,0 +1,154 @@
+#include "compiler/cpp_emitter.h"
+#include "memory/expr_arena.h"
+#include "parser/parser.h"
+
+#include <fstream>
+#include <iostream>
+
+using namespace Expression;
+
+// Ahead-of-time formula compiler: reads a formula spec and writes a C++ header and source
+// with one function per formula (see CppEmitter). Used by expr_add_formula_library.
+//
+// Spec lines, '#' starting a comment:
+//
+//   function NAME ARGC                  a user function, defined by the program as
+//                                       double NAME(const double* args), and, if a
+//                                       derivative goes through it, its partials as
+//                                       double NAME_d<i>(const double* args)
+//   NAME(x, y) = EXPRESSION             double NAME(const double* vars), vars = {x, y}
+//   d/dx NAME(x, y) = EXPRESSION        its derivative with respect to x
+//   grad NAME(x, y) = EXPRESSION        void NAME(const double* vars, double* gradient)
+
+namespace {
+
+std::string trim(const std::string& text) {
+    std::size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    std::size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+std::vector<std::string> splitParameters(const std::string& list) {
+    std::vector<std::string> parameters;
+    std::stringstream stream(list);
+    for (std::string parameter; std::getline(stream, parameter, ',');) {
+        parameter = trim(parameter);
+        if (!parameter.empty()) {
+            parameters.push_back(parameter);
+        }
+    }
+    return parameters;
+}
+
+std::string baseName(const std::string& path) {
+    std::size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+std::string includeGuard(const std::string& headerName) {
+    std::string guard;
+    for (char c : headerName) {
+        guard += std::isalnum(static_cast<unsigned char>(c)) ? static_cast<char>(std::toupper(c)) : '_';
+    }
+    return guard;
+}
+
+void compileSpec(std::istream& in, CppEmitter& emitter) {
+    ExprArena arena;
+    FunctionRegistry functions;
+    std::string line;
+    for (std::size_t lineNumber = 1; std::getline(in, line); ++lineNumber) {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+        try {
+            if (line.rfind("function ", 0) == 0) {
+                std::stringstream stream(line.substr(9));
+                std::string name;
+                int argCount = -1;
+                if (!(stream >> name >> argCount) || argCount < 0) {
+                    throw std::runtime_error("expected: function NAME ARGC");
+                }
+                functions.add(
+                    name, argCount,
+                    [name](const std::vector<double>&) -> double {
+                        throw std::runtime_error(name + " cannot be called at build time.");
+                    },
+                    [name](const std::vector<double>&, std::size_t) -> double {
+                        throw std::runtime_error(name + " cannot be differentiated at build time.");
+                    });
+                continue;
+            }
+
+            std::string derivativeOf;
+            bool gradient = false;
+            if (line.rfind("grad ", 0) == 0) {
+                gradient = true;
+                line = trim(line.substr(5));
+            } else if (line.rfind("d/d", 0) == 0) {
+                std::size_t space = line.find(' ');
+                derivativeOf = line.substr(3, space - 3);
+                line = trim(line.substr(space == std::string::npos ? line.size() : space));
+            }
+            std::size_t open = line.find('(');
+            std::size_t close = line.find(')');
+            std::size_t equals = line.find('=');
+            if (open == std::string::npos || close == std::string::npos || equals == std::string::npos ||
+                !(open < close && close < equals)) {
+                throw std::runtime_error("expected: NAME(PARAMETERS) = EXPRESSION");
+            }
+            std::string name = trim(line.substr(0, open));
+            std::vector<std::string> parameters = splitParameters(line.substr(open + 1, close - open - 1));
+            Node* root = Parser(arena, &functions).parse(line.substr(equals + 1));
+            if (gradient) {
+                emitter.addGradient(name, root, parameters, arena);
+            } else if (!derivativeOf.empty()) {
+                emitter.addDerivative(name, root, derivativeOf, parameters, arena);
+            } else {
+                emitter.addFormula(name, root, parameters);
+            }
+        } catch (const std::exception& error) {
+            throw std::runtime_error("line " + std::to_string(lineNumber) + ": " + error.what());
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 4 || argc > 5) {
+        std::cerr << "usage: expr_codegen SPEC HEADER SOURCE [NAMESPACE]\n";
+        return 2;
+    }
+    std::string specPath = argv[1];
+    std::string headerPath = argv[2];
+    std::string sourcePath = argv[3];
+    Trace::setLevel(TraceLevel::Off);
+    try {
+        std::ifstream spec(specPath);
+        if (!spec) {
+            throw std::runtime_error("cannot open " + specPath);
+        }
+        CppEmitter emitter(argc == 5 ? argv[4] : "formulas");
+        compileSpec(spec, emitter);
+
+        std::ofstream header(headerPath, std::ios::trunc);
+        std::ofstream source(sourcePath, std::ios::trunc);
+        if (!header || !source) {
+            throw std::runtime_error("cannot write " + (header ? sourcePath : headerPath));
+        }
+        emitter.writeHeader(header, includeGuard(baseName(headerPath)));
+        emitter.writeSource(source, baseName(headerPath));
+        if (!header.flush() || !source.flush()) {
+            throw std::runtime_error("write failed");
+        }
+    } catch (const std::exception& error) {
+        std::cerr << specPath << ": " << error.what() << "\n";
+        return 1;
+    }
+    return 0;
+}